@@ -2,8 +2,15 @@
 #define CFLEX_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
+#include "cflex_hash.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 // Forward declaration
 struct cf_type_t;
 
@@ -13,6 +20,7 @@ typedef enum cf_kind_t
     CF_KIND_PRIMITIVE,
     CF_KIND_STRUCT,
     CF_KIND_ENUM,
+    CF_KIND_COUNT
 } cf_kind_t;
 
 // Built-in primitive types
@@ -35,29 +43,68 @@ typedef enum cf_prim_t
     CF_PRIM_COUNT
 } cf_prim_t;
 
+// Minimal perfect hash over the names of a struct's fields or an enum's values,
+// generated by cflex_build. A name maps to exactly one candidate entry, which
+// is then confirmed with a single string compare. `seeds` is NULL when the
+// generator did not emit a table, in which case lookups fall back to a scan.
+typedef struct cf_phash_t
+{
+    const uint16_t* seeds;          // One seed per bucket
+    const uint16_t* slots;          // Entry index stored in each slot
+    uint32_t        bucket_mask;    // Bucket count - 1 (a power of two)
+} cf_phash_t;
+
+// cf_field_t.flags
+#define CF_FIELD_BASE 0x1    // The field embeds the parent struct, see cf_type_t.struct_parent
+
 // Struct member information
 typedef struct cf_field_t
 {
-    const char*             name;
-    const struct cf_type_t* type;      // The field type
-    const int32_t           offset;    // offsetof(struct, field)
-    const int32_t           flags;     // For future metadata
+    const char*             name;         // NULL in builds generated with --strip-names
+    const struct cf_type_t* type;         // The field type
+    const int32_t           offset;       // offsetof(struct, field)
+    const int32_t           flags;        // CF_FIELD_* flags
+    uint64_t                name_hash;    // cf_hash_name( name ), 0 if unknown
 } cf_field_t;
 
 // Enum value information
 typedef struct cf_enum_value_t
 {
-    const char* name;
+    const char* name;    // NULL in builds generated with --strip-names
     int32_t     value;
+    uint64_t    name_hash;    // cf_hash_name( name ), 0 if unknown
 } cf_enum_value_t;
 
+// A primitive or enum member of a struct, at any depth of nested struct fields.
+typedef struct cf_leaf_t
+{
+    int32_t                 offset;       // Byte offset from the start of the outermost struct
+    int32_t                 size;         // Size of the member in bytes
+    cf_prim_t               prim;         // Primitive kind; enums report the integer type of their size
+    const struct cf_type_t* type;         // The primitive or enum type
+    const char*             path;         // Dotted path, e.g. "position.x"; NULL with --strip-names
+    uint64_t                path_hash;    // Hash of the field names along the path, also with --strip-names
+} cf_leaf_t;
+
+// Per-process state the registry keeps for each type. Generated types point at
+// a mutable instance of this, since the type descriptors themselves are const.
+typedef struct cf_type_state_t
+{
+    int32_t  index;       // Dense registry index, -1 while not registered; see cf_get_type_index()
+    uint64_t interval;    // Place in the registry's numbering of the struct hierarchy, see cf_type_is_a()
+
+    const struct cf_layout_t* layout;    // Flattened leaves, cached by cf_get_leaves() while registered
+} cf_type_state_t;
+
 // The core reflection type, a discriminated union on "kind"
 typedef struct cf_type_t
 {
-    const char* name;     // Type name (e.g., "int32_t", "player_t")
-    cf_kind_t   kind;     // What kind of type this is
-    int32_t     size;     // sizeof(type)
-    int32_t     align;    // alignof(type)
+    const char*      name;     // Type name (e.g., "int32_t", "player_t"), NULL with --strip-names
+    cf_kind_t        kind;     // What kind of type this is
+    int32_t          size;     // sizeof(type)
+    int32_t          align;    // alignof(type)
+    uint64_t         id;       // Stable type ID: cf_hash_name( name ), emitted as CF_TYPE_ID_<name>
+    cf_type_state_t* state;    // Registry state (dense index), may be NULL for hand-built types
 
     union
     {
@@ -70,10 +117,14 @@ typedef struct cf_type_t
         // CF_KIND_STRUCT
         struct
         {
-            const struct cf_type_t*  struct_parent;
+            const struct cf_type_t*  struct_parent;    // Embedded base struct, or NULL
             const struct cf_field_t* struct_array;
             const int32_t            struct_count;
             const bool               struct_is_anonymous;
+            const cf_phash_t         struct_phash;    // Field name lookup table
+
+            // Generated functions of CF_STRUCT( codegen ) structs, or NULL.
+            const struct cf_struct_funcs_t* struct_funcs;
         };
 
         // CF_KIND_ENUM
@@ -82,34 +133,537 @@ typedef struct cf_type_t
             const struct cf_enum_value_t* enum_array;
             const int32_t                 enum_count;
             const bool                    enum_is_bitflag;
+
+            // Value lookup tables, chosen by cflex_build from the spread of the values.
+            const int32_t   enum_min;           // Smallest value
+            const int32_t   enum_range;         // Dense: max - min + 1, 0 for sparse enums
+            const int16_t*  enum_by_value;      // Dense: entry index of (value - min), -1 if undefined
+            const uint32_t* enum_valid_bits;    // Dense: bit (value - min) set for defined values
+            const uint16_t* enum_sorted;        // Sparse: entry indices in ascending value order
+
+            // Generated name <-> value codecs. Both return an entry index, or -1 if not found.
+            const cf_phash_t enum_phash;    // Value name lookup table
+            int32_t ( *enum_index_of_name )( const char* name, int32_t len );
+            int32_t ( *enum_index_of_value )( int32_t value );
         };
     };
 } cf_type_t;
 
+// --- Primitive Types ---
+
+// The primitive types are defined once by the runtime and are registered with the first
+// lookup, so every module shares a single copy. Generated tables reference them by address.
+extern const cf_type_t cf_type_void;
+extern const cf_type_t cf_type_bool;
+extern const cf_type_t cf_type_char;
+extern const cf_type_t cf_type_i8;
+extern const cf_type_t cf_type_i16;
+extern const cf_type_t cf_type_i32;
+extern const cf_type_t cf_type_i64;
+extern const cf_type_t cf_type_u8;
+extern const cf_type_t cf_type_u16;
+extern const cf_type_t cf_type_u32;
+extern const cf_type_t cf_type_u64;
+extern const cf_type_t cf_type_f32;
+extern const cf_type_t cf_type_f64;
+extern const cf_type_t cf_type_cstr;
+
+// Stable IDs of the primitive types, i.e. cf_hash_name() of their C type names.
+#define CF_TYPE_ID_void 0x3173c900e37ae1dfull
+#define CF_TYPE_ID_bool 0xcd2fd49bc6b014bdull
+#define CF_TYPE_ID_char 0xf2a393910b5b3ebdull
+#define CF_TYPE_ID_i8   0xf039af6dfbabfed9ull
+#define CF_TYPE_ID_i16  0xcc9e582b957a7bbaull
+#define CF_TYPE_ID_i32  0xb6a8d81c22be419cull
+#define CF_TYPE_ID_i64  0xcb7321f291bc2f2full
+#define CF_TYPE_ID_u8   0xd03d8582534ea008ull
+#define CF_TYPE_ID_u16  0x0d577d2963a97459ull
+#define CF_TYPE_ID_u32  0x32882d3b22f6b347ull
+#define CF_TYPE_ID_u64  0x40eb7764c80bc470ull
+#define CF_TYPE_ID_f32  0xa00a62a942b20165ull
+#define CF_TYPE_ID_f64  0xa0880a9ce131dea8ull
+#define CF_TYPE_ID_cstr 0x547714f5af8a9a36ull
+
+// The descriptor of a reflected type by name, e.g. CF_TYPE( player_t ) or CF_TYPE( i32 ),
+// so a misspelled name is a compile error rather than a NULL from cf_find_type_by_name().
+// Packed modules have no descriptor variables, so there it is a lookup by stable ID.
+#if defined( CFLEX_PACKED )
+#    define CF_TYPE( name ) cf_find_type_by_id( CF_TYPE_ID_##name )
+#else
+#    define CF_TYPE( name ) ( &cf_type_##name )
+#endif
+
+// _Generic associations for the primitive types, used by the generated
+// <module>_type_of( expr ) macros. There is no default, so other types fail to compile.
+// clang-format off
+#define CF_PRIMITIVE_TYPE_ASSOCIATIONS \
+    bool        : &cf_type_bool,       \
+    char        : &cf_type_char,       \
+    int8_t      : &cf_type_i8,         \
+    int16_t     : &cf_type_i16,        \
+    int32_t     : &cf_type_i32,        \
+    int64_t     : &cf_type_i64,        \
+    uint8_t     : &cf_type_u8,         \
+    uint16_t    : &cf_type_u16,        \
+    uint32_t    : &cf_type_u32,        \
+    uint64_t    : &cf_type_u64,        \
+    float       : &cf_type_f32,        \
+    double      : &cf_type_f64,        \
+    char*       : &cf_type_cstr,       \
+    const char* : &cf_type_cstr
+// clang-format on
+
+// Iterates over a set of registered types; see cf_iter_types_by_kind().
+typedef struct cf_type_iter_t
+{
+    const void*    snapshot;    // Registry snapshot held by the iterator, NULL once ended
+    const int32_t* indices;     // Dense indices of the types to visit
+    int32_t        count;
+    int32_t        position;
+} cf_type_iter_t;
+
 // --- Library API ---
 
-// Initializes the reflection system. Must be called before any other API functions.
+// Modules generated with `cflex_build --strip-names` carry no name strings, only name
+// hashes. Name lookups then hash the query and compare hashes, and the `name` members of
+// types, fields and enum values are NULL. cflex_build writes a <module>_generated.names
+// sidecar file that maps the hashes back to names for tools and debug output.
+
+// The registry is safe to use from any number of threads. Lookups never block: they read
+// an immutable snapshot that writers (register/unregister) replace and reclaim once no
+// reader can still see it. Modules may be registered and unregistered at any time, e.g.
+// when plugins are loaded and unloaded, and there is no limit on the number of tables.
+
+// Initializes the reflection system. The registry is statically initialized, so this is
+// optional; it is kept for symmetry with cf_shutdown(). When the runtime and the generated
+// modules are built with linker sections (CFLEX_LINKER_SECTIONS), modules need no
+// <module>_register_types() call either.
 void cf_initialize(void);
 
-// Shuts down the reflection system and frees any allocated resources.
+// Unregisters every type table and frees any allocated resources. Must not be called
+// while other threads are still using the registry.
 void cf_shutdown(void);
 
 // Find a type by its name (e.g., "player_t").
 const cf_type_t* cf_find_type_by_name( const char* name );
 
+// Find a type by the first `len` characters of `name`. The name does not need to be
+// NUL-terminated, so parsers can look up identifiers directly from an input buffer.
+const cf_type_t* cf_find_type_by_name_n( const char* name, int32_t len );
+
+// Find a type by its stable ID (e.g., CF_TYPE_ID_player_t). IDs are name hashes, so they
+// can be persisted or sent over the wire as an 8-byte type tag.
+const cf_type_t* cf_find_type_by_id( uint64_t id );
+
+// Gets the upper bound of the dense type indices. Indices run from 0 to this count - 1,
+// so per-type dispatch tables can be plain arrays indexed by cf_get_type_index().
+// Types registered later take the indices of unregistered ones first, so the count stays
+// within the most types registered at once; per-type data kept by index must be reset when
+// a type is unregistered.
+int32_t cf_get_num_types( void );
+
+// Gets the dense index of a registered type, or -1. The registry updates type->state->index
+// while other threads read it, so this loads it atomically; it never takes a read section.
+int32_t cf_get_type_index( const cf_type_t* type );
+
+// Gets a registered type by its dense index, or NULL if no registered type holds it.
+const cf_type_t* cf_get_type_by_index( int32_t index );
+
 // Gets the number of registered type tables.
 int32_t cf_get_num_tables(void);
 
 // Gets a specific type table by its index.
 void cf_get_table( int32_t table_index, const cf_type_t*** out_types, int32_t* out_count );
 
+// The registry keeps two secondary indexes, rebuilt whenever a table is registered or
+// unregistered: the types of each kind, and for each type the structs that contain it,
+// directly or through nested struct fields. Iterating over either costs time proportional
+// to the number of types visited.
+//
+//     cf_type_iter_t it;
+//     cf_iter_containers( &it, vec3_type );
+//     for ( const cf_type_t* type; ( type = cf_iter_next( &it ) ); ) { ... }
+//
+// An iterator holds on to the registry state it started with until cf_iter_next() returns
+// NULL; an iterator that is abandoned early must be released with cf_iter_end(), on the
+// same thread. Meanwhile, registrations on other threads wait for it before they return,
+// so a thread must not wait for such a registration while it iterates. A registration on
+// the iterating thread itself returns at once, but the old registry state it replaced is
+// only freed by a later registration made outside any iteration.
+
+// Starts iterating over the registered types of the given kind, in dense index order.
+void cf_iter_types_by_kind( cf_type_iter_t* it, cf_kind_t kind );
+
+// Starts iterating over the registered structs that contain `type` as a field, directly
+// or nested inside other struct fields. Each struct is visited once.
+void cf_iter_containers( cf_type_iter_t* it, const cf_type_t* type );
+
+// Returns the next type of an iteration, or NULL (and ends the iteration) when done.
+const cf_type_t* cf_iter_next( cf_type_iter_t* it );
+
+// Ends an iteration early. Calling it on an iterator that has already ended does nothing.
+void cf_iter_end( cf_type_iter_t* it );
+
+// Returns true if `type` is `base` or derives from it. A struct derives from the struct
+// it embeds as its first member when that member is annotated with CF_FIELD( base ).
+// Registered types carry their place in the registry's numbering of the hierarchy, so the
+// check is two loads and two compares without entering the registry. Types the registry
+// has not numbered (types without state, types that are not registered, or a numbering
+// that a registration is still storing) walk the struct_parent chain instead.
+bool cf_type_is_a( const cf_type_t* type, const cf_type_t* base );
+
+// Gets the primitive and enum members of a struct as one flat array, in declaration order
+// with nested struct fields expanded in place. The array is built on first use and cached
+// until the struct is unregistered, so bulk operations can loop over it instead of recursing
+// through the field types. Returns NULL (and a count of 0) for types that are not structs,
+// types without registry state, structs that are not registered, and structs with a field
+// whose type is not registered yet.
+const cf_leaf_t* cf_get_leaves( const cf_type_t* type, int32_t* out_count );
+
 // For a given struct type, find a field by its name.
 const cf_field_t* cf_find_field( const cf_type_t* type, const char* name );
 
+// For a given struct type, find a field by the first `len` characters of its name.
+const cf_field_t* cf_find_field_n( const cf_type_t* type, const char* name, int32_t len );
+
 // For a given enum type, find a value by its name.
 const cf_enum_value_t* cf_find_enum_value_by_name( const cf_type_t* type, const char* name );
 
+// For a given enum type, find a value by the first `len` characters of its name.
+const cf_enum_value_t* cf_find_enum_value_by_name_n( const cf_type_t* type, const char* name, int32_t len );
+
 // For a given enum type, find a value by its integer value.
 const cf_enum_value_t* cf_find_enum_value_by_value( const cf_type_t* type, int32_t value );
 
+// Returns true if `value` is defined by the given enum type.
+// For dense enums this is a single bitmap load, suitable for validating untrusted input.
+bool cf_enum_is_valid( const cf_type_t* type, int32_t value );
+
+// --- Field Paths ---
+
+// A dotted field path such as "position.x", resolved once to the absolute offset of its
+// last field. Reading or writing through a compiled path is one add and one load or store,
+// so paths are meant to be compiled outside of per-object loops.
+typedef struct cf_path_t
+{
+    int32_t          offset;    // Byte offset from the start of the outermost struct
+    const cf_type_t* type;      // Type of the last field, NULL if the path did not resolve
+} cf_path_t;
+
+// Resolves `path` against a struct type. Each '.' separated component must name a field of
+// the struct the previous component resolved to. On failure the returned path has a NULL
+// type. Compiled paths stay valid for as long as the type descriptors they were built from.
+cf_path_t cf_path_compile( const cf_type_t* type, const char* path );
+
+// Copies the field `path` refers to out of `count` structs spaced `stride` bytes apart,
+// starting at `objects`, into the packed array `out` (path->type->size bytes per struct).
+void cf_path_gather( const cf_path_t* path, const void* objects, size_t stride, int32_t count, void* out );
+
+// Copies `count` packed values from `in` into the field `path` refers to, for `count`
+// structs spaced `stride` bytes apart. The reverse of cf_path_gather().
+void cf_path_scatter( const cf_path_t* path, void* objects, size_t stride, int32_t count, const void* in );
+
+// Typed accessors: cf_path_get_<prim>( path, object ) and cf_path_set_<prim>( path, object,
+// value ). They do not check the path's type; compare path->type once when compiling it.
+#define CF_PATH_ACCESSORS( prim, c_type )                                                      \
+    static inline c_type cf_path_get_##prim( const cf_path_t* path, const void* object )       \
+    {                                                                                          \
+        return *(c_type const*)( (const char*)object + path->offset );                         \
+    }                                                                                          \
+    static inline void cf_path_set_##prim( const cf_path_t* path, void* object, c_type value ) \
+    {                                                                                          \
+        *(c_type*)( (char*)object + path->offset ) = value;                                    \
+    }
+
+CF_PATH_ACCESSORS( bool, bool )
+CF_PATH_ACCESSORS( char, char )
+CF_PATH_ACCESSORS( i8, int8_t )
+CF_PATH_ACCESSORS( i16, int16_t )
+CF_PATH_ACCESSORS( i32, int32_t )
+CF_PATH_ACCESSORS( i64, int64_t )
+CF_PATH_ACCESSORS( u8, uint8_t )
+CF_PATH_ACCESSORS( u16, uint16_t )
+CF_PATH_ACCESSORS( u32, uint32_t )
+CF_PATH_ACCESSORS( u64, uint64_t )
+CF_PATH_ACCESSORS( f32, float )
+CF_PATH_ACCESSORS( f64, double )
+CF_PATH_ACCESSORS( cstr, const char* )
+
+// --- Serialization ---
+
+// Writes `count` consecutive objects of `type` to `buffer`: the primitive and enum members
+// of each object in declaration order, in native byte order and without padding. Strings
+// are a uint32_t length, the characters and a NUL, or just 0xffffffff for NULL. Each type
+// is compiled once into a copy plan of merged memcpy steps, so a struct without padding or
+// strings is copied as one block. Returns the number of bytes written, or 0 if the buffer
+// is too small or the type cannot be serialized. With a NULL buffer, returns the size needed.
+size_t cf_serialize(
+    const cf_type_t* type, const void* objects, int32_t count, void* buffer, size_t buffer_size );
+
+// Reads `count` objects written by cf_serialize() with the same type. Padding is left
+// untouched. Strings point into `buffer`, which must outlive the objects. Returns the
+// number of bytes read, or 0 if the data is truncated.
+size_t cf_deserialize(
+    const cf_type_t* type, void* objects, int32_t count, const void* buffer, size_t buffer_size );
+
+// Hashes the primitive and enum members of an object, in declaration order, and the
+// characters of its strings. Values are hashed bitwise, so 0.0 and -0.0 differ, as they do
+// for cf_objects_equal(). Hashes depend on the platform's byte order and type sizes.
+// Returns 0 for types that cannot be serialized.
+uint64_t cf_hash_object( const cf_type_t* type, const void* object );
+
+// Compares the primitive and enum members of two objects bitwise and their strings by
+// content. Padding is ignored. Returns false for types that cannot be serialized.
+bool cf_objects_equal( const cf_type_t* type, const void* a, const void* b );
+
+// Straight-line versions of the functions above for one struct. cflex_build generates them
+// for structs annotated CF_STRUCT( codegen ), or for all structs with --codegen, and the
+// generic functions dispatch to them through cf_type_t.struct_funcs. The generated header
+// declares typed <type>_write(), <type>_read(), <type>_hash() and <type>_equal() as well.
+// `write` returns the size needed when `buffer` is NULL.
+typedef struct cf_struct_funcs_t
+{
+    size_t ( *write )( const void* object, void* buffer, size_t buffer_size );
+    size_t ( *read )( void* object, const void* buffer, size_t buffer_size );
+    uint64_t ( *hash )( const void* object );
+    bool ( *equal )( const void* a, const void* b );
+} cf_struct_funcs_t;
+
+// --- JSON ---
+
+// Receives a full buffer of JSON text, or the rest of it from cf_json_writer_flush().
+// Returns false to stop the writer.
+typedef bool ( *cf_json_flush_t )( void* user, const char* data, size_t size );
+
+// Streams JSON text into a caller-provided buffer. Without a flush callback the document
+// must fit the buffer; with one, the buffer is handed over each time it fills up, so
+// documents of any size are written without allocating.
+typedef struct cf_json_writer_t
+{
+    char*           buffer;
+    size_t          capacity;
+    size_t          used;     // Bytes in `buffer` not flushed yet
+    size_t          total;    // Bytes written, including flushed ones
+    cf_json_flush_t flush;    // NULL to fail once the buffer is full
+    void*           user;
+    bool            failed;    // Out of space, a flush failed or a value could not be written
+} cf_json_writer_t;
+
+void cf_json_writer_init(
+    cf_json_writer_t* writer, char* buffer, size_t capacity, cf_json_flush_t flush, void* user );
+
+// Writes one object of `type`, without whitespace. Structs become objects with their fields
+// in declaration order, enums the name of their value (or the number, if it has none),
+// strings escaped strings or null, and floats that are not finite null. Structs without
+// field names (--strip-names) cannot be written. Returns false once the writer has failed.
+bool cf_json_write( cf_json_writer_t* writer, const cf_type_t* type, const void* object );
+
+// Writes `count` consecutive objects of `type` as a JSON array.
+bool cf_json_write_array( cf_json_writer_t* writer,
+                          const cf_type_t*  type,
+                          const void*       objects,
+                          int32_t           count );
+
+// Hands the buffered text to the flush callback, if there is one.
+bool cf_json_writer_flush( cf_json_writer_t* writer );
+
+// Parses JSON text into objects. Strings are decoded into a caller-provided buffer, so
+// reading allocates nothing either. Values are read one after another from `pos`.
+typedef struct cf_json_reader_t
+{
+    const char* json;
+    size_t      length;
+    size_t      pos;        // Offset of the next character to read
+    char*       strings;    // Storage for decoded string fields, may be NULL
+    size_t      strings_capacity;
+    size_t      strings_used;
+    const char* error;    // Set on failure, with `pos` at the offending character
+} cf_json_reader_t;
+
+void cf_json_reader_init(
+    cf_json_reader_t* reader, const char* json, size_t length, char* strings, size_t strings_capacity );
+
+// Reads one value into `object`. Struct fields are matched by name in any order; unknown
+// fields are skipped and missing ones keep their values. Enums take a name or a number,
+// floats take null as NaN, and integers must fit their type. Returns false on failure.
+bool cf_json_read( cf_json_reader_t* reader, const cf_type_t* type, void* object );
+
+// Reads a JSON array of up to `capacity` objects. Returns the number read, or -1 on failure.
+int32_t cf_json_read_array( cf_json_reader_t* reader,
+                            const cf_type_t*  type,
+                            void*             objects,
+                            int32_t           capacity );
+
+// --- Images ---
+
+// Images hold arrays of reflected objects in their in-memory layout, so they can be used
+// straight from a memory-mapped file. An image describes each array (a section) by its
+// type: name, ID, size, alignment and flattened leaves. Sections start on 64-byte
+// boundaries; strings follow in a string section, and string fields hold their offset in
+// it until the image is opened.
+//
+//     size_t size  = cf_image_write( sections, 2, NULL, 0 );
+//     ...
+//     cf_image_t image;
+//     if ( cf_image_open( &image, mapping, mapped_size ) )
+//     {
+//         int32_t            count;
+//         const particle_t*  particles = cf_image_get_section( &image, 0, particle_type, &count );
+//     }
+//
+// Images use the byte order and pointer size of the process that wrote them.
+
+// One array of objects to write into an image.
+typedef struct cf_image_section_t
+{
+    const cf_type_t* type;
+    const void*      objects;
+    int32_t          count;
+} cf_image_section_t;
+
+// Writes the sections into `buffer` as one image. Returns the size of the image, or 0 if
+// the buffer is too small or a type has no layout. With a NULL buffer, returns the size
+// needed. The buffer must be aligned for the types it holds; padding is written as zeros.
+size_t cf_image_write( const cf_image_section_t* sections,
+                       int32_t                   num_sections,
+                       void*                     buffer,
+                       size_t                    buffer_size );
+
+// An opened image. `data` is the memory it was opened from.
+typedef struct cf_image_t
+{
+    uint8_t* data;
+    size_t   size;
+    int32_t  num_sections;
+} cf_image_t;
+
+// Checks an image and points its string fields into its string section. Only images with
+// string fields are written to, and only their string slots, so a file without strings
+// can be mapped read-only; one with strings needs a writable, private mapping (MAP_PRIVATE,
+// FILE_MAP_COPY). Opening the same memory again is cheap. Returns false if the image is
+// malformed, truncated, or was written with another byte order or pointer size.
+bool cf_image_open( cf_image_t* image, void* data, size_t size );
+
+// Returns the index of the first section of `type`, by type ID, or -1.
+int32_t cf_image_find_section( const cf_image_t* image, const cf_type_t* type );
+
+// Returns the objects of a section, in place, if the section was written with the layout
+// `type` has now: same ID, size, alignment and leaves (paths, offsets, sizes, primitives).
+// Returns NULL otherwise, or if the memory is not aligned for the type.
+const void* cf_image_get_section( const cf_image_t* image,
+                                  int32_t           index,
+                                  const cf_type_t*  type,
+                                  int32_t*          out_count );
+
+// --- Migration ---
+
+// Returns a 64-bit fingerprint of the layout of a type: its size and the path, offset, size
+// and primitive of each leaf. Types with equal fingerprints can be copied into each other
+// with memcpy. Cached with the leaves of registered structs. Returns 0 for types without a
+// layout (void, structs with unresolved fields).
+uint64_t cf_get_fingerprint( const cf_type_t* type );
+
+// A compiled conversion from one version of a struct to another, e.g. data saved by an older
+// build to the layout of the current one. Leaves are matched by path, so fields may move,
+// be reordered, added or removed:
+//
+//   - leaves of the same primitive are copied, adjacent ones in a single run
+//   - integers are widened to larger integers, and to floats and doubles that hold them
+//     exactly; floats to doubles
+//   - other leaves of the new type keep their default value
+//
+// Enums convert as the integers they are stored as, and strings are copied as pointers.
+typedef struct cf_migration_t cf_migration_t;
+
+// Compiles the conversion from `old_type` to `new_type`. `defaults` is an object of
+// `new_type` that supplies the unmatched leaves (and padding); NULL uses zeros. Returns NULL
+// if either type has no layout or on allocation failure. Free with cf_migration_free().
+cf_migration_t* cf_migration_compile( const cf_type_t* old_type,
+                                      const cf_type_t* new_type,
+                                      const void*      defaults );
+
+// Converts `count` objects. Types with the same fingerprint are one memcpy; others run each
+// step over a block of objects at a time. The arrays must not overlap.
+bool cf_migrate( const cf_migration_t* migration, const void* old_objects, void* new_objects, int32_t count );
+
+// Returns true if the migration is a plain copy: both types have the same fingerprint.
+bool cf_migration_is_copy( const cf_migration_t* migration );
+
+void cf_migration_free( cf_migration_t* migration );
+
+// --- Byte Order ---
+
+// Byte order of the multi-byte values written by cf_encode().
+typedef enum cf_byte_order_t
+{
+    CF_BYTE_ORDER_LITTLE,
+    CF_BYTE_ORDER_BIG,
+} cf_byte_order_t;
+
+cf_byte_order_t cf_host_byte_order( void );
+
+// Writes `count` objects in the cf_serialize() format, but with every multi-byte value in
+// `order`, string length prefixes included. Each leaf is swapped by the size of its
+// primitive; floats and doubles as their IEEE bits. When `order` is the host's, this is
+// cf_serialize(). Otherwise the records are swapped in place after writing, with one byte
+// shuffle per 16 bytes of a record when the runtime is built for SSSE3 or AVX2. Returns
+// what cf_serialize() returns.
+size_t cf_encode( const cf_type_t* type,
+                  const void*      objects,
+                  int32_t          count,
+                  cf_byte_order_t  order,
+                  void*            buffer,
+                  size_t           buffer_size );
+
+// Reads `count` objects written by cf_encode() with the same type and order. Strings point
+// into `buffer` as for cf_deserialize(). Returns what cf_deserialize() returns.
+size_t cf_decode( const cf_type_t* type,
+                  void*            objects,
+                  int32_t          count,
+                  cf_byte_order_t  order,
+                  const void*      buffer,
+                  size_t           buffer_size );
+
+// --- Statistics ---
+
+// Lookup paths counted when the runtime is built with CFLEX_STATS.
+typedef enum cf_stat_lookup_t
+{
+    CF_STAT_TYPE_BY_NAME,     // cf_find_type_by_name(), cf_find_type_by_name_n()
+    CF_STAT_TYPE_BY_ID,       // cf_find_type_by_id()
+    CF_STAT_FIELD,            // cf_find_field(), cf_find_field_n(), cf_path_compile()
+    CF_STAT_ENUM_BY_NAME,     // cf_find_enum_value_by_name(), cf_find_enum_value_by_name_n()
+    CF_STAT_ENUM_BY_VALUE,    // cf_find_enum_value_by_value()
+    CF_STAT_LOOKUP_COUNT
+} cf_stat_lookup_t;
+
+typedef struct cf_stat_counters_t
+{
+    uint64_t calls;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t probes;    // Index slots or entries compared, 1 for perfect hashes and direct tables
+} cf_stat_counters_t;
+
+typedef struct cf_stats_t
+{
+    cf_stat_counters_t lookups[ CF_STAT_LOOKUP_COUNT ];
+} cf_stats_t;
+
+// Sums the lookup counters of all threads into `out`; all zero without CFLEX_STATS. Each
+// thread counts its own lookups without synchronization, so totals taken while other
+// threads are looking types up are approximate.
+void cf_stats_snapshot( cf_stats_t* out );
+
+// Zeroes the counters of all threads. Counts from lookups in flight may be lost.
+void cf_stats_reset( void );
+
+// Prints the totals of cf_stats_snapshot() to stdout, one line per lookup path, with the
+// average number of probes per call.
+void cf_stats_dump( void );
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif    // CFLEX_H
@@ -0,0 +1,98 @@
+#ifndef CFLEX_HPP
+#define CFLEX_HPP
+
+/*==============================================================================================
+
+    C++ Bindings
+
+    Compile-time reflection of cflex types for C++17. `cflex_build --emit-cpp` writes a
+    <module>_generated.hpp that specializes cf::type_desc<T> for every struct and enum of
+    the module; this header holds the primary template, the primitive specializations and
+    the algorithms built on them. Only type_of() reaches the runtime descriptors.
+
+==============================================================================================*/
+
+#include "cflex.h"
+
+#include <type_traits>
+
+namespace cf {
+
+// A struct member known at compile time.
+template <typename Class, typename Member>
+struct field_t
+{
+    using class_type  = Class;
+    using member_type = Member;
+
+    const char* name;    // nullptr with --strip-names
+    Member Class::*member;
+    int32_t        index;        // Declaration order, as in cf_type_t.struct_array
+    uint64_t       name_hash;    // cf_hash_name( name )
+};
+
+// Compile-time descriptor of a reflected type. Using it with a type that is not reflected
+// fails to compile. Every specialization has:
+//
+//     name, id, kind, size, align     as in cf_type_t
+//     type()                          the runtime cf_type_t
+//
+// Structs add `field_count`, `parent` (the CF_FIELD( base ) struct, or void) and
+// `visit_fields( visitor )`, which calls visitor( field ) with a field_t per field.
+// Enums add `value_count`.
+template <typename T>
+struct type_desc;
+
+// The runtime descriptor of a reflected type. A constant expression, unless the module was
+// generated with --packed; then it is a lookup by stable ID.
+template <typename T>
+constexpr const cf_type_t*
+type_of()
+{
+    return type_desc<std::remove_cv_t<T>>::type();
+}
+
+// Calls visitor( field, obj.*field.member ) for each field of a reflected struct, in
+// declaration order. The calls are expanded at compile time; there is no loop over metadata.
+template <typename T, typename Visitor>
+constexpr void
+for_each_field( T& obj, Visitor&& visitor )
+{
+    type_desc<std::remove_cv_t<T>>::visit_fields(
+        [ & ]( const auto& field ) { visitor( field, obj.*( field.member ) ); } );
+}
+
+// clang-format off
+#define CF_CPP_PRIMITIVE( cf_name, c_name )                                                   \
+    template <>                                                                               \
+    struct type_desc<c_name>                                                                  \
+    {                                                                                         \
+        static constexpr const char* name  = #c_name;                                         \
+        static constexpr uint64_t    id    = CF_TYPE_ID_##cf_name;                            \
+        static constexpr cf_kind_t   kind  = CF_KIND_PRIMITIVE;                               \
+        static constexpr int32_t     size  = sizeof( c_name );                                \
+        static constexpr int32_t     align = alignof( c_name );                               \
+                                                                                              \
+        static constexpr const cf_type_t* type() { return &cf_type_##cf_name; }               \
+    };
+
+CF_CPP_PRIMITIVE( bool, bool        )
+CF_CPP_PRIMITIVE( char, char        )
+CF_CPP_PRIMITIVE( i8,   int8_t      )
+CF_CPP_PRIMITIVE( i16,  int16_t     )
+CF_CPP_PRIMITIVE( i32,  int32_t     )
+CF_CPP_PRIMITIVE( i64,  int64_t     )
+CF_CPP_PRIMITIVE( u8,   uint8_t     )
+CF_CPP_PRIMITIVE( u16,  uint16_t    )
+CF_CPP_PRIMITIVE( u32,  uint32_t    )
+CF_CPP_PRIMITIVE( u64,  uint64_t    )
+CF_CPP_PRIMITIVE( f32,  float       )
+CF_CPP_PRIMITIVE( f64,  double      )
+CF_CPP_PRIMITIVE( cstr, const char* )
+// clang-format on
+
+#undef CF_CPP_PRIMITIVE
+
+}    // namespace cf
+
+#endif    // CFLEX_HPP
@@ -0,0 +1,74 @@
+#ifndef CFLEX_HASH_H
+#define CFLEX_HASH_H
+
+#include <stdint.h>
+
+// Name hashing shared by the cflex runtime and the cflex_build tool.
+// Both sides must produce identical values, so keep these dependency free.
+
+#define CF_HASH_OFFSET_BASIS 0xcbf29ce484222325ull
+#define CF_HASH_PRIME        0x00000100000001b3ull
+
+// 64-bit FNV-1a hash of the first `len` bytes of `name`.
+static inline uint64_t
+cf_hash_name_n( const char* name, int32_t len )
+{
+    uint64_t hash = CF_HASH_OFFSET_BASIS;
+    for ( int32_t i = 0; i < len; ++i )
+    {
+        hash ^= (uint8_t)name[ i ];
+        hash *= CF_HASH_PRIME;
+    }
+    return hash;
+}
+
+// 64-bit FNV-1a hash of a NUL-terminated name.
+static inline uint64_t
+cf_hash_name( const char* name )
+{
+    uint64_t hash = CF_HASH_OFFSET_BASIS;
+    while ( *name )
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= CF_HASH_PRIME;
+    }
+    return hash;
+}
+
+// Perfect hash tables generated by cflex_build use a two-level "hash and displace"
+// scheme: a mix of the name hash selects a bucket, and the bucket's seed mixes the
+// hash into a slot. The generator searches for seeds that leave every slot with
+// exactly one entry.
+
+// Number of buckets in the table over `count` names: a power of two near count / 2.
+static inline uint32_t
+cf_phash_num_buckets( uint32_t count )
+{
+    uint32_t num_buckets = 1;
+    while ( num_buckets < ( count + 1 ) / 2 ) { num_buckets <<= 1; }
+    return num_buckets;
+}
+
+// Selects the bucket for a name hash. FNV-1a leaves the upper bits poorly mixed
+// for names that differ only in their last characters, so finalize first.
+static inline uint32_t
+cf_phash_bucket( uint64_t hash, uint32_t bucket_mask )
+{
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return (uint32_t)hash & bucket_mask;
+}
+
+// Maps a name hash and a bucket seed to a slot in [0, count).
+static inline uint32_t
+cf_phash_slot( uint64_t hash, uint32_t seed, uint32_t count )
+{
+    uint64_t h = hash ^ ( (uint64_t)seed * 0x9e3779b97f4a7c15ull );
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 32;
+    return (uint32_t)( ( ( h & 0xffffffffull ) * count ) >> 32 );
+}
+
+#endif    // CFLEX_HASH_H
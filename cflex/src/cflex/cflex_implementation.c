@@ -2,123 +2,4708 @@
 #define CFLEX_IMPLEMENTATION_H
 
 #include "internal/cflex_internal.h"
+#include "internal/cflex_platform.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <locale.h>
 
 // --- Internal State ---
+//
+// The registry is published as immutable snapshots. Readers load the current
+// snapshot without taking a lock. Writers serialize on a spin lock, build a new
+// snapshot, publish it with a single pointer store and free the old one once no
+// reader can still be using it (epoch-based reclamation). Registration and
+// unregistration are rare, so rebuilding a snapshot per write is cheap overall.
 
-#define MAX_TYPE_TABLES 16
+typedef struct cf_type_table_t
+{
+    const cf_type_t** types;
+    int32_t           count;
+} cf_type_table_t;
+
+// A slot in the open-addressing type index. An empty slot has a NULL type.
+typedef struct cf_index_slot_t
+{
+    uint64_t         hash;    // Type ID, i.e. cf_hash_name() of type->name
+    const cf_type_t* type;
+    int32_t          dense;    // Position of the type in cf_snapshot_t.types
+} cf_index_slot_t;
+
+#define CF_INDEX_MIN_CAPACITY 64
+
+// Secondary indexes of a snapshot, as rows of dense indices. Built once the field types
+// of the snapshot are resolved, and allocated as a single block.
+typedef struct cf_relations_t
+{
+    int32_t  kind_start[ CF_KIND_COUNT + 1 ];    // Row of each kind in kind_types
+    int32_t* kind_types;                         // Registered types grouped by kind
+    int32_t* container_start;                    // Row of each dense index in containers
+    int32_t* containers;                         // Structs that contain a type, transitively
+} cf_relations_t;
+
+// An immutable view of the registry. Allocated as a single block.
+typedef struct cf_snapshot_t
+{
+    cf_type_table_t* tables;
+    int32_t          num_tables;
+
+    // Unified hash index over the types of all registered tables.
+    // Capacity is a power of two and probing is linear.
+    cf_index_slot_t* index;
+    uint32_t         index_mask;
+
+    // Unique types; a type's position is its dense index. Unregistered types leave NULL
+    // holes, which the next types registered fill.
+    const cf_type_t** types;
+    int32_t           num_types;
+
+    // Other definitions of registered types that carry state. They share the index of the
+    // first definition and are listed so that it can be reset once they are unregistered.
+    const cf_type_t** dups;
+    int32_t           num_dups;
+
+    cf_relations_t*       relations;    // NULL if building them failed
+    struct cf_snapshot_t* next_retired;
+} cf_snapshot_t;
+
+// Per-thread reader record. A thread claims a record on its first lookup, taking one that
+// an exited thread released or pushing a new one onto the registry's list. Records stay on
+// the list until cf_shutdown() frees them.
+typedef struct cf_reader_t
+{
+    volatile uint32_t   epoch;      // Epoch observed on entry, CF_EPOCH_IDLE outside read sections
+    volatile uint32_t   claimed;    // 1 while a thread owns the record
+    int32_t             depth;      // Nesting depth of read sections (owner thread only)
+    struct cf_reader_t* next;
+#if defined( CFLEX_STATS )
+    cf_stats_t stats;    // Lookup counters of the owner threads (written by the owner only)
+#endif
+} cf_reader_t;
+
+#define CF_EPOCH_IDLE 0u
+
+typedef struct cf_registry_t
+{
+    cf_snapshot_t* volatile snapshot;    // Current snapshot, NULL while empty
+    cf_reader_t* volatile readers;
+    volatile uint32_t         epoch;
+    volatile uint32_t         generation;          // Bumped by cf_shutdown(), which frees the reader records
+    volatile uint32_t         reader_key_state;    // See cf_reader_key_ready()
+    cf_thread_key_t           reader_key;          // Releases a thread's reader record when it exits
+    cf_spin_lock_t            write_lock;
+    uint32_t                  numbering;          // Generation of the last hierarchy numbering (writer only)
+    cf_snapshot_t*            retired;            // Snapshots waiting to be freed (writer only)
+    volatile uint32_t         builtins_loaded;    // Primitive and linker section tables have been registered
+    struct cf_packed_entry_t* packed;             // Materialized packed modules (writer only)
+} cf_registry_t;
+
+static cf_registry_t                g_registry          = { NULL, NULL, 1, 0, 0, 0, { 0 }, 0, NULL, 0, NULL };
+static CF_THREAD_LOCAL cf_reader_t* t_reader            = NULL;
+static CF_THREAD_LOCAL uint32_t     t_reader_generation = 0;    // Registry generation t_reader belongs to
+
+// --- Read Sections ---
+
+static void cf_load_builtin_tables( void );
+
+// Returns the calling thread's reader record, or NULL if it has none, including a record
+// that cf_shutdown() has freed since.
+static cf_reader_t*
+cf_reader_current( void )
+{
+    cf_reader_t* reader = t_reader;
+    return reader && t_reader_generation == cf_atomic_load_u32( &g_registry.generation ) ? reader : NULL;
+}
+
+// Hands the record of an exiting thread back to the list for the next new thread. Its
+// statistics stay with the record.
+static void CF_THREAD_CALLBACK
+cf_reader_release( void* value )
+{
+    cf_reader_t* reader = cf_reader_current();
+    if ( reader && reader == value )
+    {
+        t_reader      = NULL;
+        reader->depth = 0;
+        cf_atomic_store_u32( &reader->epoch, CF_EPOCH_IDLE );
+        cf_atomic_store_u32( &reader->claimed, 0 );
+    }
+}
+
+#define CF_KEY_NONE     0u
+#define CF_KEY_CREATING 1u
+#define CF_KEY_READY    2u
+#define CF_KEY_FAILED   3u
+
+// Creates the key that releases reader records at thread exit, once per process. Without
+// it, the records of exited threads are not reused.
+static bool
+cf_reader_key_ready( void )
+{
+    uint32_t state = cf_atomic_load_u32( &g_registry.reader_key_state );
+    if ( state == CF_KEY_NONE &&
+         cf_atomic_cas_u32( &g_registry.reader_key_state, CF_KEY_NONE, CF_KEY_CREATING ) )
+    {
+        bool created = cf_thread_key_create( &g_registry.reader_key, cf_reader_release );
+        cf_atomic_store_u32( &g_registry.reader_key_state, created ? CF_KEY_READY : CF_KEY_FAILED );
+    }
+    while ( ( state = cf_atomic_load_u32( &g_registry.reader_key_state ) ) == CF_KEY_CREATING )
+    {
+        cf_thread_yield();
+    }
+    return state == CF_KEY_READY;
+}
+
+// Returns the calling thread's reader record, claiming one on first use. NULL on
+// allocation failure.
+static cf_reader_t*
+cf_reader_local( void )
+{
+    cf_reader_t* reader = cf_reader_current();
+    if ( reader )
+    {
+        return reader;
+    }
+
+    uint32_t generation = cf_atomic_load_u32( &g_registry.generation );
+    reader              = (cf_reader_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.readers );
+    for ( ; reader; reader = reader->next )
+    {
+        if ( !cf_atomic_load_u32( &reader->claimed ) && cf_atomic_cas_u32( &reader->claimed, 0, 1 ) )
+        {
+            break;
+        }
+    }
+    if ( !reader )
+    {
+        reader = (cf_reader_t*)calloc( 1, sizeof( cf_reader_t ) );
+        if ( !reader )
+        {
+            return NULL;
+        }
+        reader->claimed = 1;
+
+        cf_reader_t* head;
+        do {
+            head         = (cf_reader_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.readers );
+            reader->next = head;
+        }
+        while ( !cf_atomic_cas_ptr( (void* volatile*)&g_registry.readers, head, reader ) );
+    }
+
+    if ( cf_reader_key_ready() )
+    {
+        cf_thread_key_set( g_registry.reader_key, reader );
+    }
+    t_reader            = reader;
+    t_reader_generation = generation;
+    return reader;
+}
+
+// Enters a read section and returns the current snapshot, or NULL if nothing is
+// registered. Read sections nest, never block and must be closed with cf_read_end().
+static const cf_snapshot_t*
+cf_read_begin( void )
+{
+    cf_load_builtin_tables();
+
+    cf_reader_t* reader = cf_reader_local();
+    if ( !reader )
+    {
+        return NULL;
+    }
+
+    if ( reader->depth++ == 0 )
+    {
+        // Announce the epoch before loading the snapshot; pairs with the fence in cf_synchronize().
+        cf_atomic_store_u32( &reader->epoch, cf_atomic_load_u32( &g_registry.epoch ) );
+        cf_atomic_fence();
+    }
+    return (const cf_snapshot_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.snapshot );
+}
+
+static void
+cf_read_end( void )
+{
+    cf_reader_t* reader = cf_reader_current();
+    if ( reader && --reader->depth == 0 )
+    {
+        cf_atomic_store_u32( &reader->epoch, CF_EPOCH_IDLE );
+    }
+}
+
+// --- Statistics ---
+
+// With CFLEX_STATS, public lookups open with CF_STAT_BEGIN(), count the entries they
+// compare with CF_STAT_PROBE() and record the outcome with CF_STAT_RECORD(). All three
+// compile to nothing otherwise. Writers probe the index too, hence the reset on entry;
+// lookups that enter a read section reset after cf_read_begin(), which may register the
+// built-in tables.
+#if defined( CFLEX_STATS )
+
+static CF_THREAD_LOCAL uint64_t t_probes = 0;    // Probes of the lookup in progress
+
+#    define CF_STAT_BEGIN()                  ( t_probes = 0 )
+#    define CF_STAT_PROBE()                  ( ++t_probes )
+#    define CF_STAT_RECORD( lookup, result ) cf_stats_record( lookup, ( result ) != NULL )
+
+static void
+cf_stats_record( cf_stat_lookup_t lookup, bool hit )
+{
+    cf_reader_t* reader = cf_reader_local();
+    if ( reader )
+    {
+        cf_stat_counters_t* counters = &reader->stats.lookups[ lookup ];
+        counters->calls++;
+        counters->hits += hit;
+        counters->misses += !hit;
+        counters->probes += t_probes;
+    }
+}
+
+#else
+
+#    define CF_STAT_BEGIN()                  ( (void)0 )
+#    define CF_STAT_PROBE()                  ( (void)0 )
+#    define CF_STAT_RECORD( lookup, result ) ( (void)0 )
+
+#endif
+
+// --- Type Index ---
+
+// Returns the stable ID of a type. Generated types carry it; hand-built ones may not.
+static uint64_t
+cf_type_id( const cf_type_t* type )
+{
+    return type->id ? type->id : cf_hash_name( type->name );
+}
+
+// Records a type's dense index in its state, if it has one. Only writers store it, so the
+// comparison reads it plainly; lock-free readers load it with cf_get_type_index().
+static void
+cf_type_set_index( const cf_type_t* type, int32_t index )
+{
+    if ( type->state && type->state->index != index )
+    {
+        cf_atomic_store_u32( (volatile uint32_t*)&type->state->index, (uint32_t)index );
+    }
+}
+
+// A struct's interval in the inheritance forest of registered structs, packed so that
+// readers load it in one go: the generation of the numbering in the top 16 bits, then
+// the pre- and post-order numbers in 24 bits each. 0 while the type is not numbered.
+#define CF_INTERVAL_BITS 24
+#define CF_INTERVAL_MASK ( ( (uint64_t)1 << CF_INTERVAL_BITS ) - 1 )
+
+static uint64_t
+cf_interval_pack( uint32_t generation, int32_t pre, int32_t post )
+{
+    return (uint64_t)( generation & 0xffffu ) << ( 2 * CF_INTERVAL_BITS ) |
+           (uint64_t)pre << CF_INTERVAL_BITS | (uint64_t)post;
+}
+
+// Records a type's interval in its state, if it has one. Written by writers only.
+static void
+cf_type_set_interval( const cf_type_t* type, uint64_t interval )
+{
+    if ( type->state && type->state->interval != interval )
+    {
+        cf_atomic_store_u64( (volatile uint64_t*)&type->state->interval, interval );
+    }
+}
+
+// Inserts a type into a slot array without growing it. The first type registered
+// under a name wins, which matches the order of the previous table scan.
+// Returns the slot holding the type of that name; a new slot has no dense index yet.
+static cf_index_slot_t*
+cf_index_insert_slot( cf_index_slot_t* slots, uint32_t mask, uint64_t hash, const cf_type_t* type )
+{
+    uint32_t i = (uint32_t)hash & mask;
+    while ( slots[ i ].type )
+    {
+        const char* name = slots[ i ].type->name;
+        if ( slots[ i ].hash == hash && ( !name || !type->name || strcmp( name, type->name ) == 0 ) )
+        {
+            return &slots[ i ];
+        }
+        i = ( i + 1 ) & mask;
+    }
+    slots[ i ].hash  = hash;
+    slots[ i ].type  = type;
+    slots[ i ].dense = -1;
+    return &slots[ i ];
+}
+
+// Compares an entry name with the first `len` bytes of a query. Entries generated with
+// --strip-names have no name and are matched by their hash.
+static bool
+cf_name_matches( const char* entry, uint64_t entry_hash, const char* name, int32_t len, uint64_t hash )
+{
+    if ( entry )
+    {
+        return strncmp( entry, name, (size_t)len ) == 0 && entry[ len ] == '\0';
+    }
+    return entry_hash == hash;
+}
+
+static const cf_index_slot_t*
+cf_snapshot_find_id( const cf_snapshot_t* snapshot, uint64_t id )
+{
+    uint32_t mask = snapshot->index_mask;
+    for ( uint32_t i = (uint32_t)id & mask;; i = ( i + 1 ) & mask )
+    {
+        const cf_index_slot_t* slot = &snapshot->index[ i ];
+        CF_STAT_PROBE();
+        if ( !slot->type || slot->hash == id )
+        {
+            return slot->type ? slot : NULL;
+        }
+    }
+}
+
+static const cf_type_t*
+cf_snapshot_find_name( const cf_snapshot_t* snapshot, const char* name, int32_t len )
+{
+    uint64_t hash = cf_hash_name_n( name, len );
+    uint32_t mask = snapshot->index_mask;
+    for ( uint32_t i = (uint32_t)hash & mask;; i = ( i + 1 ) & mask )
+    {
+        const cf_index_slot_t* slot = &snapshot->index[ i ];
+        CF_STAT_PROBE();
+        if ( !slot->type )
+        {
+            return NULL;
+        }
+        if ( slot->hash == hash && cf_name_matches( slot->type->name, hash, name, len, hash ) )
+        {
+            return slot->type;
+        }
+    }
+}
+
+// --- Snapshots ---
+
+static size_t
+cf_align_size( size_t size )
+{
+    return ( size + 15 ) & ~(size_t)15;
+}
+
+#define CF_DENSE_NEW -2    // Dense index of a type being added, until it is given one
+
+// Builds a snapshot over `tables`. Types that were registered in `prev` keep their
+// dense index; new types take the indices of unregistered ones first. Returns NULL on
+// allocation failure.
+static cf_snapshot_t*
+cf_snapshot_build( const cf_snapshot_t* prev, const cf_type_table_t* tables, int32_t num_tables )
+{
+    int32_t total = 0;
+    for ( int32_t i = 0; i < num_tables; ++i ) { total += tables[ i ].count; }
+
+    uint32_t capacity = CF_INDEX_MIN_CAPACITY;
+    while ( (uint32_t)total * 4 > capacity * 3 ) { capacity *= 2; }
+
+    int32_t max_types  = ( prev ? prev->num_types : 0 ) + total;
+    size_t  head_size  = cf_align_size( sizeof( cf_snapshot_t ) );
+    size_t  index_size = cf_align_size( capacity * sizeof( cf_index_slot_t ) );
+    size_t  types_size = cf_align_size( max_types * sizeof( const cf_type_t* ) );
+    size_t  dups_size  = cf_align_size( total * sizeof( const cf_type_t* ) );
+    size_t  table_size = num_tables * sizeof( cf_type_table_t );
+
+    uint8_t* block     = (uint8_t*)calloc( 1, head_size + index_size + types_size + dups_size + table_size );
+    if ( !block )
+    {
+        return NULL;
+    }
+
+    cf_snapshot_t* snapshot = (cf_snapshot_t*)block;
+    snapshot->index         = (cf_index_slot_t*)( block + head_size );
+    snapshot->index_mask    = capacity - 1;
+    snapshot->types         = (const cf_type_t**)( block + head_size + index_size );
+    snapshot->num_types     = prev ? prev->num_types : 0;
+    snapshot->dups          = (const cf_type_t**)( block + head_size + index_size + types_size );
+    snapshot->tables        = (cf_type_table_t*)( block + head_size + index_size + types_size + dups_size );
+    snapshot->num_tables    = num_tables;
+    if ( num_tables > 0 )
+    {
+        memcpy( snapshot->tables, tables, table_size );
+    }
+
+    // First the types that were registered before, which keep their index.
+    for ( int32_t t = 0; t < num_tables; ++t )
+    {
+        for ( int32_t i = 0; i < tables[ t ].count; ++i )
+        {
+            const cf_type_t* type = tables[ t ].types[ i ];
+            if ( !type || ( !type->name && !type->id ) )
+            {
+                continue;
+            }
+
+            uint64_t         id   = cf_type_id( type );
+            cf_index_slot_t* slot = cf_index_insert_slot( snapshot->index, snapshot->index_mask, id, type );
+            if ( slot->type != type || slot->dense != -1 )
+            {
+                continue;    // Another definition of the type, or the same type object listed twice
+            }
+
+            const cf_index_slot_t* prev_slot = prev ? cf_snapshot_find_id( prev, id ) : NULL;
+            if ( prev_slot && prev_slot->type == type )
+            {
+                slot->dense                    = prev_slot->dense;
+                snapshot->types[ slot->dense ] = type;
+                cf_type_set_index( type, slot->dense );
+            }
+            else
+            {
+                slot->dense = CF_DENSE_NEW;
+            }
+        }
+    }
+
+    // Then the new types, in registration order. They fill the holes that unregistered
+    // types left before they are appended, so the dense arrays are never longer than the
+    // most types registered at once.
+    int32_t hole = 0;
+    for ( int32_t t = 0; t < num_tables; ++t )
+    {
+        for ( int32_t i = 0; i < tables[ t ].count; ++i )
+        {
+            const cf_type_t* type = tables[ t ].types[ i ];
+            if ( !type || ( !type->name && !type->id ) )
+            {
+                continue;
+            }
+
+            cf_index_slot_t* slot =
+                cf_index_insert_slot( snapshot->index, snapshot->index_mask, cf_type_id( type ), type );
+            if ( slot->type != type )
+            {
+                // A second definition of a known type shares the index of the first.
+                if ( type->state )
+                {
+                    snapshot->dups[ snapshot->num_dups++ ] = type;
+                }
+                cf_type_set_index( type, slot->dense );
+                continue;
+            }
+            if ( slot->dense != CF_DENSE_NEW )
+            {
+                continue;
+            }
+
+            while ( hole < snapshot->num_types && snapshot->types[ hole ] ) { hole++; }
+            slot->dense                    = hole < snapshot->num_types ? hole : snapshot->num_types++;
+            snapshot->types[ slot->dense ] = type;
+            cf_type_set_index( type, slot->dense );
+        }
+    }
+
+    // Holes at the end are dropped.
+    while ( snapshot->num_types > 0 && !snapshot->types[ snapshot->num_types - 1 ] )
+    {
+        snapshot->num_types--;
+    }
+
+    return snapshot;
+}
+
+// Returns the dense index recorded in a type's state if the snapshot holds the type there,
+// or -1. Unlike cf_snapshot_dense_index(), other definitions of the same type get -1.
+static int32_t
+cf_snapshot_state_index( const cf_snapshot_t* snapshot, const cf_type_t* type )
+{
+    int32_t index = cf_get_type_index( type );
+    return index >= 0 && index < snapshot->num_types && snapshot->types[ index ] == type ? index : -1;
+}
+
+// Returns true if a snapshot (may be NULL) holds the type itself, either as the first
+// definition of its ID or as a later one.
+static bool
+cf_snapshot_lists( const cf_snapshot_t* snapshot, const cf_type_t* type )
+{
+    if ( !snapshot )
+    {
+        return false;
+    }
+    if ( cf_snapshot_state_index( snapshot, type ) >= 0 )
+    {
+        return true;
+    }
+    for ( int32_t i = 0; i < snapshot->num_dups; ++i )
+    {
+        if ( snapshot->dups[ i ] == type )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the dense index of a type in a snapshot, or -1 if it is not registered.
+static int32_t
+cf_snapshot_dense_index( const cf_snapshot_t* snapshot, const cf_type_t* type )
+{
+    if ( !type || ( !type->name && !type->id ) )
+    {
+        return -1;
+    }
+    const cf_index_slot_t* slot = cf_snapshot_find_id( snapshot, cf_type_id( type ) );
+    return slot ? slot->dense : -1;
+}
+
+// Walks the direct containment edges from dense index `t` and returns the number of structs
+// that contain it, writing their dense indices to `out` if it is not NULL. Each struct is
+// marked with `t` when first reached, so it is listed once.
+static int32_t
+cf_relations_walk(
+    const int32_t* edge_start, const int32_t* edges, int32_t* marks, int32_t* stack, int32_t t, int32_t* out )
+{
+    int32_t count    = 0;
+    int32_t depth    = 0;
+    stack[ depth++ ] = t;
+    marks[ t ]       = t;
+    while ( depth > 0 )
+    {
+        int32_t u = stack[ --depth ];
+        for ( int32_t e = edge_start[ u ]; e < edge_start[ u + 1 ]; ++e )
+        {
+            int32_t s = edges[ e ];
+            if ( marks[ s ] != t )
+            {
+                marks[ s ]       = t;
+                stack[ depth++ ] = s;
+                if ( out )
+                {
+                    out[ count ] = s;
+                }
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+// Builds the kind index and the transitive reverse containment index of a snapshot.
+// Returns NULL on allocation failure.
+static cf_relations_t*
+cf_relations_build( const cf_snapshot_t* snapshot )
+{
+    int32_t num_types = snapshot->num_types;
+    int32_t num_live  = 0;
+    int32_t num_edges = 0;
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        const cf_type_t* type = snapshot->types[ i ];
+        if ( type )
+        {
+            num_live++;
+            num_edges += type->kind == CF_KIND_STRUCT ? type->struct_count : 0;
+        }
+    }
+
+    // Scratch: direct edges from each type to the structs with a field of that type, then
+    // walk marks and stack.
+    int32_t* scratch = (int32_t*)malloc( ( ( num_types + 1 ) * 3 + num_edges ) * sizeof( int32_t ) );
+    if ( !scratch )
+    {
+        return NULL;
+    }
+    int32_t* edge_start = scratch;
+    int32_t* marks      = edge_start + num_types + 1;
+    int32_t* stack      = marks + num_types + 1;
+    int32_t* edges      = stack + num_types + 1;
+
+    memset( edge_start, 0, ( num_types + 1 ) * sizeof( int32_t ) );
+    for ( int32_t pass = 0; pass < 2; ++pass )
+    {
+        for ( int32_t s = 0; s < num_types; ++s )
+        {
+            const cf_type_t* type = snapshot->types[ s ];
+            for ( int32_t f = 0; type && type->kind == CF_KIND_STRUCT && f < type->struct_count; ++f )
+            {
+                int32_t t = cf_snapshot_dense_index( snapshot, type->struct_array[ f ].type );
+                if ( t >= 0 && pass == 0 )
+                {
+                    edge_start[ t + 1 ]++;
+                }
+                else if ( t >= 0 )
+                {
+                    edges[ marks[ t ]++ ] = s;    // marks[] holds the fill cursors here
+                }
+            }
+        }
+        for ( int32_t t = 0; pass == 0 && t < num_types; ++t )
+        {
+            edge_start[ t + 1 ] += edge_start[ t ];
+            marks[ t ] = edge_start[ t ];
+        }
+    }
+
+    // Count the transitive containers, then allocate and fill the index.
+    int32_t num_found = 0;
+    for ( int32_t t = 0; t < num_types; ++t ) { marks[ t ] = -1; }
+    for ( int32_t t = 0; t < num_types; ++t )
+    {
+        num_found += snapshot->types[ t ] ? cf_relations_walk( edge_start, edges, marks, stack, t, NULL ) : 0;
+    }
+
+    size_t          head_size = cf_align_size( sizeof( cf_relations_t ) );
+    size_t          rows_size = ( num_live + num_types + 1 + num_found ) * sizeof( int32_t );
+    cf_relations_t* relations = (cf_relations_t*)malloc( head_size + rows_size );
+    if ( relations )
+    {
+        relations->kind_types      = (int32_t*)( (uint8_t*)relations + head_size );
+        relations->container_start = relations->kind_types + num_live;
+        relations->containers      = relations->container_start + num_types + 1;
+
+        int32_t position           = 0;
+        for ( int32_t kind = 0; kind < CF_KIND_COUNT; ++kind )
+        {
+            relations->kind_start[ kind ] = position;
+            for ( int32_t i = 0; i < num_types; ++i )
+            {
+                const cf_type_t* type = snapshot->types[ i ];
+                if ( type && (int32_t)type->kind == kind )
+                {
+                    relations->kind_types[ position++ ] = i;
+                }
+            }
+        }
+        relations->kind_start[ CF_KIND_COUNT ] = position;
+
+        position                               = 0;
+        for ( int32_t t = 0; t < num_types; ++t ) { marks[ t ] = -1; }
+        for ( int32_t t = 0; t < num_types; ++t )
+        {
+            relations->container_start[ t ] = position;
+            if ( snapshot->types[ t ] )
+            {
+                int32_t* row = relations->containers + position;
+                position += cf_relations_walk( edge_start, edges, marks, stack, t, row );
+            }
+        }
+        relations->container_start[ num_types ] = position;
+    }
+
+    free( scratch );
+    return relations;
+}
+
+// Numbers the structs of a new snapshot in pre- and post-order of the forest formed by
+// struct_parent and stores each type's interval in its state, for cf_type_is_a(). Every
+// type gets an interval; types outside any hierarchy are single-node trees. Other
+// definitions share the interval of the first. If this fails, intervals are reset to 0
+// and cf_type_is_a() walks the parent chain instead.
+static void
+cf_snapshot_number_hierarchy( cf_snapshot_t* snapshot )
+{
+    int32_t  num_types = snapshot->num_types;
+    int32_t* scratch   = NULL;
+    if ( 2 * (int64_t)num_types <= (int64_t)CF_INTERVAL_MASK )
+    {
+        scratch = (int32_t*)malloc( ( num_types + 1 ) * 6 * sizeof( int32_t ) );
+    }
+    if ( !scratch )
+    {
+        for ( int32_t t = 0; t < num_types; ++t )
+        {
+            if ( snapshot->types[ t ] )
+            {
+                cf_type_set_interval( snapshot->types[ t ], 0 );
+            }
+        }
+        for ( int32_t i = 0; i < snapshot->num_dups; ++i ) { cf_type_set_interval( snapshot->dups[ i ], 0 ); }
+        return;
+    }
+    int32_t* parent       = scratch;
+    int32_t* first_child  = parent + num_types + 1;
+    int32_t* next_sibling = first_child + num_types + 1;
+    int32_t* stack        = next_sibling + num_types + 1;
+    int32_t* pre          = stack + num_types + 1;
+    int32_t* post         = pre + num_types + 1;
+
+    // Child lists, in ascending dense index order.
+    for ( int32_t t = 0; t < num_types; ++t ) { first_child[ t ] = -1; }
+    for ( int32_t t = num_types - 1; t >= 0; --t )
+    {
+        const cf_type_t* type = snapshot->types[ t ];
+        parent[ t ]           = -1;
+        if ( type && type->kind == CF_KIND_STRUCT )
+        {
+            parent[ t ] = cf_snapshot_dense_index( snapshot, type->struct_parent );
+        }
+        if ( parent[ t ] >= 0 )
+        {
+            next_sibling[ t ]          = first_child[ parent[ t ] ];
+            first_child[ parent[ t ] ] = t;
+        }
+    }
+
+    // Depth-first walk from each root. first_child[] is consumed as the walk's cursor.
+    int32_t counter = 0;
+    for ( int32_t root = 0; root < num_types; ++root )
+    {
+        if ( !snapshot->types[ root ] || parent[ root ] >= 0 )
+        {
+            continue;
+        }
+
+        int32_t depth    = 0;
+        stack[ depth++ ] = root;
+        pre[ root ]      = ++counter;
+        while ( depth > 0 )
+        {
+            int32_t u = stack[ depth - 1 ];
+            int32_t v = first_child[ u ];
+            if ( v >= 0 )
+            {
+                first_child[ u ] = next_sibling[ v ];
+                pre[ v ]         = ++counter;
+                stack[ depth++ ] = v;
+            }
+            else
+            {
+                post[ u ] = ++counter;
+                depth--;
+            }
+        }
+    }
+
+    // A new generation keeps readers from comparing intervals of two numberings while
+    // they are being stored.
+    uint32_t generation = ++g_registry.numbering;
+    for ( int32_t t = 0; t < num_types; ++t )
+    {
+        if ( snapshot->types[ t ] )
+        {
+            cf_type_set_interval( snapshot->types[ t ], cf_interval_pack( generation, pre[ t ], post[ t ] ) );
+        }
+    }
+    for ( int32_t i = 0; i < snapshot->num_dups; ++i )
+    {
+        int32_t t = cf_get_type_index( snapshot->dups[ i ] );
+        cf_type_set_interval( snapshot->dups[ i ], cf_interval_pack( generation, pre[ t ], post[ t ] ) );
+    }
+
+    free( scratch );
+}
+
+// Waits until every other thread has left the read sections it was in when this was called.
+static void
+cf_synchronize( void )
+{
+    uint32_t epoch = g_registry.epoch + 1;
+    if ( epoch == CF_EPOCH_IDLE )
+    {
+        epoch++;
+    }
+    cf_atomic_store_u32( &g_registry.epoch, epoch );
+    cf_atomic_fence();
+
+    cf_reader_t* self   = cf_reader_current();
+    cf_reader_t* reader = (cf_reader_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.readers );
+    for ( ; reader; reader = reader->next )
+    {
+        if ( reader == self )
+        {
+            continue;
+        }
+        for ( ;; )
+        {
+            uint32_t observed = cf_atomic_load_u32( &reader->epoch );
+            if ( observed == CF_EPOCH_IDLE || observed == epoch )
+            {
+                break;
+            }
+            cf_thread_yield();
+        }
+    }
+}
+
+static void cf_layout_drop( const cf_type_t* type );
+
+// Publishes a new snapshot (may be NULL) and reclaims retired ones. Must hold the write lock.
+// Types dropped from the registry get their dense index reset and lose their cached layout.
+static void
+cf_publish( cf_snapshot_t* snapshot )
+{
+    cf_snapshot_t* old = g_registry.snapshot;
+    cf_atomic_store_ptr( (void* volatile*)&g_registry.snapshot, snapshot );
+
+    if ( old )
+    {
+        for ( int32_t i = 0; i < old->num_types; ++i )
+        {
+            const cf_type_t* type = old->types[ i ];
+            if ( type && !cf_snapshot_lists( snapshot, type ) )
+            {
+                cf_type_set_index( type, -1 );
+                cf_type_set_interval( type, 0 );
+            }
+        }
+        for ( int32_t i = 0; i < old->num_dups; ++i )
+        {
+            if ( !cf_snapshot_lists( snapshot, old->dups[ i ] ) )
+            {
+                cf_type_set_index( old->dups[ i ], -1 );
+                cf_type_set_interval( old->dups[ i ], 0 );
+            }
+        }
+
+        old->next_retired  = g_registry.retired;
+        g_registry.retired = old;
+    }
+
+    cf_synchronize();
+
+    // Readers that saw the dropped types registered have left, so none of them can cache
+    // a layout for one anymore.
+    if ( old )
+    {
+        for ( int32_t i = 0; i < old->num_types; ++i )
+        {
+            if ( old->types[ i ] && !cf_snapshot_lists( snapshot, old->types[ i ] ) )
+            {
+                cf_layout_drop( old->types[ i ] );
+            }
+        }
+        for ( int32_t i = 0; i < old->num_dups; ++i )
+        {
+            if ( !cf_snapshot_lists( snapshot, old->dups[ i ] ) )
+            {
+                cf_layout_drop( old->dups[ i ] );
+            }
+        }
+    }
+
+    // If this thread is itself inside a read section it may still hold a retired
+    // snapshot; keep them until a later write.
+    cf_reader_t* self = cf_reader_current();
+    if ( !self || self->depth == 0 )
+    {
+        while ( g_registry.retired )
+        {
+            cf_snapshot_t* retired = g_registry.retired;
+            g_registry.retired     = retired->next_retired;
+            free( retired->relations );
+            free( retired );
+        }
+    }
+}
+
+// --- Packed Modules ---
+
+// Descriptors materialized from a packed module. Allocated as a single block and kept
+// until cf_shutdown(), so type pointers stay valid while a module is unregistered.
+typedef struct cf_packed_entry_t
+{
+    const cf_packed_module_t* module;
+    const cf_type_t**         types;    // Type table handed to the registry
+    cf_field_t*               fields;
+    int32_t                   num_unresolved;    // Fields whose type is not registered yet
+    struct cf_packed_entry_t* next;
+} cf_packed_entry_t;
+
+// Enums whose values span at most this many integers, and no more than
+// CF_ENUM_DENSE_MAX_SPREAD times their value count, get a direct-index table.
+// This is the policy cflex_build applies to regular modules.
+#define CF_ENUM_DENSE_MAX_RANGE  1024
+#define CF_ENUM_DENSE_MAX_SPREAD 4
+
+// Returns the value range of a packed enum if it gets a direct-index table, else 0.
+static int32_t
+cf_packed_enum_range( const cf_packed_module_t* module, const cf_packed_type_t* packed, int32_t* out_min )
+{
+    const cf_packed_value_t* values = module->values + packed->first;
+    int32_t                  min    = packed->count ? values[ 0 ].value : 0;
+    int32_t                  max    = min;
+    for ( uint32_t i = 1; i < packed->count; ++i )
+    {
+        min = values[ i ].value < min ? values[ i ].value : min;
+        max = values[ i ].value > max ? values[ i ].value : max;
+    }
+
+    *out_min      = min;
+    int64_t range = (int64_t)max - (int64_t)min + 1;
+    bool    dense = packed->count > 0 && range <= CF_ENUM_DENSE_MAX_RANGE &&
+                 range <= (int64_t)packed->count * CF_ENUM_DENSE_MAX_SPREAD;
+    return dense ? (int32_t)range : 0;
+}
+
+// Bytes of the direct-index table of an enum with the given range: validity bits, then indices.
+static size_t
+cf_packed_dense_size( int32_t range )
+{
+    return ( ( range + 31 ) / 32 ) * sizeof( uint32_t ) + ( ( range * sizeof( int16_t ) + 3 ) & ~(size_t)3 );
+}
+
+// Returns a name from the string blob, or NULL if the module was built with --strip-names.
+static const char*
+cf_packed_name( const cf_packed_module_t* module, uint32_t offset )
+{
+    return offset != CF_PACKED_NONE ? module->strings + offset : NULL;
+}
+
+// Builds the cf_type_t descriptors of a packed module. Field types are resolved later,
+// by cf_packed_resolve_locked(). Returns NULL on allocation failure.
+static cf_packed_entry_t*
+cf_packed_materialize( const cf_packed_module_t* module )
+{
+    int32_t num_types  = module->num_types;
+    int32_t num_fields = module->num_fields;
+    int32_t num_values = module->num_values;
+
+    size_t entry_size  = cf_align_size( sizeof( cf_packed_entry_t ) );
+    size_t types_size  = cf_align_size( num_types * sizeof( cf_type_t ) );
+    size_t states_size = cf_align_size( num_types * sizeof( cf_type_state_t ) );
+    size_t table_size  = cf_align_size( num_types * sizeof( const cf_type_t* ) );
+    size_t fields_size = cf_align_size( num_fields * sizeof( cf_field_t ) );
+    size_t values_size = cf_align_size( num_values * sizeof( cf_enum_value_t ) );
+    size_t sorted_size = cf_align_size( num_values * sizeof( uint16_t ) );
+    size_t dense_size  = 0;
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        int32_t min;
+        if ( module->types[ i ].kind == CF_KIND_ENUM )
+        {
+            dense_size += cf_packed_dense_size( cf_packed_enum_range( module, &module->types[ i ], &min ) );
+        }
+    }
+
+    uint8_t* block = (uint8_t*)calloc( 1, entry_size + types_size + states_size + table_size + fields_size +
+                                              values_size + sorted_size + dense_size );
+    if ( !block )
+    {
+        return NULL;
+    }
+
+    cf_packed_entry_t* entry  = (cf_packed_entry_t*)block;
+    cf_type_t*         types  = (cf_type_t*)( block += entry_size );
+    cf_type_state_t*   states = (cf_type_state_t*)( block += types_size );
+    entry->types              = (const cf_type_t**)( block += states_size );
+    entry->fields             = (cf_field_t*)( block += table_size );
+    cf_enum_value_t* values   = (cf_enum_value_t*)( block += fields_size );
+    uint16_t*        sorted   = (uint16_t*)( block += values_size );
+    uint8_t*         dense    = block + sorted_size;
+    entry->module             = module;
+    entry->num_unresolved     = num_fields;
+
+    for ( int32_t i = 0; i < num_fields; ++i )
+    {
+        const cf_packed_field_t* packed = &module->fields[ i ];
+        const char*              name   = cf_packed_name( module, packed->name );
+        uint64_t   hash  = module->field_hashes ? module->field_hashes[ i ] : cf_hash_name( name );
+        cf_field_t field = { name, NULL, (int32_t)packed->offset, 0, hash };
+        memcpy( &entry->fields[ i ], &field, sizeof( field ) );
+    }
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        const cf_packed_type_t* packed = &module->types[ i ];
+        if ( packed->kind == CF_KIND_STRUCT && ( packed->prim & CF_PACKED_HAS_BASE ) && packed->count > 0 )
+        {
+            cf_field_t* base  = &entry->fields[ packed->first ];
+            cf_field_t  field = { base->name, NULL, base->offset, CF_FIELD_BASE, base->name_hash };
+            memcpy( base, &field, sizeof( field ) );
+        }
+    }
+    for ( int32_t i = 0; i < num_values; ++i )
+    {
+        values[ i ].name  = cf_packed_name( module, module->values[ i ].name );
+        values[ i ].value = module->values[ i ].value;
+        values[ i ].name_hash =
+            module->value_hashes ? module->value_hashes[ i ] : cf_hash_name( values[ i ].name );
+    }
+
+    int32_t num_enums = 0;
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        const cf_packed_type_t* packed = &module->types[ i ];
+
+        cf_phash_t phash               = { NULL, NULL, 0 };
+        if ( packed->lookup != CF_PACKED_NONE )
+        {
+            uint32_t num_buckets = cf_phash_num_buckets( packed->count );
+            phash.seeds          = module->lookup + packed->lookup;
+            phash.slots          = module->lookup + packed->lookup + num_buckets;
+            phash.bucket_mask    = num_buckets - 1;
+        }
+
+        states[ i ].index = -1;
+
+        // Descriptors have const members, so each one is built in place and copied.
+        const char* name = cf_packed_name( module, packed->name );
+        if ( packed->kind == CF_KIND_STRUCT )
+        {
+            cf_type_t desc = { .name         = name,
+                               .kind         = CF_KIND_STRUCT,
+                               .size         = (int32_t)packed->size,
+                               .align        = packed->align,
+                               .id           = packed->id,
+                               .state        = &states[ i ],
+                               .struct_array = entry->fields + packed->first,
+                               .struct_count = (int32_t)packed->count,
+                               .struct_phash = phash,
+                               .struct_funcs = module->funcs ? module->funcs[ i ] : NULL };
+            memcpy( &types[ i ], &desc, sizeof( desc ) );
+        }
+        else if ( packed->kind == CF_KIND_ENUM )
+        {
+            // Value lookup tables, as cflex_build emits them for regular modules.
+            const cf_enum_value_t* enum_values = values + packed->first;
+            uint16_t*              enum_sorted = NULL;
+            uint32_t*              enum_valid  = NULL;
+            int16_t*               enum_dense  = NULL;
+            int32_t                enum_min;
+            int32_t                enum_range = cf_packed_enum_range( module, packed, &enum_min );
+            if ( enum_range > 0 )
+            {
+                enum_valid = (uint32_t*)dense;
+                enum_dense = (int16_t*)( dense + ( ( enum_range + 31 ) / 32 ) * sizeof( uint32_t ) );
+                dense += cf_packed_dense_size( enum_range );
+
+                // Aliased values resolve to the first entry declared with that value.
+                memset( enum_dense, 0xff, enum_range * sizeof( int16_t ) );
+                for ( int32_t j = (int32_t)packed->count - 1; j >= 0; --j )
+                {
+                    int32_t offset       = enum_values[ j ].value - enum_min;
+                    enum_dense[ offset ] = (int16_t)j;
+                    enum_valid[ offset / 32 ] |= 1u << ( offset % 32 );
+                }
+            }
+            else
+            {
+                // Stable insertion sort by value, so aliases keep their declaration order.
+                enum_sorted = sorted + packed->first;
+                for ( int32_t j = 0; j < (int32_t)packed->count; ++j )
+                {
+                    int32_t k = j;
+                    while ( k > 0 && enum_values[ enum_sorted[ k - 1 ] ].value > enum_values[ j ].value )
+                    {
+                        enum_sorted[ k ] = enum_sorted[ k - 1 ];
+                        k--;
+                    }
+                    enum_sorted[ k ] = (uint16_t)j;
+                }
+            }
+
+            const cf_packed_codec_t* codec = module->codecs ? &module->codecs[ num_enums++ ] : NULL;
+            cf_type_t                desc  = { .name                = name,
+                                               .kind                = CF_KIND_ENUM,
+                                               .size                = (int32_t)packed->size,
+                                               .align               = packed->align,
+                                               .id                  = packed->id,
+                                               .state               = &states[ i ],
+                                               .enum_array          = enum_values,
+                                               .enum_count          = (int32_t)packed->count,
+                                               .enum_min            = enum_min,
+                                               .enum_range          = enum_range,
+                                               .enum_by_value       = enum_dense,
+                                               .enum_valid_bits     = enum_valid,
+                                               .enum_sorted         = enum_sorted,
+                                               .enum_phash          = phash,
+                                               .enum_index_of_name  = codec ? codec->index_of_name : NULL,
+                                               .enum_index_of_value = codec ? codec->index_of_value : NULL };
+            memcpy( &types[ i ], &desc, sizeof( desc ) );
+        }
+        else
+        {
+            cf_type_t desc = { .name  = name,
+                               .kind  = CF_KIND_PRIMITIVE,
+                               .size  = (int32_t)packed->size,
+                               .align = packed->align,
+                               .id    = packed->id,
+                               .state = &states[ i ],
+                               .prim  = (cf_prim_t)packed->prim };
+            memcpy( &types[ i ], &desc, sizeof( desc ) );
+        }
+
+        entry->types[ i ] = &types[ i ];
+    }
+
+    return entry;
+}
+
+// Returns the materialized form of a packed module, building it on first use.
+// Must hold the write lock.
+static cf_packed_entry_t*
+cf_packed_get_locked( const cf_packed_module_t* module, bool create )
+{
+    for ( cf_packed_entry_t* entry = g_registry.packed; entry; entry = entry->next )
+    {
+        if ( entry->module == module )
+        {
+            return entry;
+        }
+    }
+    if ( !create )
+    {
+        return NULL;
+    }
+
+    cf_packed_entry_t* entry = cf_packed_materialize( module );
+    if ( entry )
+    {
+        entry->next       = g_registry.packed;
+        g_registry.packed = entry;
+    }
+    return entry;
+}
+
+// Points the field types of packed modules at the types registered in `snapshot`, which
+// is about to be published. Fields whose type is not registered yet are retried after
+// later registrations. Must hold the write lock.
+static void
+cf_packed_resolve_locked( const cf_snapshot_t* snapshot )
+{
+    for ( cf_packed_entry_t* entry = g_registry.packed; entry; entry = entry->next )
+    {
+        if ( entry->num_unresolved == 0 )
+        {
+            continue;
+        }
+
+        const cf_packed_module_t* module = entry->module;
+        entry->num_unresolved            = 0;
+        for ( int32_t i = 0; i < module->num_fields; ++i )
+        {
+            cf_field_t* field = &entry->fields[ i ];
+            if ( field->type )
+            {
+                continue;
+            }
+
+            // Readers may already see this field through a published type.
+            const cf_index_slot_t* slot =
+                cf_snapshot_find_id( snapshot, module->refs[ module->fields[ i ].type ] );
+            if ( slot )
+            {
+                cf_atomic_store_ptr( (void* volatile*)&field->type, (void*)slot->type );
+            }
+            else
+            {
+                entry->num_unresolved++;
+            }
+        }
+
+        // A struct's parent is the type of its base field, once that is resolved.
+        for ( int32_t i = 0; i < module->num_types; ++i )
+        {
+            const cf_type_t* type = entry->types[ i ];
+            if ( type->kind == CF_KIND_STRUCT && !type->struct_parent && type->struct_count > 0 &&
+                 ( type->struct_array[ 0 ].flags & CF_FIELD_BASE ) && type->struct_array[ 0 ].type )
+            {
+                cf_atomic_store_ptr( (void* volatile*)&type->struct_parent,
+                                     (void*)type->struct_array[ 0 ].type );
+            }
+        }
+    }
+}
+
+// Appends the given tables, skipping any that are already registered, and publishes the
+// result. Must hold the write lock.
+static void
+cf_add_tables_locked( const cf_type_table_t* add, int32_t count )
+{
+    const cf_snapshot_t* prev       = g_registry.snapshot;
+    int32_t              num_tables = prev ? prev->num_tables : 0;
+
+    cf_type_table_t* tables = (cf_type_table_t*)malloc( ( num_tables + count ) * sizeof( cf_type_table_t ) );
+    if ( !tables )
+    {
+        return;
+    }
+    if ( num_tables > 0 )
+    {
+        memcpy( tables, prev->tables, num_tables * sizeof( cf_type_table_t ) );
+    }
+
+    int32_t total = num_tables;
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        bool registered = false;
+        for ( int32_t j = 0; j < total && !registered; ++j )
+        {
+            registered = tables[ j ].types == add[ i ].types;
+        }
+        if ( !registered )
+        {
+            tables[ total++ ] = add[ i ];
+        }
+    }
+
+    if ( total > num_tables )
+    {
+        cf_snapshot_t* snapshot = cf_snapshot_build( prev, tables, total );
+        if ( snapshot )
+        {
+            cf_packed_resolve_locked( snapshot );
+            cf_snapshot_number_hierarchy( snapshot );
+            snapshot->relations = cf_relations_build( snapshot );
+            cf_publish( snapshot );
+        }
+    }
+    free( tables );
+}
+
+// Removes a registered table and publishes the result. Must hold the write lock.
+static void
+cf_remove_table_locked( const cf_type_t** types )
+{
+    const cf_snapshot_t* prev = g_registry.snapshot;
+    int32_t              slot = -1;
+    for ( int32_t i = 0; prev && i < prev->num_tables && slot < 0; ++i )
+    {
+        slot = prev->tables[ i ].types == types ? i : -1;
+    }
+    if ( slot < 0 )
+    {
+        return;
+    }
+
+    int32_t          num_tables = prev->num_tables - 1;
+    cf_type_table_t* tables     = (cf_type_table_t*)malloc( ( num_tables + 1 ) * sizeof( cf_type_table_t ) );
+    if ( tables )
+    {
+        memcpy( tables, prev->tables, slot * sizeof( cf_type_table_t ) );
+        memcpy( tables + slot, prev->tables + slot + 1, ( num_tables - slot ) * sizeof( cf_type_table_t ) );
+
+        cf_snapshot_t* snapshot = cf_snapshot_build( prev, tables, num_tables );
+        if ( snapshot )
+        {
+            cf_snapshot_number_hierarchy( snapshot );
+            snapshot->relations = cf_relations_build( snapshot );
+            cf_publish( snapshot );
+        }
+        free( tables );
+    }
+}
+
+// --- Linker Sections ---
+
+#if defined( CFLEX_LINKER_SECTIONS )
+#    if defined( _MSC_VER )
+// The linker sorts ".cflex$<x>" sections by suffix and merges them, so module entries
+// (".cflex$m") land between these markers. Incremental linking may pad with zeros.
+#        pragma section( ".cflex$a", read )
+#        pragma section( ".cflex$z", read )
+__declspec( allocate( ".cflex$a" ) ) static const cf_module_t* const cf_modules_begin[ 1 ] = { NULL };
+__declspec( allocate( ".cflex$z" ) ) static const cf_module_t* const cf_modules_end[ 1 ]   = { NULL };
+#        define CF_MODULES_FIRST ( cf_modules_begin + 1 )
+#        define CF_MODULES_LAST  ( cf_modules_end )
+#    elif defined( __APPLE__ )
+extern const cf_module_t* const cf_modules_start[] __asm__( "section$start$__DATA$cflex_modules" );
+extern const cf_module_t* const cf_modules_stop[] __asm__( "section$end$__DATA$cflex_modules" );
+#        define CF_MODULES_FIRST ( cf_modules_start )
+#        define CF_MODULES_LAST  ( cf_modules_stop )
+#    else
+// Weak, so a program without any generated module still links.
+extern const cf_module_t* const __start_cflex_modules[] __attribute__( ( weak ) );
+extern const cf_module_t* const __stop_cflex_modules[] __attribute__( ( weak ) );
+#        define CF_MODULES_FIRST ( __start_cflex_modules )
+#        define CF_MODULES_LAST  ( __stop_cflex_modules )
+#    endif
+#endif
+
+// --- Primitive Types ---
+
+// clang-format off
+#define CF_DEFINE_PRIMITIVE( cf_name, c_name, prim_id )                          \
+    static cf_type_state_t cf_state_##cf_name = { .index = -1 };                 \
+    const cf_type_t        cf_type_##cf_name  = { .name  = #c_name,              \
+                                                  .kind  = CF_KIND_PRIMITIVE,    \
+                                                  .size  = sizeof( c_name ),     \
+                                                  .align = _Alignof( c_name ),   \
+                                                  .id    = CF_TYPE_ID_##cf_name, \
+                                                  .state = &cf_state_##cf_name,  \
+                                                  .prim  = prim_id };
+
+static cf_type_state_t cf_state_void = { .index = -1 };
+const cf_type_t        cf_type_void  = { .name  = "void",
+                                         .kind  = CF_KIND_PRIMITIVE,
+                                         .size  = 0,
+                                         .align = 0,
+                                         .id    = CF_TYPE_ID_void,
+                                         .state = &cf_state_void,
+                                         .prim  = CF_PRIM_VOID };
+
+CF_DEFINE_PRIMITIVE( bool, bool,        CF_PRIM_BOOL )
+CF_DEFINE_PRIMITIVE( char, char,        CF_PRIM_CHAR )
+CF_DEFINE_PRIMITIVE( i8,   int8_t,      CF_PRIM_I8   )
+CF_DEFINE_PRIMITIVE( i16,  int16_t,     CF_PRIM_I16  )
+CF_DEFINE_PRIMITIVE( i32,  int32_t,     CF_PRIM_I32  )
+CF_DEFINE_PRIMITIVE( i64,  int64_t,     CF_PRIM_I64  )
+CF_DEFINE_PRIMITIVE( u8,   uint8_t,     CF_PRIM_U8   )
+CF_DEFINE_PRIMITIVE( u16,  uint16_t,    CF_PRIM_U16  )
+CF_DEFINE_PRIMITIVE( u32,  uint32_t,    CF_PRIM_U32  )
+CF_DEFINE_PRIMITIVE( u64,  uint64_t,    CF_PRIM_U64  )
+CF_DEFINE_PRIMITIVE( f32,  float,       CF_PRIM_F32  )
+CF_DEFINE_PRIMITIVE( f64,  double,      CF_PRIM_F64  )
+CF_DEFINE_PRIMITIVE( cstr, const char*, CF_PRIM_CSTR )
+// clang-format on
+
+#undef CF_DEFINE_PRIMITIVE
+
+static const cf_type_t* cf_primitive_types[] = {
+    &cf_type_void, &cf_type_bool, &cf_type_char, &cf_type_i8,  &cf_type_i16, &cf_type_i32, &cf_type_i64,
+    &cf_type_u8,   &cf_type_u16,  &cf_type_u32,  &cf_type_u64, &cf_type_f32, &cf_type_f64, &cf_type_cstr,
+};
+
+#define CF_NUM_PRIMITIVE_TYPES \
+    ( (int32_t)( sizeof( cf_primitive_types ) / sizeof( cf_primitive_types[ 0 ] ) ) )
+
+// --- Built-in Tables ---
+
+// Registers the primitive types and every module table placed in the linker section,
+// once. The first query (or write) pays for it; startup does nothing. Must hold the
+// write lock.
+static void
+cf_load_builtin_tables_locked( void )
+{
+    if ( g_registry.builtins_loaded )
+    {
+        return;
+    }
+
+    cf_type_table_t primitives = { cf_primitive_types, CF_NUM_PRIMITIVE_TYPES };
+    cf_add_tables_locked( &primitives, 1 );
+
+#if defined( CFLEX_LINKER_SECTIONS )
+    const cf_module_t* const* first = CF_MODULES_FIRST;
+    const cf_module_t* const* last  = CF_MODULES_LAST;
+    int32_t                   count = first && last > first ? (int32_t)( last - first ) : 0;
+    if ( count > 0 )
+    {
+        cf_type_table_t* tables = (cf_type_table_t*)malloc( count * sizeof( cf_type_table_t ) );
+        if ( !tables )
+        {
+            return;
+        }
+
+        int32_t num_tables = 0;
+        for ( int32_t i = 0; i < count; ++i )
+        {
+            const cf_module_t* module = first[ i ];
+            if ( module && module->packed && module->packed->num_types > 0 )
+            {
+                cf_packed_entry_t* entry = cf_packed_get_locked( module->packed, true );
+                if ( entry )
+                {
+                    tables[ num_tables ].types = entry->types;
+                    tables[ num_tables ].count = module->packed->num_types;
+                    num_tables++;
+                }
+            }
+            else if ( module && module->types && module->count > 0 )
+            {
+                tables[ num_tables ].types = module->types;
+                tables[ num_tables ].count = module->count;
+                num_tables++;
+            }
+        }
+        cf_add_tables_locked( tables, num_tables );
+        free( tables );
+    }
+#endif
+
+    cf_atomic_store_u32( &g_registry.builtins_loaded, 1 );
+}
+
+// Makes sure the built-in tables are registered before a lookup.
+static void
+cf_load_builtin_tables( void )
+{
+    if ( !cf_atomic_load_u32( &g_registry.builtins_loaded ) )
+    {
+        cf_spin_lock( &g_registry.write_lock );
+        cf_load_builtin_tables_locked();
+        cf_spin_unlock( &g_registry.write_lock );
+    }
+}
+
+// --- Flattened Layouts ---
+
+// Nested struct fields deeper than this are not expanded. C structs cannot nest by value
+// without end, so this only guards against cycles in hand-built descriptors.
+#define CF_LAYOUT_MAX_DEPTH 32
+
+// One step of a copy plan: `size` bytes at `offset` in the object, or a string if `size`
+// is 0. Adjacent leaves share a step, so a struct without padding or strings is one step.
+typedef struct cf_copy_op_t
+{
+    int32_t offset;
+    int32_t size;
+} cf_copy_op_t;
+
+// The cached leaves of a struct and the copy plan built from them. Allocated as a single
+// block together with the leaves, the plan and the paths, and kept in the type's state
+// while the type is registered.
+typedef struct cf_layout_t
+{
+    const cf_leaf_t* leaves;
+    int32_t          count;
+
+    const cf_copy_op_t* ops;
+    int32_t             num_ops;
+    int32_t             record_size;    // Serialized bytes per object, excluding string characters
+    bool                has_strings;
+    uint64_t            fingerprint;    // See cf_get_fingerprint()
+} cf_layout_t;
+
+typedef struct cf_layout_builder_t
+{
+    cf_leaf_t*  leaves;    // NULL while counting
+    char*       paths;     // NULL while counting
+    int32_t     num_leaves;
+    size_t      paths_size;
+    bool        resolved;    // Every field type on the way is known
+    const char* names[ CF_LAYOUT_MAX_DEPTH ];
+    uint64_t    hashes[ CF_LAYOUT_MAX_DEPTH ];    // Path hashes of the fields on the way
+} cf_layout_builder_t;
+
+// Returns the integer primitive an enum is stored as.
+static cf_prim_t
+cf_enum_prim( const cf_type_t* type )
+{
+    return type->size == 1   ? CF_PRIM_I8
+           : type->size == 2 ? CF_PRIM_I16
+           : type->size == 8 ? CF_PRIM_I64
+                             : CF_PRIM_I32;
+}
+
+// The hash of a field path: the name hash of a top-level field, and for nested fields the
+// parent's path hash mixed with the field's name hash. Name hashes are known with and without
+// --strip-names, so paths hash alike in both builds.
+static uint64_t
+cf_path_hash( const cf_field_t* field, const uint64_t* parent )
+{
+    uint64_t name_hash = field->name ? cf_hash_name( field->name ) : field->name_hash;
+    return parent ? cf_hash_bits( *parent, &name_hash, sizeof( name_hash ) ) : name_hash;
+}
+
+// Hashes what the layout of a type is made of: its size and each leaf's path, offset, size
+// and primitive.
+static uint64_t
+cf_fingerprint_leaves( int32_t type_size, const cf_leaf_t* leaves, int32_t count )
+{
+    uint64_t hash = cf_hash_bits( CF_OBJECT_HASH_SEED, &type_size, sizeof( type_size ) );
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        uint64_t place = (uint64_t)(uint32_t)leaves[ i ].offset << 32 | (uint32_t)leaves[ i ].size;
+        uint64_t prim  = (uint64_t)leaves[ i ].prim;
+        hash           = cf_hash_bits( hash, &leaves[ i ].path_hash, sizeof( uint64_t ) );
+        hash           = cf_hash_bits( hash, &place, sizeof( place ) );
+        hash           = cf_hash_bits( hash, &prim, sizeof( prim ) );
+    }
+    return hash;
+}
+
+// Counts (or, once the builder has storage, writes) the leaves of a struct at `offset`.
+static void
+cf_layout_visit( cf_layout_builder_t* builder, const cf_type_t* type, int32_t offset, int32_t depth )
+{
+    for ( int32_t i = 0; i < type->struct_count; ++i )
+    {
+        const cf_field_t* field      = &type->struct_array[ i ];
+        const cf_type_t*  field_type = field->type;
+        if ( !field_type )
+        {
+            builder->resolved = false;
+            continue;
+        }
+
+        builder->names[ depth ]  = field->name;
+        builder->hashes[ depth ] = cf_path_hash( field, depth > 0 ? &builder->hashes[ depth - 1 ] : NULL );
+        if ( field_type->kind == CF_KIND_STRUCT )
+        {
+            if ( depth + 1 < CF_LAYOUT_MAX_DEPTH )
+            {
+                cf_layout_visit( builder, field_type, offset + field->offset, depth + 1 );
+            }
+            continue;
+        }
+
+        bool   named     = true;
+        size_t path_size = 0;
+        for ( int32_t d = 0; d <= depth; ++d )
+        {
+            named = named && builder->names[ d ];
+            path_size += builder->names[ d ] ? strlen( builder->names[ d ] ) + 1 : 1;
+        }
+
+        if ( builder->leaves )
+        {
+            cf_leaf_t* leaf = &builder->leaves[ builder->num_leaves ];
+            leaf->offset    = offset + field->offset;
+            leaf->size      = field_type->size;
+            leaf->prim =
+                field_type->kind == CF_KIND_PRIMITIVE ? field_type->prim : cf_enum_prim( field_type );
+            leaf->type      = field_type;
+            leaf->path      = NULL;
+            leaf->path_hash = builder->hashes[ depth ];
+            if ( named )
+            {
+                char* path = builder->paths + builder->paths_size;
+                leaf->path = path;
+                for ( int32_t d = 0; d <= depth; ++d )
+                {
+                    size_t len = strlen( builder->names[ d ] );
+                    memcpy( path, builder->names[ d ], len );
+                    path += len;
+                    *path++ = d < depth ? '.' : '\0';
+                }
+            }
+        }
+        builder->num_leaves++;
+        builder->paths_size += path_size;
+    }
+}
+
+// Builds the leaves of a struct. Returns NULL if a field type is not known yet or on
+// allocation failure.
+static cf_layout_t*
+cf_layout_build( const cf_type_t* type )
+{
+    cf_layout_builder_t builder = { 0 };
+    builder.resolved            = true;
+    cf_layout_visit( &builder, type, 0, 0 );
+    if ( !builder.resolved )
+    {
+        return NULL;
+    }
+
+    // Field types never change once resolved, so the second walk visits the same leaves.
+    size_t   head_size   = cf_align_size( sizeof( cf_layout_t ) );
+    size_t   leaves_size = cf_align_size( builder.num_leaves * sizeof( cf_leaf_t ) );
+    size_t   ops_size    = cf_align_size( builder.num_leaves * sizeof( cf_copy_op_t ) );
+    uint8_t* block       = (uint8_t*)calloc( 1, head_size + leaves_size + ops_size + builder.paths_size );
+    if ( !block )
+    {
+        return NULL;
+    }
+
+    cf_layout_t* layout = (cf_layout_t*)block;
+    builder.leaves      = (cf_leaf_t*)( block + head_size );
+    builder.paths       = (char*)( block + head_size + leaves_size + ops_size );
+    builder.num_leaves  = 0;
+    builder.paths_size  = 0;
+    cf_layout_visit( &builder, type, 0, 0 );
+
+    layout->leaves = builder.leaves;
+    layout->count  = builder.num_leaves;
+
+    // The copy plan: leaves in declaration order, with each leaf that starts where the
+    // previous one ends merged into its step. Padding falls between steps.
+    cf_copy_op_t* ops = (cf_copy_op_t*)( block + head_size + leaves_size );
+    for ( int32_t i = 0; i < layout->count; ++i )
+    {
+        const cf_leaf_t* leaf = &layout->leaves[ i ];
+        cf_copy_op_t*    last = layout->num_ops > 0 ? &ops[ layout->num_ops - 1 ] : NULL;
+        if ( leaf->prim == CF_PRIM_CSTR )
+        {
+            ops[ layout->num_ops ].offset = leaf->offset;
+            ops[ layout->num_ops ].size   = 0;
+            layout->num_ops++;
+            layout->record_size += (int32_t)sizeof( uint32_t );
+            layout->has_strings = true;
+        }
+        else if ( leaf->size > 0 )
+        {
+            if ( last && last->size > 0 && last->offset + last->size == leaf->offset )
+            {
+                last->size += leaf->size;
+            }
+            else
+            {
+                ops[ layout->num_ops ].offset = leaf->offset;
+                ops[ layout->num_ops ].size   = leaf->size;
+                layout->num_ops++;
+            }
+            layout->record_size += leaf->size;
+        }
+    }
+    layout->ops         = ops;
+    layout->fingerprint = cf_fingerprint_leaves( type->size, layout->leaves, layout->count );
+    return layout;
+}
+
+// Returns the cached layout of a registered struct, building it on first use. Returns NULL
+// for other types, if a field type is not known yet or on allocation failure.
+static const cf_layout_t*
+cf_layout_get( const cf_type_t* type )
+{
+    if ( !type || type->kind != CF_KIND_STRUCT || !type->state )
+    {
+        return NULL;
+    }
+
+    void* volatile*    slot   = (void* volatile*)&type->state->layout;
+    const cf_layout_t* layout = (const cf_layout_t*)cf_atomic_load_ptr( slot );
+    if ( layout )
+    {
+        return layout;
+    }
+
+    // Cache it only from a read section that sees the type registered; cf_publish() waits
+    // for the section before it drops the layouts of unregistered types.
+    const cf_snapshot_t* snapshot = cf_read_begin();
+    if ( snapshot && cf_snapshot_lists( snapshot, type ) )
+    {
+        cf_layout_t* built = cf_layout_build( type );
+
+        // Another thread may have built it at the same time; the first one wins.
+        if ( built && !cf_atomic_cas_ptr( slot, NULL, built ) )
+        {
+            free( built );
+        }
+        layout = (const cf_layout_t*)cf_atomic_load_ptr( slot );
+    }
+    cf_read_end();
+    return layout;
+}
+
+// Frees the cached layout of a type that has been dropped from the registry. Must hold the
+// write lock, after the readers that saw the type registered have left.
+static void
+cf_layout_drop( const cf_type_t* type )
+{
+    if ( type->state && type->state->layout )
+    {
+        cf_layout_t* layout = (cf_layout_t*)type->state->layout;
+        cf_atomic_store_ptr( (void* volatile*)&type->state->layout, NULL );
+        free( layout );
+    }
+}
+
+// --- Field Paths ---
+
+// Copies `count` elements of `size` bytes between two strided arrays. The common sizes get
+// a constant-size copy, which compiles to a single load and store.
+static void
+cf_copy_strided(
+    uint8_t* dst, size_t dst_stride, const uint8_t* src, size_t src_stride, size_t size, int32_t count )
+{
+#define CF_COPY_STRIDED_LOOP( copy_size )                                       \
+    for ( int32_t i = 0; i < count; ++i, dst += dst_stride, src += src_stride ) \
+    {                                                                           \
+        memcpy( dst, src, copy_size );                                          \
+    }
+
+    switch ( size )
+    {
+        case 1: CF_COPY_STRIDED_LOOP( 1 ); break;
+        case 2: CF_COPY_STRIDED_LOOP( 2 ); break;
+        case 4: CF_COPY_STRIDED_LOOP( 4 ); break;
+        case 8: CF_COPY_STRIDED_LOOP( 8 ); break;
+        default: CF_COPY_STRIDED_LOOP( size ); break;
+    }
+
+#undef CF_COPY_STRIDED_LOOP
+}
+
+// --- Serialization ---
+
+#define CF_NULL_STRING 0xffffffffu    // Length prefix of a NULL string
+
+// How to move the values of one object, see cf_layout_t.
+typedef struct cf_plan_t
+{
+    const cf_copy_op_t* ops;
+    int32_t             num_ops;
+    int32_t             record_size;
+    int32_t             type_size;
+    bool                has_strings;
+    const cf_leaf_t*    leaves;    // Unmerged steps, which cf_hash_object() mixes one by one
+    int32_t             num_leaves;
+    uint64_t            fingerprint;
+    cf_layout_t*        temporary;    // Layout to free after use, for structs without state
+    cf_copy_op_t        single_op;    // The one step of a primitive or enum
+    cf_leaf_t           single_leaf;
+} cf_plan_t;
+
+// Gets the copy plan of a type. Structs use their cached layout; primitives and enums are a
+// single step. Returns false for void and for structs with unresolved fields.
+static bool
+cf_plan_get( const cf_type_t* type, cf_plan_t* plan )
+{
+    memset( plan, 0, sizeof( *plan ) );
+    if ( !type )
+    {
+        return false;
+    }
+
+    plan->type_size = type->size;
+    if ( type->kind != CF_KIND_STRUCT )
+    {
+        bool is_string         = type->kind == CF_KIND_PRIMITIVE && type->prim == CF_PRIM_CSTR;
+        plan->single_op.offset = 0;
+        plan->single_op.size   = is_string ? 0 : type->size;
+        plan->ops              = &plan->single_op;
+        plan->num_ops          = 1;
+        plan->record_size      = is_string ? (int32_t)sizeof( uint32_t ) : type->size;
+        plan->has_strings      = is_string;
+        plan->single_leaf.size = type->size;
+        plan->single_leaf.prim = type->kind == CF_KIND_ENUM ? cf_enum_prim( type ) : type->prim;
+        plan->single_leaf.type = type;
+        plan->leaves           = &plan->single_leaf;
+        plan->num_leaves       = 1;
+        plan->fingerprint      = cf_fingerprint_leaves( type->size, plan->leaves, 1 );
+        return is_string || type->size > 0;
+    }
+
+    const cf_layout_t* layout = cf_layout_get( type );
+    if ( !layout )
+    {
+        plan->temporary = cf_layout_build( type );
+        layout          = plan->temporary;
+    }
+    if ( !layout )
+    {
+        return false;
+    }
+
+    plan->ops         = layout->ops;
+    plan->num_ops     = layout->num_ops;
+    plan->record_size = layout->record_size;
+    plan->has_strings = layout->has_strings;
+    plan->leaves      = layout->leaves;
+    plan->num_leaves  = layout->count;
+    plan->fingerprint = layout->fingerprint;
+    return true;
+}
+
+static void
+cf_plan_release( cf_plan_t* plan )
+{
+    free( plan->temporary );
+    plan->temporary = NULL;
+}
+
+// A plan that is a single step over the whole object copies arrays in one memcpy.
+static bool
+cf_plan_is_flat( const cf_plan_t* plan )
+{
+    return plan->num_ops == 1 && plan->ops[ 0 ].size == plan->type_size;
+}
+
+// Runs a plan over `count` objects. With a NULL `out`, only measures.
+static size_t
+cf_plan_write( const cf_plan_t* plan, const uint8_t* objects, int32_t count, uint8_t* out, size_t out_size )
+{
+    size_t size = 0;
+    for ( int32_t i = 0; i < count; ++i, objects += plan->type_size )
+    {
+        for ( int32_t j = 0; j < plan->num_ops; ++j )
+        {
+            const cf_copy_op_t* op = &plan->ops[ j ];
+            if ( op->size > 0 )
+            {
+                if ( out )
+                {
+                    if ( out_size - size < (size_t)op->size )
+                    {
+                        return 0;
+                    }
+                    memcpy( out + size, objects + op->offset, (size_t)op->size );
+                }
+                size += (size_t)op->size;
+                continue;
+            }
+
+            const char* str;
+            memcpy( &str, objects + op->offset, sizeof( str ) );
+            size_t   length = str ? strlen( str ) : 0;
+            uint32_t prefix = str ? (uint32_t)length : CF_NULL_STRING;
+            size_t   bytes  = sizeof( prefix ) + ( str ? length + 1 : 0 );
+            if ( str && length >= CF_NULL_STRING )
+            {
+                return 0;
+            }
+            if ( out )
+            {
+                if ( out_size - size < bytes )
+                {
+                    return 0;
+                }
+                memcpy( out + size, &prefix, sizeof( prefix ) );
+                if ( str )
+                {
+                    memcpy( out + size + sizeof( prefix ), str, length + 1 );
+                }
+            }
+            size += bytes;
+        }
+    }
+    return size;
+}
+
+// Reads `count` objects written by cf_plan_write(). With `swapped`, the string length
+// prefixes are in the other byte order. Returns 0 if the data is truncated.
+static size_t
+cf_plan_read(
+    const cf_plan_t* plan, uint8_t* objects, int32_t count, const uint8_t* in, size_t in_size, bool swapped )
+{
+    size_t size = 0;
+    for ( int32_t i = 0; i < count; ++i, objects += plan->type_size )
+    {
+        for ( int32_t j = 0; j < plan->num_ops; ++j )
+        {
+            const cf_copy_op_t* op = &plan->ops[ j ];
+            if ( op->size > 0 )
+            {
+                if ( in_size - size < (size_t)op->size )
+                {
+                    return 0;
+                }
+                memcpy( objects + op->offset, in + size, (size_t)op->size );
+                size += (size_t)op->size;
+                continue;
+            }
+
+            // Strings point into the buffer; the writer included their terminators.
+            uint32_t    prefix;
+            const char* str = NULL;
+            if ( in_size - size < sizeof( prefix ) )
+            {
+                return 0;
+            }
+            memcpy( &prefix, in + size, sizeof( prefix ) );
+            prefix = swapped ? cf_bswap32( prefix ) : prefix;
+            size += sizeof( prefix );
+            if ( prefix != CF_NULL_STRING )
+            {
+                if ( in_size - size <= (size_t)prefix || in[ size + prefix ] != '\0' )
+                {
+                    return 0;
+                }
+                str = (const char*)( in + size );
+                size += (size_t)prefix + 1;
+            }
+            memcpy( objects + op->offset, &str, sizeof( str ) );
+        }
+    }
+    return size;
+}
+
+// Returns the generated functions of a CF_STRUCT( codegen ) struct, or NULL.
+static const cf_struct_funcs_t*
+cf_struct_funcs( const cf_type_t* type )
+{
+    return type && type->kind == CF_KIND_STRUCT ? type->struct_funcs : NULL;
+}
+
+// Mixes a string into an object hash: its length (CF_NULL_STRING for NULL), then its
+// characters in blocks of 8.
+static uint64_t
+cf_hash_string( uint64_t hash, const char* str )
+{
+    size_t   length = str ? strlen( str ) : 0;
+    uint32_t prefix = str ? (uint32_t)length : CF_NULL_STRING;
+    hash            = cf_hash_bits( hash, &prefix, sizeof( prefix ) );
+    for ( size_t i = 0; i < length; i += 8 )
+    {
+        hash = cf_hash_bits( hash, str + i, length - i < 8 ? length - i : 8 );
+    }
+    return hash;
+}
+
+// --- JSON Scanning ---
+
+#define CF_JSON_MAX_DEPTH 64    // Nesting of skipped (unknown) values
+
+// The powers of ten that are exact doubles.
+static const double cf_json_powers[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+// The decimal separator snprintf() writes and strtod() reads: LC_NUMERIC's, which is not
+// always the '.' of JSON. Numbers are translated around those calls.
+static const char*
+cf_json_decimal_point( void )
+{
+    const char* point = localeconv()->decimal_point;
+    return point && point[ 0 ] ? point : ".";
+}
+
+static bool
+cf_json_is_space( char c )
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Skips whitespace. Values are usually separated by a character or two, so the vector loop
+// only starts for runs of indentation.
+static const char*
+cf_json_skip_space( const char* p, const char* end )
+{
+#if CF_HAS_AVX2
+    while ( end - p >= 32 && cf_json_is_space( *p ) )
+    {
+        __m256i chunk = _mm256_loadu_si256( (const __m256i*)p );
+        __m256i space =
+            _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( ' ' ) ),
+                                              _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( '\n' ) ) ),
+                             _mm256_or_si256( _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( '\r' ) ),
+                                              _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( '\t' ) ) ) );
+        uint32_t mask = ~(uint32_t)_mm256_movemask_epi8( space );
+        if ( mask )
+        {
+            return p + cf_ctz32( mask );
+        }
+        p += 32;
+    }
+#endif
+#if CF_HAS_SSE2
+    while ( end - p >= 16 && cf_json_is_space( *p ) )
+    {
+        __m128i  chunk = _mm_loadu_si128( (const __m128i*)p );
+        __m128i  space = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( ' ' ) ),
+                                                     _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\n' ) ) ),
+                                       _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\r' ) ),
+                                                     _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\t' ) ) ) );
+        uint32_t mask  = ~(uint32_t)_mm_movemask_epi8( space ) & 0xffffu;
+        if ( mask )
+        {
+            return p + cf_ctz32( mask );
+        }
+        p += 16;
+    }
+#endif
+    while ( p < end && cf_json_is_space( *p ) ) { ++p; }
+    return p;
+}
+
+// Returns the first quote, backslash or control character in [p, end), or `end`. These end
+// a run of characters that a string copies as is, in either direction.
+static const char*
+cf_json_scan_string( const char* p, const char* end )
+{
+#if CF_HAS_AVX2
+    for ( ; end - p >= 32; p += 32 )
+    {
+        __m256i chunk = _mm256_loadu_si256( (const __m256i*)p );
+        __m256i control =
+            _mm256_cmpeq_epi8( _mm256_max_epu8( chunk, _mm256_set1_epi8( 0x1f ) ), _mm256_set1_epi8( 0x1f ) );
+        __m256i  special = _mm256_or_si256( _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( '"' ) ),
+                                            _mm256_cmpeq_epi8( chunk, _mm256_set1_epi8( '\\' ) ) );
+        uint32_t mask    = (uint32_t)_mm256_movemask_epi8( _mm256_or_si256( control, special ) );
+        if ( mask )
+        {
+            return p + cf_ctz32( mask );
+        }
+    }
+#endif
+#if CF_HAS_SSE2
+    for ( ; end - p >= 16; p += 16 )
+    {
+        __m128i chunk = _mm_loadu_si128( (const __m128i*)p );
+        __m128i control =
+            _mm_cmpeq_epi8( _mm_max_epu8( chunk, _mm_set1_epi8( 0x1f ) ), _mm_set1_epi8( 0x1f ) );
+        __m128i  special = _mm_or_si128( _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '"' ) ),
+                                         _mm_cmpeq_epi8( chunk, _mm_set1_epi8( '\\' ) ) );
+        uint32_t mask    = (uint32_t)_mm_movemask_epi8( _mm_or_si128( control, special ) );
+        if ( mask )
+        {
+            return p + cf_ctz32( mask );
+        }
+    }
+#endif
+    while ( p < end && *p != '"' && *p != '\\' && (unsigned char)*p >= 0x20 ) { ++p; }
+    return p;
+}
+
+// --- JSON Writer ---
+
+// Makes room for `size` more bytes, flushing if needed. Returns NULL once the writer failed.
+static char*
+cf_json_reserve( cf_json_writer_t* writer, size_t size )
+{
+    if ( !writer->failed && writer->capacity - writer->used < size )
+    {
+        if ( !writer->flush || !cf_json_writer_flush( writer ) || writer->capacity < size )
+        {
+            writer->failed = true;
+        }
+    }
+    return writer->failed ? NULL : writer->buffer + writer->used;
+}
+
+static void
+cf_json_commit( cf_json_writer_t* writer, size_t size )
+{
+    writer->used += size;
+    writer->total += size;
+}
+
+// Copies text of any length, flushing as often as needed.
+static void
+cf_json_put( cf_json_writer_t* writer, const char* data, size_t size )
+{
+    while ( size > 0 && cf_json_reserve( writer, 1 ) )
+    {
+        size_t room  = writer->capacity - writer->used;
+        size_t bytes = size < room ? size : room;
+        memcpy( writer->buffer + writer->used, data, bytes );
+        cf_json_commit( writer, bytes );
+        data += bytes;
+        size -= bytes;
+    }
+}
+
+static void
+cf_json_put_char( cf_json_writer_t* writer, char c )
+{
+    char* out = cf_json_reserve( writer, 1 );
+    if ( out )
+    {
+        *out = c;
+        cf_json_commit( writer, 1 );
+    }
+}
+
+static void
+cf_json_put_u64( cf_json_writer_t* writer, uint64_t value, bool negative )
+{
+    char  digits[ 24 ];
+    char* p = digits + sizeof( digits );
+    do {
+        *--p = (char)( '0' + value % 10 );
+        value /= 10;
+    }
+    while ( value );
+    if ( negative )
+    {
+        *--p = '-';
+    }
+    cf_json_put( writer, p, (size_t)( digits + sizeof( digits ) - p ) );
+}
+
+static void
+cf_json_put_i64( cf_json_writer_t* writer, int64_t value )
+{
+    cf_json_put_u64( writer, value < 0 ? 0 - (uint64_t)value : (uint64_t)value, value < 0 );
+}
+
+// Writes a float so that it reads back as the same value.
+static void
+cf_json_put_double( cf_json_writer_t* writer, double value, bool is_f32 )
+{
+    if ( !isfinite( value ) )
+    {
+        cf_json_put( writer, "null", 4 );
+        return;
+    }
+
+    // Whole numbers and short decimals, the common case, skip printf: the value scaled by
+    // 10^digits is a whole number whose division by 10^digits gives the value back, which is
+    // how the reader parses it.
+    double magnitude = fabs( value );
+    for ( int32_t digits = 0; digits <= 9 && magnitude * cf_json_powers[ digits ] < 9007199254740992.0;
+          ++digits )
+    {
+        double scaled = (double)(int64_t)( magnitude * cf_json_powers[ digits ] + 0.5 );
+        double parsed = scaled / cf_json_powers[ digits ];
+        if ( is_f32 ? (float)parsed != (float)magnitude : parsed != magnitude )
+        {
+            continue;
+        }
+
+        char     text[ 32 ];
+        char*    p     = text + sizeof( text );
+        uint64_t whole = (uint64_t)scaled;
+        for ( int32_t i = 0; i < digits; ++i, whole /= 10 ) { *--p = (char)( '0' + whole % 10 ); }
+        if ( digits > 0 )
+        {
+            *--p = '.';
+        }
+        do {
+            *--p = (char)( '0' + whole % 10 );
+            whole /= 10;
+        }
+        while ( whole );
+        if ( signbit( value ) )
+        {
+            *--p = '-';
+        }
+        cf_json_put( writer, p, (size_t)( text + sizeof( text ) - p ) );
+        return;
+    }
+
+    // 9 significant digits identify a float, 17 a double.
+    char        text[ 32 ];
+    int         length = snprintf( text, sizeof( text ), "%.*g", is_f32 ? 9 : 17, value );
+    const char* point  = cf_json_decimal_point();
+    char*       found  = strcmp( point, "." ) != 0 ? strstr( text, point ) : NULL;
+    if ( found )
+    {
+        size_t point_length = strlen( point );
+        *found              = '.';
+        memmove( found + 1, found + point_length,
+                 (size_t)length - (size_t)( found - text ) - point_length + 1 );
+        length -= (int)point_length - 1;
+    }
+    cf_json_put( writer, text, (size_t)length );
+}
+
+static void
+cf_json_put_string( cf_json_writer_t* writer, const char* str, size_t length )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    const char* end         = str + length;
+    cf_json_put_char( writer, '"' );
+    while ( str < end )
+    {
+        const char* run = cf_json_scan_string( str, end );
+        cf_json_put( writer, str, (size_t)( run - str ) );
+        if ( run == end )
+        {
+            break;
+        }
+
+        unsigned char c           = (unsigned char)*run;
+        char          escape[ 6 ] = { '\\', (char)c, '0', '0', 0, 0 };
+        size_t        size        = 2;
+        switch ( c )
+        {
+            case '"':
+            case '\\': break;
+            case '\b': escape[ 1 ] = 'b'; break;
+            case '\f': escape[ 1 ] = 'f'; break;
+            case '\n': escape[ 1 ] = 'n'; break;
+            case '\r': escape[ 1 ] = 'r'; break;
+            case '\t': escape[ 1 ] = 't'; break;
+            default:
+                escape[ 1 ] = 'u';
+                escape[ 4 ] = hex[ c >> 4 ];
+                escape[ 5 ] = hex[ c & 15 ];
+                size        = 6;
+                break;
+        }
+        cf_json_put( writer, escape, size );
+        str = run + 1;
+    }
+    cf_json_put_char( writer, '"' );
+}
+
+static void
+cf_json_put_primitive( cf_json_writer_t* writer, cf_prim_t prim, const uint8_t* object )
+{
+    switch ( prim )
+    {
+        case CF_PRIM_BOOL:
+            *(const bool*)object ? cf_json_put( writer, "true", 4 ) : cf_json_put( writer, "false", 5 );
+            break;
+        case CF_PRIM_CHAR: cf_json_put_i64( writer, *(const char*)object ); break;
+        case CF_PRIM_I8: cf_json_put_i64( writer, *(const int8_t*)object ); break;
+        case CF_PRIM_I16: cf_json_put_i64( writer, *(const int16_t*)object ); break;
+        case CF_PRIM_I32: cf_json_put_i64( writer, *(const int32_t*)object ); break;
+        case CF_PRIM_I64: cf_json_put_i64( writer, *(const int64_t*)object ); break;
+        case CF_PRIM_U8: cf_json_put_u64( writer, *(const uint8_t*)object, false ); break;
+        case CF_PRIM_U16: cf_json_put_u64( writer, *(const uint16_t*)object, false ); break;
+        case CF_PRIM_U32: cf_json_put_u64( writer, *(const uint32_t*)object, false ); break;
+        case CF_PRIM_U64: cf_json_put_u64( writer, *(const uint64_t*)object, false ); break;
+        case CF_PRIM_F32: cf_json_put_double( writer, *(const float*)object, true ); break;
+        case CF_PRIM_F64: cf_json_put_double( writer, *(const double*)object, false ); break;
+        case CF_PRIM_CSTR:
+        {
+            const char* str = *(const char* const*)object;
+            str ? cf_json_put_string( writer, str, strlen( str ) ) : cf_json_put( writer, "null", 4 );
+            break;
+        }
+        default: writer->failed = true; break;
+    }
+}
+
+// Loads an enum stored in `type->size` bytes.
+static int64_t
+cf_json_load_enum( const cf_type_t* type, const uint8_t* object )
+{
+    switch ( cf_enum_prim( type ) )
+    {
+        case CF_PRIM_I8: return *(const int8_t*)object;
+        case CF_PRIM_I16: return *(const int16_t*)object;
+        case CF_PRIM_I64: return *(const int64_t*)object;
+        default: return *(const int32_t*)object;
+    }
+}
+
+static void
+cf_json_put_value( cf_json_writer_t* writer, const cf_type_t* type, const uint8_t* object, int32_t depth )
+{
+    if ( !type || depth > CF_LAYOUT_MAX_DEPTH )
+    {
+        writer->failed = true;
+        return;
+    }
+
+    if ( type->kind == CF_KIND_PRIMITIVE )
+    {
+        cf_json_put_primitive( writer, type->prim, object );
+    }
+    else if ( type->kind == CF_KIND_ENUM )
+    {
+        int64_t                value = cf_json_load_enum( type, object );
+        const cf_enum_value_t* entry = NULL;
+        if ( value >= INT32_MIN && value <= INT32_MAX )
+        {
+            entry = cf_find_enum_value_by_value( type, (int32_t)value );
+        }
+        if ( entry && entry->name )
+        {
+            cf_json_put_string( writer, entry->name, strlen( entry->name ) );
+        }
+        else
+        {
+            cf_json_put_i64( writer, value );
+        }
+    }
+    else if ( type->kind == CF_KIND_STRUCT )
+    {
+        cf_json_put_char( writer, '{' );
+        for ( int32_t i = 0; i < type->struct_count && !writer->failed; ++i )
+        {
+            const cf_field_t* field = &type->struct_array[ i ];
+            if ( !field->name )
+            {
+                writer->failed = true;
+                return;
+            }
+            if ( i > 0 )
+            {
+                cf_json_put_char( writer, ',' );
+            }
+            cf_json_put_string( writer, field->name, strlen( field->name ) );
+            cf_json_put_char( writer, ':' );
+            cf_json_put_value( writer, field->type, object + field->offset, depth + 1 );
+        }
+        cf_json_put_char( writer, '}' );
+    }
+    else
+    {
+        writer->failed = true;
+    }
+}
+
+// --- JSON Reader ---
+
+// A number as read: up to 19 significant digits and a power of ten.
+typedef struct cf_json_number_t
+{
+    uint64_t    mantissa;
+    int32_t     exponent;
+    int32_t     digits;    // Significant digits in the mantissa
+    bool        negative;
+    bool        is_integer;    // No fraction and no exponent
+    bool        truncated;     // Digits beyond the 19th were dropped
+    const char* start;
+    const char* end;
+} cf_json_number_t;
+
+// Records an error at `at`. Returns NULL, so callers can return its result.
+static const char*
+cf_json_fail( cf_json_reader_t* reader, const char* at, const char* message )
+{
+    reader->error = message;
+    reader->pos   = (size_t)( at - reader->json );
+    return NULL;
+}
+
+static bool
+cf_json_match( const char* p, const char* end, const char* literal, size_t length )
+{
+    return (size_t)( end - p ) >= length && memcmp( p, literal, length ) == 0;
+}
+
+#if CF_LITTLE_ENDIAN
+// True if all 8 bytes are ASCII digits.
+static bool
+cf_json_is_8_digits( uint64_t chunk )
+{
+    return ( ( chunk & 0xf0f0f0f0f0f0f0f0ull ) |
+             ( ( ( chunk + 0x0606060606060606ull ) & 0xf0f0f0f0f0f0f0f0ull ) >> 4 ) ) ==
+           0x3333333333333333ull;
+}
+
+// Converts 8 ASCII digits, the first in the lowest byte, with three multiplies.
+static uint32_t
+cf_json_parse_8_digits( uint64_t chunk )
+{
+    chunk -= 0x3030303030303030ull;
+    chunk = ( chunk * 10 ) + ( chunk >> 8 );
+    chunk = ( ( ( chunk & 0x000000ff000000ffull ) * ( 100 + ( 1000000ull << 32 ) ) ) +
+              ( ( ( chunk >> 16 ) & 0x000000ff000000ffull ) * ( 1 + ( 10000ull << 32 ) ) ) ) >>
+            32;
+    return (uint32_t)chunk;
+}
+#endif
+
+// Accumulates a run of digits into the mantissa. Digits after the decimal point lower the
+// exponent; integer digits that do not fit raise it.
+static const char*
+cf_json_parse_digits( const char* p, const char* end, cf_json_number_t* number, bool fraction )
+{
+#if CF_LITTLE_ENDIAN
+    while ( end - p >= 8 && number->digits <= 19 - 8 )
+    {
+        uint64_t chunk;
+        memcpy( &chunk, p, sizeof( chunk ) );
+        if ( !cf_json_is_8_digits( chunk ) )
+        {
+            break;
+        }
+        number->mantissa = number->mantissa * 100000000u + cf_json_parse_8_digits( chunk );
+        number->digits += number->mantissa ? 8 : 0;
+        number->exponent -= fraction ? 8 : 0;
+        p += 8;
+    }
+#endif
+    for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+        if ( number->digits < 19 )
+        {
+            number->mantissa = number->mantissa * 10 + (uint64_t)( *p - '0' );
+            number->digits += number->mantissa ? 1 : 0;
+            number->exponent -= fraction ? 1 : 0;
+        }
+        else
+        {
+            number->truncated = number->truncated || *p != '0';
+            number->exponent += fraction ? 0 : 1;
+        }
+    }
+    return p;
+}
+
+static const char*
+cf_json_parse_number( cf_json_reader_t* reader, const char* p, const char* end, cf_json_number_t* number )
+{
+    memset( number, 0, sizeof( *number ) );
+    number->start      = p;
+    number->is_integer = true;
+    if ( p < end && *p == '-' )
+    {
+        number->negative = true;
+        ++p;
+    }
+    if ( p == end || *p < '0' || *p > '9' )
+    {
+        return cf_json_fail( reader, number->start, "expected a number" );
+    }
+    p = *p == '0' ? p + 1 : cf_json_parse_digits( p, end, number, false );
+
+    if ( p < end && *p == '.' )
+    {
+        number->is_integer = false;
+        if ( ++p == end || *p < '0' || *p > '9' )
+        {
+            return cf_json_fail( reader, p, "expected a digit" );
+        }
+        p = cf_json_parse_digits( p, end, number, true );
+    }
+
+    if ( p < end && ( *p == 'e' || *p == 'E' ) )
+    {
+        number->is_integer = false;
+        bool negative      = ++p < end && *p == '-';
+        p += ( p < end && ( *p == '-' || *p == '+' ) ) ? 1 : 0;
+        if ( p == end || *p < '0' || *p > '9' )
+        {
+            return cf_json_fail( reader, p, "expected a digit" );
+        }
+        int32_t exponent = 0;
+        for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+        {
+            exponent = exponent < 100000 ? exponent * 10 + ( *p - '0' ) : exponent;
+        }
+        number->exponent += negative ? -exponent : exponent;
+    }
+
+    number->end = p;
+    return p;
+}
+
+// Converts to a signed integer of `bytes` bytes. Fails for fractions and out-of-range values.
+static bool
+cf_json_number_to_signed( const cf_json_number_t* number, int32_t bytes, int64_t* out )
+{
+    uint64_t limit = bytes >= 8 ? (uint64_t)INT64_MAX : ( 1ull << ( bytes * 8 - 1 ) ) - 1;
+    if ( !number->is_integer || number->truncated || number->exponent != 0 ||
+         number->mantissa > limit + ( number->negative ? 1 : 0 ) )
+    {
+        return false;
+    }
+    *out = number->negative ? (int64_t)( 0 - number->mantissa ) : (int64_t)number->mantissa;
+    return true;
+}
+
+static bool
+cf_json_number_to_unsigned( const cf_json_number_t* number, int32_t bytes, uint64_t* out )
+{
+    uint64_t limit = bytes >= 8 ? UINT64_MAX : ( 1ull << ( bytes * 8 ) ) - 1;
+    if ( !number->is_integer || number->truncated || number->exponent != 0 || number->mantissa > limit ||
+         ( number->negative && number->mantissa != 0 ) )
+    {
+        return false;
+    }
+    *out = number->mantissa;
+    return true;
+}
+
+// Exact when the mantissa and the power of ten are both exact doubles, which covers the
+// numbers writers produce for all but the longest fractions. Those go through strtod().
+static bool
+cf_json_number_to_double( const cf_json_number_t* number, double* out )
+{
+    if ( !number->truncated && number->mantissa <= ( 1ull << 53 ) && number->exponent >= -22 &&
+         number->exponent <= 22 )
+    {
+        double value = (double)number->mantissa;
+        value        = number->exponent < 0 ? value / cf_json_powers[ -number->exponent ]
+                                            : value * cf_json_powers[ number->exponent ];
+        *out         = number->negative ? -value : value;
+        return true;
+    }
+
+    // The number with LC_NUMERIC's separator in place of '.', as strtod() expects.
+    const char* point        = cf_json_decimal_point();
+    size_t      point_length = strlen( point );
+    char        text[ 128 ];
+    size_t      length = 0;
+    for ( const char* p = number->start; p < number->end; ++p )
+    {
+        if ( length + point_length >= sizeof( text ) )
+        {
+            return false;
+        }
+        if ( *p == '.' )
+        {
+            memcpy( text + length, point, point_length );
+            length += point_length;
+            continue;
+        }
+        text[ length++ ] = *p;
+    }
+    text[ length ] = '\0';
+    *out           = strtod( text, NULL );
+    return true;
+}
+
+static int32_t
+cf_json_hex_digit( char c )
+{
+    return c >= '0' && c <= '9'   ? c - '0'
+           : c >= 'a' && c <= 'f' ? c - 'a' + 10
+           : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                  : -1;
+}
+
+// Reads the 4 hex digits of a \u escape.
+static bool
+cf_json_parse_hex4( const char* p, const char* end, uint32_t* out )
+{
+    if ( end - p < 4 )
+    {
+        return false;
+    }
+    uint32_t value = 0;
+    for ( int32_t i = 0; i < 4; ++i )
+    {
+        int32_t digit = cf_json_hex_digit( p[ i ] );
+        if ( digit < 0 )
+        {
+            return false;
+        }
+        value = value << 4 | (uint32_t)digit;
+    }
+    *out = value;
+    return true;
+}
+
+// Decodes the string at `p` (its opening quote) into `out`, which holds `capacity` bytes.
+// Runs without escapes are copied as they are. Returns the position after the closing quote.
+static const char*
+cf_json_decode_string(
+    cf_json_reader_t* reader, const char* p, const char* end, char* out, size_t capacity, size_t* out_length )
+{
+    size_t length = 0;
+    for ( ++p;; )
+    {
+        const char* run  = cf_json_scan_string( p, end );
+        size_t      size = (size_t)( run - p );
+        if ( capacity - length < size )
+        {
+            return cf_json_fail( reader, p, "out of string storage" );
+        }
+        memcpy( out + length, p, size );
+        length += size;
+        p = run;
+
+        if ( p == end )
+        {
+            return cf_json_fail( reader, p, "unterminated string" );
+        }
+        if ( *p == '"' )
+        {
+            *out_length = length;
+            return p + 1;
+        }
+        if ( *p != '\\' )
+        {
+            return cf_json_fail( reader, p, "control character in string" );
+        }
+
+        // Escapes: at most 4 bytes of UTF-8 out.
+        if ( ++p == end )
+        {
+            return cf_json_fail( reader, p, "unterminated string" );
+        }
+        char     utf8[ 4 ];
+        size_t   size_utf8 = 1;
+        uint32_t code      = 0;
+        switch ( *p++ )
+        {
+            case '"': utf8[ 0 ] = '"'; break;
+            case '\\': utf8[ 0 ] = '\\'; break;
+            case '/': utf8[ 0 ] = '/'; break;
+            case 'b': utf8[ 0 ] = '\b'; break;
+            case 'f': utf8[ 0 ] = '\f'; break;
+            case 'n': utf8[ 0 ] = '\n'; break;
+            case 'r': utf8[ 0 ] = '\r'; break;
+            case 't': utf8[ 0 ] = '\t'; break;
+            case 'u':
+            {
+                if ( !cf_json_parse_hex4( p, end, &code ) )
+                {
+                    return cf_json_fail( reader, p, "invalid \\u escape" );
+                }
+                p += 4;
+
+                // A high surrogate must be followed by a low one.
+                uint32_t low;
+                if ( code >= 0xd800 && code <= 0xdbff )
+                {
+                    if ( !cf_json_match( p, end, "\\u", 2 ) || !cf_json_parse_hex4( p + 2, end, &low ) ||
+                         low < 0xdc00 || low > 0xdfff )
+                    {
+                        return cf_json_fail( reader, p, "unpaired surrogate" );
+                    }
+                    code = 0x10000 + ( ( code - 0xd800 ) << 10 ) + ( low - 0xdc00 );
+                    p += 6;
+                }
+                else if ( code >= 0xdc00 && code <= 0xdfff )
+                {
+                    return cf_json_fail( reader, p, "unpaired surrogate" );
+                }
+
+                if ( code < 0x80 )
+                {
+                    utf8[ 0 ] = (char)code;
+                }
+                else if ( code < 0x800 )
+                {
+                    utf8[ 0 ] = (char)( 0xc0 | code >> 6 );
+                    utf8[ 1 ] = (char)( 0x80 | ( code & 0x3f ) );
+                    size_utf8 = 2;
+                }
+                else if ( code < 0x10000 )
+                {
+                    utf8[ 0 ] = (char)( 0xe0 | code >> 12 );
+                    utf8[ 1 ] = (char)( 0x80 | ( ( code >> 6 ) & 0x3f ) );
+                    utf8[ 2 ] = (char)( 0x80 | ( code & 0x3f ) );
+                    size_utf8 = 3;
+                }
+                else
+                {
+                    utf8[ 0 ] = (char)( 0xf0 | code >> 18 );
+                    utf8[ 1 ] = (char)( 0x80 | ( ( code >> 12 ) & 0x3f ) );
+                    utf8[ 2 ] = (char)( 0x80 | ( ( code >> 6 ) & 0x3f ) );
+                    utf8[ 3 ] = (char)( 0x80 | ( code & 0x3f ) );
+                    size_utf8 = 4;
+                }
+                break;
+            }
+            default: return cf_json_fail( reader, p - 1, "invalid escape" );
+        }
+        if ( capacity - length < size_utf8 )
+        {
+            return cf_json_fail( reader, p, "out of string storage" );
+        }
+        memcpy( out + length, utf8, size_utf8 );
+        length += size_utf8;
+    }
+}
+
+// Reads a field name or enum name. Names without escapes are returned in place.
+static const char*
+cf_json_read_name( cf_json_reader_t* reader,
+                   const char*       p,
+                   const char*       end,
+                   char*             buffer,
+                   size_t            buffer_size,
+                   const char**      out_name,
+                   int32_t*          out_length )
+{
+    const char* run = cf_json_scan_string( p + 1, end );
+    if ( run < end && *run == '"' )
+    {
+        *out_name   = p + 1;
+        *out_length = (int32_t)( run - p - 1 );
+        return run + 1;
+    }
+
+    size_t length = 0;
+    p             = cf_json_decode_string( reader, p, end, buffer, buffer_size, &length );
+    *out_name     = buffer;
+    *out_length   = (int32_t)length;
+    return p;
+}
+
+static const char* cf_json_skip_value( cf_json_reader_t* reader,
+                                       const char*       p,
+                                       const char*       end,
+                                       int32_t           depth );
+
+// Skips the members of an object or the elements of an array, after the opening bracket.
+static const char*
+cf_json_skip_container(
+    cf_json_reader_t* reader, const char* p, const char* end, bool is_object, int32_t depth )
+{
+    char close = is_object ? '}' : ']';
+    p          = cf_json_skip_space( p, end );
+    if ( p < end && *p == close )
+    {
+        return p + 1;
+    }
+    for ( ;; )
+    {
+        if ( is_object )
+        {
+            if ( p == end || *p != '"' )
+            {
+                return cf_json_fail( reader, p, "expected a name" );
+            }
+            p = cf_json_skip_value( reader, p, end, depth );
+            p = p ? cf_json_skip_space( p, end ) : NULL;
+            if ( !p || p == end || *p != ':' )
+            {
+                return p ? cf_json_fail( reader, p, "expected ':'" ) : NULL;
+            }
+            ++p;
+        }
+        p = cf_json_skip_value( reader, p, end, depth );
+        if ( !p )
+        {
+            return NULL;
+        }
+        p = cf_json_skip_space( p, end );
+        if ( p < end && *p == ',' )
+        {
+            p = cf_json_skip_space( p + 1, end );
+            continue;
+        }
+        if ( p < end && *p == close )
+        {
+            return p + 1;
+        }
+        return cf_json_fail( reader, p, is_object ? "expected ',' or '}'" : "expected ',' or ']'" );
+    }
+}
+
+// Skips a value of any kind, e.g. of a field the type does not have.
+static const char*
+cf_json_skip_value( cf_json_reader_t* reader, const char* p, const char* end, int32_t depth )
+{
+    p = cf_json_skip_space( p, end );
+    if ( p == end )
+    {
+        return cf_json_fail( reader, p, "unexpected end of input" );
+    }
+    if ( depth > CF_JSON_MAX_DEPTH )
+    {
+        return cf_json_fail( reader, p, "nested too deeply" );
+    }
+
+    switch ( *p )
+    {
+        case '"':
+            for ( ++p;; )
+            {
+                p = cf_json_scan_string( p, end );
+                if ( p == end || (unsigned char)*p < 0x20 )
+                {
+                    return cf_json_fail( reader, p,
+                                         p == end ? "unterminated string" : "control character in string" );
+                }
+                if ( *p == '"' )
+                {
+                    return p + 1;
+                }
+                p += end - p >= 2 ? 2 : 1;    // The escaped character cannot end the string
+            }
+        case '{': return cf_json_skip_container( reader, p + 1, end, true, depth + 1 );
+        case '[': return cf_json_skip_container( reader, p + 1, end, false, depth + 1 );
+        case 't':
+            return cf_json_match( p, end, "true", 4 ) ? p + 4 : cf_json_fail( reader, p, "invalid literal" );
+        case 'f':
+            return cf_json_match( p, end, "false", 5 ) ? p + 5 : cf_json_fail( reader, p, "invalid literal" );
+        case 'n':
+            return cf_json_match( p, end, "null", 4 ) ? p + 4 : cf_json_fail( reader, p, "invalid literal" );
+        default:
+        {
+            cf_json_number_t number;
+            return cf_json_parse_number( reader, p, end, &number );
+        }
+    }
+}
+
+// Stores an integer in a primitive or enum of `bytes` bytes.
+static void
+cf_json_store_int( uint8_t* object, int32_t bytes, uint64_t value )
+{
+    switch ( bytes )
+    {
+        case 1: *(uint8_t*)object = (uint8_t)value; break;
+        case 2: *(uint16_t*)object = (uint16_t)value; break;
+        case 4: *(uint32_t*)object = (uint32_t)value; break;
+        default: *(uint64_t*)object = value; break;
+    }
+}
+
+static const char*
+cf_json_read_primitive(
+    cf_json_reader_t* reader, const char* p, const char* end, const cf_type_t* type, uint8_t* object )
+{
+    cf_json_number_t number;
+    cf_prim_t        prim = type->prim;
+    if ( prim == CF_PRIM_BOOL )
+    {
+        if ( cf_json_match( p, end, "true", 4 ) || cf_json_match( p, end, "false", 5 ) )
+        {
+            *(bool*)object = *p == 't';
+            return p + ( *p == 't' ? 4 : 5 );
+        }
+        return cf_json_fail( reader, p, "expected true or false" );
+    }
+
+    if ( prim == CF_PRIM_CSTR )
+    {
+        if ( cf_json_match( p, end, "null", 4 ) )
+        {
+            *(const char**)object = NULL;
+            return p + 4;
+        }
+        if ( *p != '"' )
+        {
+            return cf_json_fail( reader, p, "expected a string" );
+        }
+
+        // Decoded strings are NUL-terminated in the caller's storage.
+        size_t available = reader->strings_capacity - reader->strings_used;
+        char*  out       = reader->strings ? reader->strings + reader->strings_used : NULL;
+        size_t length    = 0;
+        if ( available == 0 )
+        {
+            return cf_json_fail( reader, p, "out of string storage" );
+        }
+        p = cf_json_decode_string( reader, p, end, out, available - 1, &length );
+        if ( p )
+        {
+            out[ length ]         = '\0';
+            *(const char**)object = out;
+            reader->strings_used += length + 1;
+        }
+        return p;
+    }
+
+    if ( prim == CF_PRIM_F32 || prim == CF_PRIM_F64 )
+    {
+        double value = NAN;
+        if ( cf_json_match( p, end, "null", 4 ) )
+        {
+            p += 4;
+        }
+        else
+        {
+            const char* start = p;
+            p                 = cf_json_parse_number( reader, p, end, &number );
+            if ( p && !cf_json_number_to_double( &number, &value ) )
+            {
+                return cf_json_fail( reader, start, "number too long" );
+            }
+        }
+        if ( p && prim == CF_PRIM_F32 )
+        {
+            *(float*)object = (float)value;
+        }
+        else if ( p )
+        {
+            *(double*)object = value;
+        }
+        return p;
+    }
+
+    const char* start = p;
+    p                 = cf_json_parse_number( reader, p, end, &number );
+    if ( !p )
+    {
+        return NULL;
+    }
+
+    // char may be signed or not, so it takes either range.
+    int64_t  signed_value;
+    uint64_t unsigned_value;
+    bool     is_unsigned =
+        prim == CF_PRIM_U8 || prim == CF_PRIM_U16 || prim == CF_PRIM_U32 || prim == CF_PRIM_U64;
+    bool fits = is_unsigned ? cf_json_number_to_unsigned( &number, type->size, &unsigned_value )
+                            : cf_json_number_to_signed( &number, prim == CF_PRIM_CHAR ? 2 : type->size,
+                                                        &signed_value );
+    if ( fits && prim == CF_PRIM_CHAR )
+    {
+        fits = signed_value >= -128 && signed_value <= 255;
+    }
+    if ( !fits )
+    {
+        return cf_json_fail( reader, start, "number does not fit the type" );
+    }
+    cf_json_store_int( object, type->size, is_unsigned ? unsigned_value : (uint64_t)signed_value );
+    return p;
+}
+
+static const char*
+cf_json_read_value( cf_json_reader_t* reader,
+                    const char*       p,
+                    const char*       end,
+                    const cf_type_t*  type,
+                    uint8_t*          object,
+                    int32_t           depth )
+{
+    p = cf_json_skip_space( p, end );
+    if ( p == end )
+    {
+        return cf_json_fail( reader, p, "unexpected end of input" );
+    }
+    if ( !type || depth > CF_LAYOUT_MAX_DEPTH )
+    {
+        return cf_json_fail( reader, p, "type cannot be read" );
+    }
+
+    if ( type->kind == CF_KIND_PRIMITIVE && type->prim != CF_PRIM_VOID )
+    {
+        return cf_json_read_primitive( reader, p, end, type, object );
+    }
+
+    if ( type->kind == CF_KIND_ENUM )
+    {
+        if ( *p == '"' )
+        {
+            char        buffer[ 256 ];
+            const char* name;
+            int32_t     length;
+            const char* start = p;
+            p                 = cf_json_read_name( reader, p, end, buffer, sizeof( buffer ), &name, &length );
+            if ( !p )
+            {
+                return NULL;
+            }
+            const cf_enum_value_t* entry = cf_find_enum_value_by_name_n( type, name, length );
+            if ( !entry )
+            {
+                return cf_json_fail( reader, start, "unknown enum value" );
+            }
+            cf_json_store_int( object, type->size, (uint64_t)(int64_t)entry->value );
+            return p;
+        }
+
+        cf_json_number_t number;
+        int64_t          value;
+        const char*      start = p;
+        p                      = cf_json_parse_number( reader, p, end, &number );
+        if ( p && !cf_json_number_to_signed( &number, type->size, &value ) )
+        {
+            return cf_json_fail( reader, start, "number does not fit the type" );
+        }
+        if ( p )
+        {
+            cf_json_store_int( object, type->size, (uint64_t)value );
+        }
+        return p;
+    }
+
+    if ( type->kind != CF_KIND_STRUCT )
+    {
+        return cf_json_fail( reader, p, "type cannot be read" );
+    }
+    if ( *p != '{' )
+    {
+        return cf_json_fail( reader, p, "expected an object" );
+    }
+
+    // Fields by name, in any order; each name is one perfect hash lookup.
+    p = cf_json_skip_space( p + 1, end );
+    if ( p < end && *p == '}' )
+    {
+        return p + 1;
+    }
+    for ( ;; )
+    {
+        if ( p == end || *p != '"' )
+        {
+            return cf_json_fail( reader, p, "expected a field name" );
+        }
+
+        char        buffer[ 256 ];
+        const char* name;
+        int32_t     length;
+        p = cf_json_read_name( reader, p, end, buffer, sizeof( buffer ), &name, &length );
+        if ( !p )
+        {
+            return NULL;
+        }
+        p = cf_json_skip_space( p, end );
+        if ( p == end || *p != ':' )
+        {
+            return cf_json_fail( reader, p, "expected ':'" );
+        }
+
+        const cf_field_t* field = cf_find_field_n( type, name, length );
+        p = field ? cf_json_read_value( reader, p + 1, end, field->type, object + field->offset, depth + 1 )
+                  : cf_json_skip_value( reader, p + 1, end, 0 );
+        if ( !p )
+        {
+            return NULL;
+        }
+
+        p = cf_json_skip_space( p, end );
+        if ( p < end && *p == ',' )
+        {
+            p = cf_json_skip_space( p + 1, end );
+            continue;
+        }
+        if ( p < end && *p == '}' )
+        {
+            return p + 1;
+        }
+        return cf_json_fail( reader, p, "expected ',' or '}'" );
+    }
+}
+
+// --- Images ---
+
+// Where cf_image_write() puts a section.
+typedef struct cf_image_plan_t
+{
+    cf_plan_t plan;
+    uint64_t  data;    // Offset of the objects
+    uint32_t  first_leaf;
+} cf_image_plan_t;
+
+// The measured layout of an image, see cf_image_header_t.
+typedef struct cf_image_layout_t
+{
+    uint64_t strings;       // Offset of the string section
+    uint64_t names_size;    // Bytes of type names and leaf paths at its start
+    uint64_t strings_size;
+    uint64_t size;
+    uint32_t num_leaves;
+} cf_image_layout_t;
+
+static uint64_t
+cf_image_align_up( uint64_t value, uint64_t align )
+{
+    return ( value + align - 1 ) & ~( align - 1 );
+}
+
+static uint32_t
+cf_image_align_of( const cf_type_t* type )
+{
+    return type->align > 0 ? (uint32_t)type->align : 1;
+}
+
+// Gets the copy plans of the sections and places everything. Returns false for sections
+// without a plan or with bad arguments.
+static bool
+cf_image_measure( const cf_image_section_t* sections,
+                  int32_t                   num_sections,
+                  cf_image_plan_t*          plans,
+                  cf_image_layout_t*        layout )
+{
+    memset( layout, 0, sizeof( *layout ) );
+    for ( int32_t i = 0; i < num_sections; ++i )
+    {
+        const cf_image_section_t* section = &sections[ i ];
+        const cf_type_t*          type    = section->type;
+        if ( !type || type->size <= 0 || section->count < 0 || ( !section->objects && section->count > 0 ) ||
+             ( cf_image_align_of( type ) & ( cf_image_align_of( type ) - 1 ) ) ||
+             !cf_plan_get( type, &plans[ i ].plan ) )
+        {
+            return false;
+        }
+        plans[ i ].first_leaf = layout->num_leaves;
+        layout->num_leaves += (uint32_t)plans[ i ].plan.num_leaves;
+        layout->names_size += type->name ? strlen( type->name ) + 1 : 0;
+        for ( int32_t j = 0; j < plans[ i ].plan.num_leaves; ++j )
+        {
+            const char* path = plans[ i ].plan.leaves[ j ].path;
+            layout->names_size += path ? strlen( path ) + 1 : 0;
+        }
+    }
+
+    uint64_t offset = sizeof( cf_image_header_t ) + (uint64_t)num_sections * sizeof( cf_image_type_t ) +
+                      (uint64_t)layout->num_leaves * sizeof( cf_image_leaf_t );
+    uint64_t values = 0;
+    for ( int32_t i = 0; i < num_sections; ++i )
+    {
+        const cf_image_section_t* section = &sections[ i ];
+        const cf_plan_t*          plan    = &plans[ i ].plan;
+        uint32_t                  align   = cf_image_align_of( section->type );
+        plans[ i ].data = cf_image_align_up( offset, align > CF_IMAGE_ALIGN ? align : CF_IMAGE_ALIGN );
+        offset          = plans[ i ].data + (uint64_t)section->count * (uint64_t)plan->type_size;
+
+        // String values, in the order the writer appends them.
+        const uint8_t* object = (const uint8_t*)section->objects;
+        for ( int32_t n = 0; plan->has_strings && n < section->count; ++n, object += plan->type_size )
+        {
+            for ( int32_t j = 0; j < plan->num_ops; ++j )
+            {
+                if ( plan->ops[ j ].size == 0 )
+                {
+                    const char* str;
+                    memcpy( &str, object + plan->ops[ j ].offset, sizeof( str ) );
+                    values += str ? strlen( str ) + 1 : 0;
+                }
+            }
+        }
+    }
+
+    // Name offsets are 32 bits.
+    layout->strings      = cf_image_align_up( offset, sizeof( uint64_t ) );
+    layout->strings_size = layout->names_size + values;
+    layout->size         = layout->strings + layout->strings_size;
+    return layout->names_size < UINT32_MAX;
+}
+
+// Appends a string to the string section and returns its offset + 1, or 0 for NULL.
+static uint64_t
+cf_image_put_string( uint8_t* out, const cf_image_layout_t* layout, uint64_t* cursor, const char* str )
+{
+    if ( !str )
+    {
+        return 0;
+    }
+    size_t   length = strlen( str ) + 1;
+    uint64_t offset = *cursor;
+    memcpy( out + layout->strings + offset, str, length );
+    *cursor += length;
+    return offset + 1;
+}
+
+// Writes the objects of one section. Structs without padding or strings are one copy; others
+// are cleared and copied step by step, so padding comes out as zeros.
+static void
+cf_image_put_objects( uint8_t*                  out,
+                      const cf_image_layout_t*  layout,
+                      const cf_image_section_t* section,
+                      const cf_image_plan_t*    image_plan,
+                      uint64_t*                 cursor )
+{
+    const cf_plan_t* plan   = &image_plan->plan;
+    const uint8_t*   object = (const uint8_t*)section->objects;
+    uint8_t*         dst    = out + image_plan->data;
+    size_t           bytes  = (size_t)section->count * (size_t)plan->type_size;
+    if ( cf_plan_is_flat( plan ) )
+    {
+        memcpy( dst, object, bytes );
+        return;
+    }
+
+    memset( dst, 0, bytes );
+    for ( int32_t n = 0; n < section->count; ++n, object += plan->type_size, dst += plan->type_size )
+    {
+        for ( int32_t j = 0; j < plan->num_ops; ++j )
+        {
+            const cf_copy_op_t* op = &plan->ops[ j ];
+            if ( op->size > 0 )
+            {
+                memcpy( dst + op->offset, object + op->offset, (size_t)op->size );
+                continue;
+            }
+            const char* str;
+            memcpy( &str, object + op->offset, sizeof( str ) );
+            uintptr_t slot = (uintptr_t)cf_image_put_string( out, layout, cursor, str );
+            memcpy( dst + op->offset, &slot, sizeof( slot ) );
+        }
+    }
+}
+
+// Returns the header of an image opened by cf_image_open().
+static const cf_image_header_t*
+cf_image_header( const cf_image_t* image )
+{
+    return (const cf_image_header_t*)image->data;
+}
+
+static const cf_image_type_t*
+cf_image_types( const cf_image_t* image )
+{
+    return (const cf_image_type_t*)( image->data + sizeof( cf_image_header_t ) );
+}
+
+static const cf_image_leaf_t*
+cf_image_leaves( const cf_image_t* image )
+{
+    return (const cf_image_leaf_t*)( cf_image_types( image ) + cf_image_header( image )->num_sections );
+}
+
+// Checks the tables of an image against its size. Every name and string is then known to be
+// terminated, since the string section ends with a NUL.
+static bool
+cf_image_validate( const uint8_t* data, size_t size )
+{
+    const cf_image_header_t* header = (const cf_image_header_t*)data;
+    if ( size < sizeof( *header ) || memcmp( header->magic, CF_IMAGE_MAGIC, sizeof( header->magic ) ) != 0 ||
+         header->version != CF_IMAGE_VERSION || header->byte_order != CF_IMAGE_BYTE_ORDER ||
+         header->pointer_size != sizeof( void* ) || header->size > size || header->num_sections > INT32_MAX )
+    {
+        return false;
+    }
+
+    uint64_t tables = sizeof( *header ) + (uint64_t)header->num_sections * sizeof( cf_image_type_t ) +
+                      (uint64_t)header->num_leaves * sizeof( cf_image_leaf_t );
+    if ( tables > header->size || header->strings < tables || header->strings > header->size ||
+         header->strings_size > header->size - header->strings ||
+         ( header->strings_size > 0 && data[ header->strings + header->strings_size - 1 ] != '\0' ) )
+    {
+        return false;
+    }
+
+    const cf_image_type_t* types  = (const cf_image_type_t*)( data + sizeof( *header ) );
+    const cf_image_leaf_t* leaves = (const cf_image_leaf_t*)( types + header->num_sections );
+    for ( uint32_t i = 0; i < header->num_sections; ++i )
+    {
+        const cf_image_type_t* type = &types[ i ];
+        if ( type->kind >= CF_KIND_COUNT || type->size == 0 || type->align == 0 ||
+             ( type->align & ( type->align - 1 ) ) || type->data % type->align || type->data < tables ||
+             type->data > header->strings || type->count > INT32_MAX ||
+             type->count > ( header->strings - type->data ) / type->size ||
+             type->name > header->strings_size || type->first_leaf > header->num_leaves ||
+             type->num_leaves > header->num_leaves - type->first_leaf )
+        {
+            return false;
+        }
+        for ( uint32_t j = 0; j < type->num_leaves; ++j )
+        {
+            const cf_image_leaf_t* leaf = &leaves[ type->first_leaf + j ];
+            if ( leaf->prim >= CF_PRIM_COUNT || leaf->size > type->size ||
+                 leaf->offset > type->size - leaf->size || leaf->path > header->strings_size ||
+                 ( leaf->prim == CF_PRIM_CSTR && leaf->size != sizeof( void* ) ) )
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Visits the string slots of every section. With `relocate` false, checks that each one
+// holds a valid offset; with `relocate` true, replaces the offsets with pointers.
+static bool
+cf_image_visit_strings( cf_image_t* image, bool relocate )
+{
+    const cf_image_header_t* header  = cf_image_header( image );
+    const cf_image_leaf_t*   leaves  = cf_image_leaves( image );
+    char*                    strings = (char*)image->data + header->strings;
+    for ( uint32_t i = 0; i < header->num_sections; ++i )
+    {
+        const cf_image_type_t* type = &cf_image_types( image )[ i ];
+        for ( uint32_t j = 0; j < type->num_leaves; ++j )
+        {
+            const cf_image_leaf_t* leaf = &leaves[ type->first_leaf + j ];
+            if ( leaf->prim != CF_PRIM_CSTR )
+            {
+                continue;
+            }
+            uint8_t* slot = image->data + type->data + leaf->offset;
+            for ( uint64_t n = 0; n < type->count; ++n, slot += type->size )
+            {
+                uintptr_t offset;
+                memcpy( &offset, slot, sizeof( offset ) );
+                if ( !relocate && offset > header->strings_size )
+                {
+                    return false;
+                }
+                if ( relocate )
+                {
+                    const char* str = offset ? strings + offset - 1 : NULL;
+                    memcpy( slot, &str, sizeof( str ) );
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// --- Migration ---
+
+#define CF_MIGRATE_BLOCK 256    // Objects converted per pass over the steps, so a block stays in cache
+
+// One step of a migration: `size` bytes copied, or a value converted if `size` is 0.
+typedef struct cf_migration_op_t
+{
+    int32_t   src;    // Offset in the old object
+    int32_t   dst;    // Offset in the new object
+    int32_t   size;
+    cf_prim_t from;
+    cf_prim_t to;
+} cf_migration_op_t;
+
+struct cf_migration_t
+{
+    int32_t            old_size;
+    int32_t            new_size;
+    bool               is_copy;    // Same fingerprint: the arrays are copied as they are
+    bool               fills;      // The steps leave bytes of the new object: start from `defaults`
+    int32_t            num_ops;
+    cf_migration_op_t* ops;
+    uint8_t*           defaults;    // One new object
+};
+
+static bool
+cf_prim_is_signed( cf_prim_t prim )
+{
+    return prim == CF_PRIM_I8 || prim == CF_PRIM_I16 || prim == CF_PRIM_I32 || prim == CF_PRIM_I64;
+}
+
+static bool
+cf_prim_is_unsigned( cf_prim_t prim )
+{
+    return prim == CF_PRIM_U8 || prim == CF_PRIM_U16 || prim == CF_PRIM_U32 || prim == CF_PRIM_U64;
+}
+
+// Returns true if every value of `from` converts to `to` exactly. Only leaves of different
+// primitives or sizes are asked.
+static bool
+cf_migration_widens( const cf_leaf_t* from, const cf_leaf_t* to )
+{
+    bool from_int = cf_prim_is_signed( from->prim ) || cf_prim_is_unsigned( from->prim );
+    if ( to->prim == CF_PRIM_F64 )
+    {
+        return from->prim == CF_PRIM_F32 || ( from_int && from->size <= 4 );
+    }
+    if ( to->prim == CF_PRIM_F32 )
+    {
+        return from_int && from->size <= 2;
+    }
+    if ( cf_prim_is_signed( to->prim ) )
+    {
+        return from_int && from->size < to->size;
+    }
+    return cf_prim_is_unsigned( to->prim ) && cf_prim_is_unsigned( from->prim ) && from->size < to->size;
+}
+
+// Runs a conversion step over `count` objects: the values are loaded into a block of doubles
+// or integers, then stored, each in a loop of one type.
+static void
+cf_migrate_convert( const cf_migration_op_t* op,
+                    uint8_t*                 dst,
+                    size_t                   dst_stride,
+                    const uint8_t*           src,
+                    size_t                   src_stride,
+                    int32_t                  count )
+{
+#define CF_LOAD_LOOP( c_type )                                           \
+    for ( int32_t i = 0; i < count; ++i )                                \
+    {                                                                    \
+        c_type value;                                                    \
+        memcpy( &value, src + (size_t)i * src_stride, sizeof( value ) ); \
+        values[ i ] = value;                                             \
+    }
+#define CF_STORE_LOOP( c_type )                                          \
+    for ( int32_t i = 0; i < count; ++i )                                \
+    {                                                                    \
+        c_type value = (c_type)values[ i ];                              \
+        memcpy( dst + (size_t)i * dst_stride, &value, sizeof( value ) ); \
+    }
+
+    if ( op->to == CF_PRIM_F32 || op->to == CF_PRIM_F64 )
+    {
+        double values[ CF_MIGRATE_BLOCK ];
+        switch ( op->from )
+        {
+            case CF_PRIM_I8: CF_LOAD_LOOP( int8_t ); break;
+            case CF_PRIM_I16: CF_LOAD_LOOP( int16_t ); break;
+            case CF_PRIM_I32: CF_LOAD_LOOP( int32_t ); break;
+            case CF_PRIM_U8: CF_LOAD_LOOP( uint8_t ); break;
+            case CF_PRIM_U16: CF_LOAD_LOOP( uint16_t ); break;
+            case CF_PRIM_U32: CF_LOAD_LOOP( uint32_t ); break;
+            default: CF_LOAD_LOOP( float ); break;
+        }
+        if ( op->to == CF_PRIM_F32 )
+        {
+            CF_STORE_LOOP( float );
+        }
+        else
+        {
+            CF_STORE_LOOP( double );
+        }
+        return;
+    }
+
+    // Integers only widen, so 64-bit sources never get here.
+    int64_t values[ CF_MIGRATE_BLOCK ];
+    switch ( op->from )
+    {
+        case CF_PRIM_I8: CF_LOAD_LOOP( int8_t ); break;
+        case CF_PRIM_I16: CF_LOAD_LOOP( int16_t ); break;
+        case CF_PRIM_I32: CF_LOAD_LOOP( int32_t ); break;
+        case CF_PRIM_U8: CF_LOAD_LOOP( uint8_t ); break;
+        case CF_PRIM_U16: CF_LOAD_LOOP( uint16_t ); break;
+        default: CF_LOAD_LOOP( uint32_t ); break;
+    }
+    switch ( op->to )
+    {
+        case CF_PRIM_I16:
+        case CF_PRIM_U16: CF_STORE_LOOP( uint16_t ); break;
+        case CF_PRIM_I32:
+        case CF_PRIM_U32: CF_STORE_LOOP( uint32_t ); break;
+        default: CF_STORE_LOOP( uint64_t ); break;
+    }
+
+#undef CF_LOAD_LOOP
+#undef CF_STORE_LOOP
+}
+
+// Finds the old leaf with the same path as `leaf`.
+static const cf_leaf_t*
+cf_migration_match( const cf_plan_t* old_plan, const cf_leaf_t* leaf )
+{
+    for ( int32_t i = 0; i < old_plan->num_leaves; ++i )
+    {
+        if ( old_plan->leaves[ i ].path_hash == leaf->path_hash )
+        {
+            return &old_plan->leaves[ i ];
+        }
+    }
+    return NULL;
+}
+
+// --- Byte Order ---
+
+#define CF_SWAP_MAX_WINDOWS 32    // Shuffles per object; leaves past them are swapped one at a time
+
+// Returns true if a leaf changes with the byte order: multi-byte primitives and enums. String
+// pointers never go on the wire.
+static bool
+cf_swap_leaf( const cf_leaf_t* leaf )
+{
+    return leaf->prim != CF_PRIM_CSTR && ( leaf->size == 2 || leaf->size == 4 || leaf->size == 8 );
+}
+
+// Reverses the bytes of one value of 2, 4 or 8 bytes.
+static void
+cf_swap_value( uint8_t* p, int32_t size )
+{
+#define CF_SWAP_VALUE( c_type, swap )         \
+    {                                         \
+        c_type value;                         \
+        memcpy( &value, p, sizeof( value ) ); \
+        value = swap( value );                \
+        memcpy( p, &value, sizeof( value ) ); \
+    }
+
+    switch ( size )
+    {
+        case 2: CF_SWAP_VALUE( uint16_t, cf_bswap16 ); break;
+        case 4: CF_SWAP_VALUE( uint32_t, cf_bswap32 ); break;
+        default: CF_SWAP_VALUE( uint64_t, cf_bswap64 ); break;
+    }
+
+#undef CF_SWAP_VALUE
+}
+
+// Swaps the leaves of fixed-size objects, or of serialized records, where each leaf follows
+// the one before it. With SSSE3 the leaves are grouped into windows of 16 bytes, and each
+// window is swapped by one byte shuffle. The other bytes of a window map to themselves, so
+// they are stored back as they were.
+typedef struct cf_swapper_t
+{
+    const cf_leaf_t* leaves;
+    int32_t          num_leaves;
+    bool             records;
+    size_t           stride;
+    int32_t          first_scalar;     // Leaves from here on are swapped one at a time
+    int32_t          scalar_offset;    // Record offset of that leaf
+#if CF_HAS_SSSE3
+    int32_t num_windows;
+    int32_t reach;    // Bytes from the start of an object to the end of its last window
+    int32_t window_offsets[ CF_SWAP_MAX_WINDOWS ];
+    __m128i window_masks[ CF_SWAP_MAX_WINDOWS ];
+#endif
+} cf_swapper_t;
+
+static void
+cf_swapper_init( cf_swapper_t* swapper, const cf_plan_t* plan, bool records )
+{
+    memset( swapper, 0, sizeof( *swapper ) );
+    swapper->leaves     = plan->leaves;
+    swapper->num_leaves = plan->num_leaves;
+    swapper->records    = records;
+    swapper->stride     = (size_t)( records ? plan->record_size : plan->type_size );
+
+#if CF_HAS_SSSE3
+    uint8_t mask[ 16 ];
+    int32_t start  = -1;    // Offset of the open window, or -1
+    int32_t offset = 0;     // Record offset of leaf i
+    int32_t i      = 0;
+    for ( ; i < plan->num_leaves; offset += plan->leaves[ i ].size, ++i )
+    {
+        const cf_leaf_t* leaf = &plan->leaves[ i ];
+        int32_t          at   = records ? offset : leaf->offset;
+        if ( !cf_swap_leaf( leaf ) )
+        {
+            continue;
+        }
+        if ( start >= 0 && ( at < start || at + leaf->size > start + 16 ) )
+        {
+            swapper->window_offsets[ swapper->num_windows ] = start;
+            swapper->window_masks[ swapper->num_windows++ ] = _mm_loadu_si128( (const __m128i*)mask );
+            swapper->reach = start + 16 > swapper->reach ? start + 16 : swapper->reach;
+            start          = -1;
+        }
+        if ( start < 0 )
+        {
+            if ( swapper->num_windows == CF_SWAP_MAX_WINDOWS )
+            {
+                break;
+            }
+            start = at;
+            for ( int32_t k = 0; k < 16; ++k ) { mask[ k ] = (uint8_t)k; }
+        }
+        for ( int32_t k = 0; k < leaf->size; ++k )
+        {
+            mask[ at - start + k ] = (uint8_t)( at - start + leaf->size - 1 - k );
+        }
+    }
+    if ( start >= 0 )
+    {
+        swapper->window_offsets[ swapper->num_windows ] = start;
+        swapper->window_masks[ swapper->num_windows++ ] = _mm_loadu_si128( (const __m128i*)mask );
+        swapper->reach = start + 16 > swapper->reach ? start + 16 : swapper->reach;
+    }
+    swapper->first_scalar  = i;
+    swapper->scalar_offset = offset;
+#endif
+}
+
+// Swaps the leaves of one object from leaf `first` on, which is at record offset `offset`.
+static void
+cf_swapper_scalar( const cf_swapper_t* swapper, uint8_t* object, int32_t first, int32_t offset )
+{
+    for ( int32_t i = first; i < swapper->num_leaves; offset += swapper->leaves[ i ].size, ++i )
+    {
+        const cf_leaf_t* leaf = &swapper->leaves[ i ];
+        if ( cf_swap_leaf( leaf ) )
+        {
+            cf_swap_value( object + ( swapper->records ? offset : leaf->offset ), leaf->size );
+        }
+    }
+}
+
+// Swaps `count` objects or records in place.
+static void
+cf_swapper_run( const cf_swapper_t* swapper, uint8_t* data, int32_t count )
+{
+    const uint8_t* end = data + swapper->stride * (size_t)count;
+    for ( int32_t i = 0; i < count; ++i, data += swapper->stride )
+    {
+        int32_t first  = 0;
+        int32_t offset = 0;
+#if CF_HAS_SSSE3
+        // The windows of the last objects may reach past the end of the array.
+        if ( (size_t)( end - data ) >= (size_t)swapper->reach )
+        {
+            for ( int32_t w = 0; w < swapper->num_windows; ++w )
+            {
+                __m128i* p = (__m128i*)( data + swapper->window_offsets[ w ] );
+                _mm_storeu_si128( p, _mm_shuffle_epi8( _mm_loadu_si128( p ), swapper->window_masks[ w ] ) );
+            }
+            first  = swapper->first_scalar;
+            offset = swapper->scalar_offset;
+        }
+#else
+        (void)end;
+#endif
+        cf_swapper_scalar( swapper, data, first, offset );
+    }
+}
+
+// Swaps `count` serialized records with strings in place. Each length prefix is read before
+// it is swapped, to find the next leaf.
+static void
+cf_swap_string_records( const cf_plan_t* plan, uint8_t* data, int32_t count )
+{
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        for ( int32_t j = 0; j < plan->num_leaves; ++j )
+        {
+            const cf_leaf_t* leaf = &plan->leaves[ j ];
+            if ( leaf->prim != CF_PRIM_CSTR )
+            {
+                if ( cf_swap_leaf( leaf ) )
+                {
+                    cf_swap_value( data, leaf->size );
+                }
+                data += leaf->size;
+                continue;
+            }
+
+            uint32_t prefix;
+            memcpy( &prefix, data, sizeof( prefix ) );
+            cf_swap_value( data, (int32_t)sizeof( prefix ) );
+            data += sizeof( prefix ) + ( prefix != CF_NULL_STRING ? (size_t)prefix + 1 : 0 );
+        }
+    }
+}
+
+// --- API Implementation ---
+
+void
+cf_initialize( void )
+{
+    // The registry is statically initialized; nothing to do.
+}
+
+void
+cf_shutdown( void )
+{
+    cf_spin_lock( &g_registry.write_lock );
+    cf_publish( NULL );
+    cf_atomic_store_u32( &g_registry.builtins_loaded, 0 );
+
+    // No other thread is in a read section, so the reader records can go. Threads that
+    // still point at theirs see the new generation and claim a fresh one.
+    while ( g_registry.readers )
+    {
+        cf_reader_t* reader = g_registry.readers;
+        g_registry.readers  = reader->next;
+        free( reader );
+    }
+    cf_atomic_store_u32( &g_registry.generation, g_registry.generation + 1 );
+    while ( g_registry.packed )
+    {
+        cf_packed_entry_t* entry = g_registry.packed;
+        g_registry.packed        = entry->next;
+        free( entry );
+    }
+    cf_spin_unlock( &g_registry.write_lock );
+}
+
+void
+cf_register_type_table( const cf_type_t* types[], int32_t count )
+{
+    if ( !types || count <= 0 )
+    {
+        return;
+    }
+
+    cf_spin_lock( &g_registry.write_lock );
+    cf_load_builtin_tables_locked();
+
+    cf_type_table_t table = { types, count };
+    cf_add_tables_locked( &table, 1 );
+
+    cf_spin_unlock( &g_registry.write_lock );
+}
+
+void
+cf_unregister_type_table( const cf_type_t* types[] )
+{
+    cf_spin_lock( &g_registry.write_lock );
+    cf_load_builtin_tables_locked();
+    cf_remove_table_locked( types );
+    cf_spin_unlock( &g_registry.write_lock );
+}
+
+void
+cf_register_packed_module( const cf_packed_module_t* module )
+{
+    if ( !module || module->num_types <= 0 )
+    {
+        return;
+    }
+
+    cf_spin_lock( &g_registry.write_lock );
+    cf_load_builtin_tables_locked();
+
+    cf_packed_entry_t* entry = cf_packed_get_locked( module, true );
+    if ( entry )
+    {
+        cf_type_table_t table = { entry->types, module->num_types };
+        cf_add_tables_locked( &table, 1 );
+    }
+
+    cf_spin_unlock( &g_registry.write_lock );
+}
+
+void
+cf_unregister_packed_module( const cf_packed_module_t* module )
+{
+    cf_spin_lock( &g_registry.write_lock );
+    cf_load_builtin_tables_locked();
+
+    cf_packed_entry_t* entry = cf_packed_get_locked( module, false );
+    if ( entry )
+    {
+        cf_remove_table_locked( entry->types );
+    }
+
+    cf_spin_unlock( &g_registry.write_lock );
+}
+
+const cf_type_t*
+cf_find_type_by_name( const char* name )
+{
+    if ( !name )
+    {
+        return NULL;
+    }
+    return cf_find_type_by_name_n( name, (int32_t)strlen( name ) );
+}
+
+const cf_type_t*
+cf_find_type_by_name_n( const char* name, int32_t len )
+{
+    if ( !name || len < 0 )
+    {
+        return NULL;
+    }
+
+    const cf_snapshot_t* snapshot = cf_read_begin();
+    CF_STAT_BEGIN();
+    const cf_type_t* type = snapshot ? cf_snapshot_find_name( snapshot, name, len ) : NULL;
+    cf_read_end();
+    CF_STAT_RECORD( CF_STAT_TYPE_BY_NAME, type );
+    return type;
+}
+
+const cf_type_t*
+cf_find_type_by_id( uint64_t id )
+{
+    const cf_snapshot_t* snapshot = cf_read_begin();
+    CF_STAT_BEGIN();
+    const cf_index_slot_t* slot = snapshot ? cf_snapshot_find_id( snapshot, id ) : NULL;
+    const cf_type_t*       type = slot ? slot->type : NULL;
+    cf_read_end();
+    CF_STAT_RECORD( CF_STAT_TYPE_BY_ID, type );
+    return type;
+}
+
+int32_t
+cf_get_num_types( void )
+{
+    const cf_snapshot_t* snapshot  = cf_read_begin();
+    int32_t              num_types = snapshot ? snapshot->num_types : 0;
+    cf_read_end();
+    return num_types;
+}
+
+int32_t
+cf_get_type_index( const cf_type_t* type )
+{
+    return type && type->state ? (int32_t)cf_atomic_load_u32( (volatile uint32_t*)&type->state->index ) : -1;
+}
+
+const cf_type_t*
+cf_get_type_by_index( int32_t index )
+{
+    const cf_snapshot_t* snapshot = cf_read_begin();
+    const cf_type_t*     type     = NULL;
+    if ( snapshot && index >= 0 && index < snapshot->num_types )
+    {
+        type = snapshot->types[ index ];
+    }
+    cf_read_end();
+    return type;
+}
+
+int32_t
+cf_get_num_tables( void )
+{
+    const cf_snapshot_t* snapshot   = cf_read_begin();
+    int32_t              num_tables = snapshot ? snapshot->num_tables : 0;
+    cf_read_end();
+    return num_tables;
+}
+
+void
+cf_get_table( int32_t table_index, const cf_type_t*** out_types, int32_t* out_count )
+{
+    if ( out_types )
+        *out_types = NULL;
+    if ( out_count )
+        *out_count = 0;
+
+    const cf_snapshot_t* snapshot = cf_read_begin();
+    if ( snapshot && table_index >= 0 && table_index < snapshot->num_tables )
+    {
+        if ( out_types )
+            *out_types = snapshot->tables[ table_index ].types;
+        if ( out_count )
+            *out_count = snapshot->tables[ table_index ].count;
+    }
+    cf_read_end();
+}
+
+// Starts an iteration over a row of a secondary index. Keeps the read section entered by
+// the caller open until the iteration ends.
+static void
+cf_iter_start( cf_type_iter_t* it, const cf_snapshot_t* snapshot, const int32_t* indices, int32_t count )
+{
+    it->snapshot = snapshot;
+    it->indices  = indices;
+    it->count    = count;
+    it->position = 0;
+    if ( !snapshot || count <= 0 )
+    {
+        it->snapshot = NULL;
+        cf_read_end();
+    }
+}
+
+void
+cf_iter_types_by_kind( cf_type_iter_t* it, cf_kind_t kind )
+{
+    const cf_snapshot_t*  snapshot  = cf_read_begin();
+    const cf_relations_t* relations = snapshot ? snapshot->relations : NULL;
+    if ( relations && (uint32_t)kind < CF_KIND_COUNT )
+    {
+        int32_t first = relations->kind_start[ kind ];
+        cf_iter_start( it, snapshot, relations->kind_types + first,
+                       relations->kind_start[ kind + 1 ] - first );
+    }
+    else
+    {
+        cf_iter_start( it, NULL, NULL, 0 );
+    }
+}
+
+void
+cf_iter_containers( cf_type_iter_t* it, const cf_type_t* type )
+{
+    const cf_snapshot_t*  snapshot  = cf_read_begin();
+    const cf_relations_t* relations = snapshot ? snapshot->relations : NULL;
+    int32_t               index     = relations ? cf_snapshot_dense_index( snapshot, type ) : -1;
+    if ( index >= 0 )
+    {
+        int32_t first = relations->container_start[ index ];
+        int32_t count = relations->container_start[ index + 1 ] - first;
+        cf_iter_start( it, snapshot, relations->containers + first, count );
+    }
+    else
+    {
+        cf_iter_start( it, NULL, NULL, 0 );
+    }
+}
+
+const cf_type_t*
+cf_iter_next( cf_type_iter_t* it )
+{
+    const cf_snapshot_t* snapshot = (const cf_snapshot_t*)it->snapshot;
+    if ( snapshot && it->position < it->count )
+    {
+        return snapshot->types[ it->indices[ it->position++ ] ];
+    }
+    cf_iter_end( it );
+    return NULL;
+}
+
+void
+cf_iter_end( cf_type_iter_t* it )
+{
+    if ( it->snapshot )
+    {
+        it->snapshot = NULL;
+        cf_read_end();
+    }
+}
+
+bool
+cf_type_is_a( const cf_type_t* type, const cf_type_t* base )
+{
+    if ( !type || !base )
+    {
+        return false;
+    }
+
+    // Intervals of the same generation belong to the same numbering.
+    uint64_t derived  = type->state ? cf_atomic_load_u64( (volatile uint64_t*)&type->state->interval ) : 0;
+    uint64_t ancestor = base->state ? cf_atomic_load_u64( (volatile uint64_t*)&base->state->interval ) : 0;
+    if ( derived && ancestor && ( derived ^ ancestor ) >> ( 2 * CF_INTERVAL_BITS ) == 0 )
+    {
+        uint64_t pre_mask = CF_INTERVAL_MASK << CF_INTERVAL_BITS;
+        return ( ancestor & pre_mask ) <= ( derived & pre_mask ) &&
+               ( derived & CF_INTERVAL_MASK ) <= ( ancestor & CF_INTERVAL_MASK );
+    }
+
+    // Not numbered by the registry (hand-built or unregistered types, or a numbering being
+    // stored): walk the chain.
+    for ( ; type; type = type->kind == CF_KIND_STRUCT ? type->struct_parent : NULL )
+    {
+        if ( type == base )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+cf_path_t
+cf_path_compile( const cf_type_t* type, const char* path )
+{
+    cf_path_t result = { 0, NULL };
+    if ( !path )
+    {
+        return result;
+    }
+
+    int32_t offset = 0;
+    for ( ;; )
+    {
+        const char* end = path;
+        while ( *end && *end != '.' ) { ++end; }
+
+        const cf_field_t* field = end > path ? cf_find_field_n( type, path, (int32_t)( end - path ) ) : NULL;
+        if ( !field || !field->type )
+        {
+            return result;
+        }
+        offset += field->offset;
+        type = field->type;
+
+        if ( !*end )
+        {
+            break;
+        }
+        path = end + 1;
+    }
+
+    result.offset = offset;
+    result.type   = type;
+    return result;
+}
+
+void
+cf_path_gather( const cf_path_t* path, const void* objects, size_t stride, int32_t count, void* out )
+{
+    if ( path && path->type && objects && out )
+    {
+        size_t size = (size_t)path->type->size;
+        cf_copy_strided( (uint8_t*)out, size, (const uint8_t*)objects + path->offset, stride, size, count );
+    }
+}
+
+void
+cf_path_scatter( const cf_path_t* path, void* objects, size_t stride, int32_t count, const void* in )
+{
+    if ( path && path->type && objects && in )
+    {
+        size_t size = (size_t)path->type->size;
+        cf_copy_strided( (uint8_t*)objects + path->offset, stride, (const uint8_t*)in, size, size, count );
+    }
+}
+
+size_t
+cf_serialize( const cf_type_t* type, const void* objects, int32_t count, void* buffer, size_t buffer_size )
+{
+    cf_plan_t plan;
+    if ( ( !objects && count > 0 ) || count < 0 || !cf_plan_get( type, &plan ) )
+    {
+        return 0;
+    }
+
+    // Generated functions beat the plan unless the whole array is one copy.
+    const cf_struct_funcs_t* funcs = cf_struct_funcs( type );
+    size_t                   size;
+    if ( funcs && !cf_plan_is_flat( &plan ) )
+    {
+        const uint8_t* src = (const uint8_t*)objects;
+        uint8_t*       out = (uint8_t*)buffer;
+        size               = 0;
+        for ( int32_t i = 0; i < count; ++i, src += plan.type_size )
+        {
+            size_t bytes = funcs->write( src, out ? out + size : NULL, out ? buffer_size - size : 0 );
+            if ( bytes == 0 && plan.record_size > 0 )
+            {
+                size = 0;
+                break;
+            }
+            size += bytes;
+        }
+    }
+    else if ( cf_plan_is_flat( &plan ) || !plan.has_strings )
+    {
+        // Fixed-size records: one bounds check for the whole array.
+        size = (size_t)plan.record_size * (size_t)count;
+        if ( buffer && size > buffer_size )
+        {
+            size = 0;
+        }
+        else if ( buffer && cf_plan_is_flat( &plan ) )
+        {
+            memcpy( buffer, objects, size );
+        }
+        else if ( buffer )
+        {
+            cf_plan_write( &plan, (const uint8_t*)objects, count, (uint8_t*)buffer, size );
+        }
+    }
+    else
+    {
+        size = cf_plan_write( &plan, (const uint8_t*)objects, count, (uint8_t*)buffer, buffer_size );
+    }
+
+    cf_plan_release( &plan );
+    return size;
+}
+
+size_t
+cf_deserialize( const cf_type_t* type, void* objects, int32_t count, const void* buffer, size_t buffer_size )
+{
+    cf_plan_t plan;
+    if ( !buffer || ( !objects && count > 0 ) || count < 0 || !cf_plan_get( type, &plan ) )
+    {
+        return 0;
+    }
+
+    const uint8_t* in   = (const uint8_t*)buffer;
+    uint8_t*       dst  = (uint8_t*)objects;
+    size_t         size = 0;
+    if ( cf_plan_is_flat( &plan ) )
+    {
+        size = (size_t)plan.record_size * (size_t)count;
+        if ( size > buffer_size )
+        {
+            size = 0;
+        }
+        else
+        {
+            memcpy( objects, buffer, size );
+        }
+        cf_plan_release( &plan );
+        return size;
+    }
+
+    const cf_struct_funcs_t* funcs = cf_struct_funcs( type );
+    if ( funcs )
+    {
+        for ( int32_t i = 0; i < count; ++i, dst += plan.type_size )
+        {
+            size_t bytes = funcs->read( dst, in + size, buffer_size - size );
+            if ( bytes == 0 && plan.record_size > 0 )
+            {
+                cf_plan_release( &plan );
+                return 0;
+            }
+            size += bytes;
+        }
+        cf_plan_release( &plan );
+        return size;
+    }
+
+    size = cf_plan_read( &plan, dst, count, in, buffer_size, false );
+    cf_plan_release( &plan );
+    return size;
+}
+
+uint64_t
+cf_hash_object( const cf_type_t* type, const void* object )
+{
+    const cf_struct_funcs_t* funcs = cf_struct_funcs( type );
+    if ( !object )
+    {
+        return 0;
+    }
+    if ( funcs )
+    {
+        return funcs->hash( object );
+    }
+
+    cf_plan_t plan;
+    if ( !cf_plan_get( type, &plan ) )
+    {
+        return 0;
+    }
+
+    // Leaf by leaf rather than by merged step, to match the generated functions.
+    const uint8_t* src  = (const uint8_t*)object;
+    uint64_t       hash = CF_OBJECT_HASH_SEED;
+    for ( int32_t i = 0; i < plan.num_leaves; ++i )
+    {
+        const cf_leaf_t* leaf = &plan.leaves[ i ];
+        if ( leaf->prim == CF_PRIM_CSTR )
+        {
+            const char* str;
+            memcpy( &str, src + leaf->offset, sizeof( str ) );
+            hash = cf_hash_string( hash, str );
+        }
+        else
+        {
+            // Constant sizes let the compiler turn the copy in cf_hash_bits() into a load.
+            const uint8_t* value = src + leaf->offset;
+            switch ( leaf->size )
+            {
+                case 1: hash = cf_hash_bits( hash, value, 1 ); break;
+                case 2: hash = cf_hash_bits( hash, value, 2 ); break;
+                case 4: hash = cf_hash_bits( hash, value, 4 ); break;
+                case 8: hash = cf_hash_bits( hash, value, 8 ); break;
+                default: hash = cf_hash_bits( hash, value, (size_t)leaf->size ); break;
+            }
+        }
+    }
+
+    cf_plan_release( &plan );
+    return hash;
+}
+
+bool
+cf_objects_equal( const cf_type_t* type, const void* a, const void* b )
+{
+    const cf_struct_funcs_t* funcs = cf_struct_funcs( type );
+    if ( !a || !b )
+    {
+        return false;
+    }
+    if ( funcs )
+    {
+        return funcs->equal( a, b );
+    }
+
+    cf_plan_t plan;
+    if ( !cf_plan_get( type, &plan ) )
+    {
+        return false;
+    }
+
+    const uint8_t* lhs   = (const uint8_t*)a;
+    const uint8_t* rhs   = (const uint8_t*)b;
+    bool           equal = true;
+    for ( int32_t i = 0; i < plan.num_ops && equal; ++i )
+    {
+        const cf_copy_op_t* op = &plan.ops[ i ];
+        if ( op->size > 0 )
+        {
+            equal = memcmp( lhs + op->offset, rhs + op->offset, (size_t)op->size ) == 0;
+            continue;
+        }
+
+        const char* str_a;
+        const char* str_b;
+        memcpy( &str_a, lhs + op->offset, sizeof( str_a ) );
+        memcpy( &str_b, rhs + op->offset, sizeof( str_b ) );
+        equal = str_a == str_b || ( str_a && str_b && strcmp( str_a, str_b ) == 0 );
+    }
+
+    cf_plan_release( &plan );
+    return equal;
+}
+
+void
+cf_json_writer_init(
+    cf_json_writer_t* writer, char* buffer, size_t capacity, cf_json_flush_t flush, void* user )
+{
+    memset( writer, 0, sizeof( *writer ) );
+    writer->buffer   = buffer;
+    writer->capacity = buffer ? capacity : 0;
+    writer->flush    = flush;
+    writer->user     = user;
+}
+
+bool
+cf_json_write( cf_json_writer_t* writer, const cf_type_t* type, const void* object )
+{
+    if ( !writer || !object )
+    {
+        if ( writer )
+            writer->failed = true;
+        return false;
+    }
+    cf_json_put_value( writer, type, (const uint8_t*)object, 0 );
+    return !writer->failed;
+}
+
+bool
+cf_json_write_array( cf_json_writer_t* writer, const cf_type_t* type, const void* objects, int32_t count )
+{
+    if ( !writer || !type || ( !objects && count > 0 ) || count < 0 )
+    {
+        if ( writer )
+            writer->failed = true;
+        return false;
+    }
+    cf_json_put_char( writer, '[' );
+    for ( int32_t i = 0; i < count && !writer->failed; ++i )
+    {
+        if ( i > 0 )
+        {
+            cf_json_put_char( writer, ',' );
+        }
+        cf_json_put_value( writer, type, (const uint8_t*)objects + (size_t)i * (size_t)type->size, 0 );
+    }
+    cf_json_put_char( writer, ']' );
+    return !writer->failed;
+}
+
+bool
+cf_json_writer_flush( cf_json_writer_t* writer )
+{
+    if ( !writer || writer->failed )
+    {
+        return false;
+    }
+    if ( writer->flush && writer->used > 0 )
+    {
+        if ( !writer->flush( writer->user, writer->buffer, writer->used ) )
+        {
+            writer->failed = true;
+            return false;
+        }
+        writer->used = 0;
+    }
+    return true;
+}
 
-typedef struct cf_type_table_t
+void
+cf_json_reader_init(
+    cf_json_reader_t* reader, const char* json, size_t length, char* strings, size_t strings_capacity )
 {
-    const cf_type_t** types;
-    int32_t           count;
-} cf_type_table_t;
+    memset( reader, 0, sizeof( *reader ) );
+    reader->json             = json;
+    reader->length           = json ? length : 0;
+    reader->strings          = strings;
+    reader->strings_capacity = strings ? strings_capacity : 0;
+}
 
-typedef struct cf_registry_t
+bool
+cf_json_read( cf_json_reader_t* reader, const cf_type_t* type, void* object )
 {
-    cf_type_table_t tables[ MAX_TYPE_TABLES ];
-    int32_t         num_tables;
-} cf_registry_t;
+    if ( !reader || !object || reader->error )
+    {
+        return false;
+    }
+    const char* end = reader->json + reader->length;
+    const char* p = cf_json_read_value( reader, reader->json + reader->pos, end, type, (uint8_t*)object, 0 );
+    if ( !p )
+    {
+        return false;
+    }
+    reader->pos = (size_t)( cf_json_skip_space( p, end ) - reader->json );
+    return true;
+}
+
+int32_t
+cf_json_read_array( cf_json_reader_t* reader, const cf_type_t* type, void* objects, int32_t capacity )
+{
+    if ( !reader || !type || reader->error || ( !objects && capacity > 0 ) )
+    {
+        return -1;
+    }
 
-static cf_registry_t* g_registry = NULL;
+    const char* end = reader->json + reader->length;
+    const char* p   = cf_json_skip_space( reader->json + reader->pos, end );
+    if ( p == end || *p != '[' )
+    {
+        cf_json_fail( reader, p, "expected an array" );
+        return -1;
+    }
 
-// --- API Implementation ---
+    int32_t count = 0;
+    p             = cf_json_skip_space( p + 1, end );
+    if ( p < end && *p == ']' )
+    {
+        reader->pos = (size_t)( cf_json_skip_space( p + 1, end ) - reader->json );
+        return 0;
+    }
+    for ( ;; )
+    {
+        if ( count == capacity )
+        {
+            cf_json_fail( reader, p, "more elements than capacity" );
+            return -1;
+        }
+        p = cf_json_read_value( reader, p, end, type, (uint8_t*)objects + (size_t)count * (size_t)type->size,
+                                0 );
+        if ( !p )
+        {
+            return -1;
+        }
+        ++count;
 
-void
-cf_initialize( void )
+        p = cf_json_skip_space( p, end );
+        if ( p < end && *p == ',' )
+        {
+            p = cf_json_skip_space( p + 1, end );
+            continue;
+        }
+        if ( p < end && *p == ']' )
+        {
+            reader->pos = (size_t)( cf_json_skip_space( p + 1, end ) - reader->json );
+            return count;
+        }
+        cf_json_fail( reader, p, "expected ',' or ']'" );
+        return -1;
+    }
+}
+
+size_t
+cf_image_write( const cf_image_section_t* sections, int32_t num_sections, void* buffer, size_t buffer_size )
 {
-    if ( !g_registry )
+    if ( num_sections < 0 || ( !sections && num_sections > 0 ) )
+    {
+        return 0;
+    }
+    cf_image_plan_t* plans = (cf_image_plan_t*)calloc( (size_t)num_sections + 1, sizeof( cf_image_plan_t ) );
+    if ( !plans )
+    {
+        return 0;
+    }
+
+    cf_image_layout_t layout;
+    size_t            size = 0;
+    if ( cf_image_measure( sections, num_sections, plans, &layout ) && layout.size <= SIZE_MAX )
+    {
+        size = (size_t)layout.size;
+    }
+    if ( buffer && size > buffer_size )
     {
-        g_registry = (cf_registry_t*)malloc( sizeof( cf_registry_t ) );
-        if ( g_registry != NULL )
+        size = 0;
+    }
+
+    if ( buffer && size > 0 )
+    {
+        uint8_t*           out    = (uint8_t*)buffer;
+        cf_image_header_t* header = (cf_image_header_t*)out;
+        cf_image_type_t*   types  = (cf_image_type_t*)( out + sizeof( *header ) );
+        cf_image_leaf_t*   leaves = (cf_image_leaf_t*)( types + num_sections );
+        uint64_t           end    = (uint64_t)( (uint8_t*)( leaves + layout.num_leaves ) - out );
+        memset( out, 0, (size_t)end );
+
+        memcpy( header->magic, CF_IMAGE_MAGIC, sizeof( header->magic ) );
+        header->version      = CF_IMAGE_VERSION;
+        header->byte_order   = CF_IMAGE_BYTE_ORDER;
+        header->pointer_size = sizeof( void* );
+        header->num_sections = (uint32_t)num_sections;
+        header->num_leaves   = layout.num_leaves;
+        header->size         = layout.size;
+        header->strings      = layout.strings;
+        header->strings_size = layout.strings_size;
+
+        // Names first, so their offsets fit in 32 bits; string values after them.
+        uint64_t names  = 0;
+        uint64_t values = layout.names_size;
+        for ( int32_t i = 0; i < num_sections; ++i )
         {
-            memset( g_registry, 0, sizeof( cf_registry_t ) );
+            const cf_type_t* type = sections[ i ].type;
+            const cf_plan_t* plan = &plans[ i ].plan;
+            types[ i ].id         = cf_type_id( type );
+            types[ i ].data       = plans[ i ].data;
+            types[ i ].count      = (uint64_t)sections[ i ].count;
+            types[ i ].name       = (uint32_t)cf_image_put_string( out, &layout, &names, type->name );
+            types[ i ].kind       = (uint32_t)type->kind;
+            types[ i ].size       = (uint32_t)type->size;
+            types[ i ].align      = cf_image_align_of( type );
+            types[ i ].first_leaf = plans[ i ].first_leaf;
+            types[ i ].num_leaves = (uint32_t)plan->num_leaves;
+            for ( int32_t j = 0; j < plan->num_leaves; ++j )
+            {
+                cf_image_leaf_t* leaf = &leaves[ plans[ i ].first_leaf + j ];
+                leaf->path   = (uint32_t)cf_image_put_string( out, &layout, &names, plan->leaves[ j ].path );
+                leaf->offset = (uint32_t)plan->leaves[ j ].offset;
+                leaf->size   = (uint32_t)plan->leaves[ j ].size;
+                leaf->prim   = (uint32_t)plan->leaves[ j ].prim;
+            }
+
+            // The gap before each section is zeroed as well.
+            memset( out + end, 0, (size_t)( plans[ i ].data - end ) );
+            cf_image_put_objects( out, &layout, &sections[ i ], &plans[ i ], &values );
+            end = plans[ i ].data + (uint64_t)sections[ i ].count * (uint64_t)plan->type_size;
         }
+        memset( out + end, 0, (size_t)( layout.strings - end ) );
     }
+
+    for ( int32_t i = 0; i < num_sections; ++i ) { cf_plan_release( &plans[ i ].plan ); }
+    free( plans );
+    return size;
 }
 
-void
-cf_shutdown( void )
+bool
+cf_image_open( cf_image_t* image, void* data, size_t size )
+{
+    if ( !image )
+    {
+        return false;
+    }
+    memset( image, 0, sizeof( *image ) );
+    if ( !data || (uintptr_t)data % sizeof( uint64_t ) || !cf_image_validate( (const uint8_t*)data, size ) )
+    {
+        return false;
+    }
+
+    cf_image_header_t* header = (cf_image_header_t*)data;
+    image->data               = (uint8_t*)data;
+    image->size               = size;
+
+    // String slots hold offsets until the first open, and pointers into this memory after.
+    if ( header->relocated_base == 0 )
+    {
+        if ( !cf_image_visit_strings( image, false ) )
+        {
+            memset( image, 0, sizeof( *image ) );
+            return false;
+        }
+        cf_image_visit_strings( image, true );
+        header->relocated_base = (uint64_t)(uintptr_t)data;
+    }
+    else if ( header->relocated_base != (uint64_t)(uintptr_t)data )
+    {
+        memset( image, 0, sizeof( *image ) );
+        return false;
+    }
+
+    image->num_sections = (int32_t)header->num_sections;
+    return true;
+}
+
+int32_t
+cf_image_find_section( const cf_image_t* image, const cf_type_t* type )
 {
-    if ( g_registry )
+    for ( int32_t i = 0; image && image->data && type && i < image->num_sections; ++i )
     {
-        free( g_registry );
-        g_registry = NULL;
+        if ( cf_image_types( image )[ i ].id == cf_type_id( type ) )
+        {
+            return i;
+        }
     }
+    return -1;
 }
 
-void
-cf_register_type_table( const cf_type_t* types[], int32_t count )
+const void*
+cf_image_get_section( const cf_image_t* image, int32_t index, const cf_type_t* type, int32_t* out_count )
+{
+    if ( out_count )
+        *out_count = 0;
+    if ( !image || !image->data || !type || index < 0 || index >= image->num_sections )
+    {
+        return NULL;
+    }
+
+    const cf_image_type_t* section = &cf_image_types( image )[ index ];
+    const uint8_t*         objects = image->data + section->data;
+    if ( section->id != cf_type_id( type ) || section->kind != (uint32_t)type->kind ||
+         section->size != (uint32_t)type->size || section->align != cf_image_align_of( type ) ||
+         (uintptr_t)objects % section->align )
+    {
+        return NULL;
+    }
+
+    // Same leaves in the same places. Paths are compared when both sides have them.
+    cf_plan_t plan;
+    if ( !cf_plan_get( type, &plan ) )
+    {
+        return NULL;
+    }
+    const char*            strings = (const char*)image->data + cf_image_header( image )->strings;
+    const cf_image_leaf_t* leaves  = cf_image_leaves( image ) + section->first_leaf;
+    bool                   match   = section->num_leaves == (uint32_t)plan.num_leaves;
+    for ( int32_t i = 0; i < plan.num_leaves && match; ++i )
+    {
+        const cf_leaf_t*       leaf   = &plan.leaves[ i ];
+        const cf_image_leaf_t* stored = &leaves[ i ];
+        match = stored->offset == (uint32_t)leaf->offset && stored->size == (uint32_t)leaf->size &&
+                stored->prim == (uint32_t)leaf->prim &&
+                ( !stored->path || !leaf->path || strcmp( strings + stored->path - 1, leaf->path ) == 0 );
+    }
+    cf_plan_release( &plan );
+
+    if ( !match )
+    {
+        return NULL;
+    }
+    if ( out_count )
+        *out_count = (int32_t)section->count;
+    return objects;
+}
+
+uint64_t
+cf_get_fingerprint( const cf_type_t* type )
 {
-    if ( g_registry && g_registry->num_tables < MAX_TYPE_TABLES )
+    cf_plan_t plan;
+    if ( !cf_plan_get( type, &plan ) )
     {
-        cf_type_table_t* table = &g_registry->tables[ g_registry->num_tables++ ];
-        table->types           = types;
-        table->count           = count;
+        return 0;
     }
+    uint64_t fingerprint = plan.fingerprint;
+    cf_plan_release( &plan );
+    return fingerprint;
 }
 
-const cf_type_t*
-cf_find_type_by_name( const char* name )
+cf_migration_t*
+cf_migration_compile( const cf_type_t* old_type, const cf_type_t* new_type, const void* defaults )
 {
-    if ( !g_registry || !name )
+    cf_plan_t old_plan;
+    cf_plan_t new_plan;
+    if ( !cf_plan_get( old_type, &old_plan ) )
+    {
+        return NULL;
+    }
+    if ( !cf_plan_get( new_type, &new_plan ) )
     {
+        cf_plan_release( &old_plan );
         return NULL;
     }
 
-    for ( int32_t i = 0; i < g_registry->num_tables; ++i )
+    // One block: the migration, its steps and the default object.
+    size_t          head_size = cf_align_size( sizeof( cf_migration_t ) );
+    size_t          ops_size  = cf_align_size( (size_t)new_plan.num_leaves * sizeof( cf_migration_op_t ) );
+    uint8_t*        block     = (uint8_t*)calloc( 1, head_size + ops_size + (size_t)new_type->size );
+    cf_migration_t* migration = (cf_migration_t*)block;
+    if ( migration )
     {
-        const cf_type_table_t* table = &g_registry->tables[ i ];
-        for ( int32_t j = 0; j < table->count; ++j )
+        migration->old_size = old_type->size;
+        migration->new_size = new_type->size;
+        migration->is_copy  = old_plan.fingerprint == new_plan.fingerprint;
+        migration->ops      = (cf_migration_op_t*)( block + head_size );
+        migration->defaults = block + head_size + ops_size;
+        if ( defaults )
+        {
+            memcpy( migration->defaults, defaults, (size_t)new_type->size );
+        }
+
+        // Steps in the new declaration order, with copies that continue the previous copy on
+        // both sides merged into it.
+        int32_t covered = 0;
+        for ( int32_t i = 0; i < new_plan.num_leaves; ++i )
         {
-            const cf_type_t* type = table->types[ j ];
-            if ( type && type->name && strcmp( name, type->name ) == 0 )
+            const cf_leaf_t*   leaf = &new_plan.leaves[ i ];
+            const cf_leaf_t*   old  = cf_migration_match( &old_plan, leaf );
+            cf_migration_op_t* last =
+                migration->num_ops > 0 ? &migration->ops[ migration->num_ops - 1 ] : NULL;
+            if ( !old || leaf->size <= 0 )
             {
-                return type;
+                continue;
             }
+            if ( old->prim == leaf->prim && old->size == leaf->size )
+            {
+                if ( last && last->size > 0 && last->src + last->size == old->offset &&
+                     last->dst + last->size == leaf->offset )
+                {
+                    last->size += leaf->size;
+                }
+                else
+                {
+                    migration->ops[ migration->num_ops++ ] =
+                        ( cf_migration_op_t ){ old->offset, leaf->offset, leaf->size, old->prim, leaf->prim };
+                }
+            }
+            else if ( cf_migration_widens( old, leaf ) )
+            {
+                migration->ops[ migration->num_ops++ ] =
+                    ( cf_migration_op_t ){ old->offset, leaf->offset, 0, old->prim, leaf->prim };
+            }
+            else
+            {
+                continue;
+            }
+            covered += leaf->size;
         }
+        migration->fills = covered != new_type->size;
     }
 
-    return NULL;
+    cf_plan_release( &old_plan );
+    cf_plan_release( &new_plan );
+    return migration;
 }
 
-int32_t
-cf_get_num_tables( void )
+bool
+cf_migrate( const cf_migration_t* migration, const void* old_objects, void* new_objects, int32_t count )
 {
-    if ( !g_registry )
+    if ( !migration || count < 0 || ( count > 0 && ( !old_objects || !new_objects ) ) )
     {
-        return 0;
+        return false;
+    }
+    if ( migration->is_copy )
+    {
+        memcpy( new_objects, old_objects, (size_t)count * (size_t)migration->new_size );
+        return true;
+    }
+
+    const uint8_t* src        = (const uint8_t*)old_objects;
+    uint8_t*       dst        = (uint8_t*)new_objects;
+    size_t         src_stride = (size_t)migration->old_size;
+    size_t         dst_stride = (size_t)migration->new_size;
+    for ( int32_t done = 0; done < count; done += CF_MIGRATE_BLOCK )
+    {
+        int32_t n = count - done < CF_MIGRATE_BLOCK ? count - done : CF_MIGRATE_BLOCK;
+        for ( int32_t i = 0; migration->fills && i < n; ++i )
+        {
+            memcpy( dst + (size_t)i * dst_stride, migration->defaults, dst_stride );
+        }
+        for ( int32_t j = 0; j < migration->num_ops; ++j )
+        {
+            const cf_migration_op_t* op = &migration->ops[ j ];
+            if ( op->size > 0 )
+            {
+                cf_copy_strided( dst + op->dst, dst_stride, src + op->src, src_stride, (size_t)op->size, n );
+            }
+            else
+            {
+                cf_migrate_convert( op, dst + op->dst, dst_stride, src + op->src, src_stride, n );
+            }
+        }
+        src += (size_t)n * src_stride;
+        dst += (size_t)n * dst_stride;
     }
-    return g_registry->num_tables;
+    return true;
+}
+
+bool
+cf_migration_is_copy( const cf_migration_t* migration )
+{
+    return migration && migration->is_copy;
 }
 
 void
-cf_get_table( int32_t table_index, const cf_type_t*** out_types, int32_t* out_count )
+cf_migration_free( cf_migration_t* migration )
+{
+    free( migration );
+}
+
+cf_byte_order_t
+cf_host_byte_order( void )
+{
+    return CF_LITTLE_ENDIAN ? CF_BYTE_ORDER_LITTLE : CF_BYTE_ORDER_BIG;
+}
+
+size_t
+cf_encode( const cf_type_t* type,
+           const void*      objects,
+           int32_t          count,
+           cf_byte_order_t  order,
+           void*            buffer,
+           size_t           buffer_size )
+{
+    size_t size = cf_serialize( type, objects, count, buffer, buffer_size );
+    if ( order == cf_host_byte_order() || !buffer || size == 0 )
+    {
+        return size;
+    }
+
+    // Written in host order, then swapped while the records are still in cache.
+    cf_plan_t plan;
+    if ( !cf_plan_get( type, &plan ) )
+    {
+        return 0;
+    }
+    if ( plan.has_strings )
+    {
+        cf_swap_string_records( &plan, (uint8_t*)buffer, count );
+    }
+    else
+    {
+        cf_swapper_t swapper;
+        cf_swapper_init( &swapper, &plan, true );
+        cf_swapper_run( &swapper, (uint8_t*)buffer, count );
+    }
+    cf_plan_release( &plan );
+    return size;
+}
+
+size_t
+cf_decode( const cf_type_t* type,
+           void*            objects,
+           int32_t          count,
+           cf_byte_order_t  order,
+           const void*      buffer,
+           size_t           buffer_size )
+{
+    if ( order == cf_host_byte_order() )
+    {
+        return cf_deserialize( type, objects, count, buffer, buffer_size );
+    }
+
+    cf_plan_t plan;
+    if ( !buffer || ( !objects && count > 0 ) || count < 0 || !cf_plan_get( type, &plan ) )
+    {
+        return 0;
+    }
+
+    // Read as in host order, except for the string lengths, then swapped in the objects.
+    size_t size = plan.has_strings ? cf_plan_read( &plan, (uint8_t*)objects, count, (const uint8_t*)buffer,
+                                                   buffer_size, true )
+                                   : cf_deserialize( type, objects, count, buffer, buffer_size );
+    if ( size > 0 )
+    {
+        cf_swapper_t swapper;
+        cf_swapper_init( &swapper, &plan, false );
+        cf_swapper_run( &swapper, (uint8_t*)objects, count );
+    }
+    cf_plan_release( &plan );
+    return size;
+}
+
+const cf_leaf_t*
+cf_get_leaves( const cf_type_t* type, int32_t* out_count )
 {
-    if ( out_types )
-        *out_types = NULL;
     if ( out_count )
         *out_count = 0;
-
-    if ( g_registry && table_index >= 0 && table_index < g_registry->num_tables )
+    const cf_layout_t* layout = cf_layout_get( type );
+    if ( !layout )
     {
-        if ( out_types )
-            *out_types = g_registry->tables[ table_index ].types;
-        if ( out_count )
-            *out_count = g_registry->tables[ table_index ].count;
+        return NULL;
     }
+
+    if ( out_count )
+        *out_count = layout->count;
+    return layout->leaves;
+}
+
+// Returns the only entry index a name hash can match in a generated perfect hash.
+static int32_t
+cf_phash_find( const cf_phash_t* phash, uint64_t hash, int32_t count )
+{
+    uint32_t seed = phash->seeds[ cf_phash_bucket( hash, phash->bucket_mask ) ];
+    return phash->slots[ cf_phash_slot( hash, seed, (uint32_t)count ) ];
 }
 
 const cf_field_t*
 cf_find_field( const cf_type_t* type, const char* name )
 {
-    if ( type && type->kind == CF_KIND_STRUCT && name )
+    if ( !name )
+    {
+        return NULL;
+    }
+    return cf_find_field_n( type, name, (int32_t)strlen( name ) );
+}
+
+static const cf_field_t*
+cf_lookup_field( const cf_type_t* type, const char* name, int32_t len )
+{
+    if ( type && type->kind == CF_KIND_STRUCT && name && len >= 0 )
     {
+        uint64_t hash = cf_hash_name_n( name, len );
+        if ( type->struct_phash.seeds )
+        {
+            int32_t           index = cf_phash_find( &type->struct_phash, hash, type->struct_count );
+            const cf_field_t* field = &type->struct_array[ index ];
+            CF_STAT_PROBE();
+            return cf_name_matches( field->name, field->name_hash, name, len, hash ) ? field : NULL;
+        }
+
         for ( int32_t i = 0; i < type->struct_count; ++i )
         {
             const cf_field_t* field = &type->struct_array[ i ];
-            if ( strcmp( field->name, name ) == 0 )
+            CF_STAT_PROBE();
+            if ( cf_name_matches( field->name, field->name_hash, name, len, hash ) )
             {
                 return field;
             }
@@ -130,12 +4715,41 @@ cf_find_field( const cf_type_t* type, const char* name )
 const cf_enum_value_t*
 cf_find_enum_value_by_name( const cf_type_t* type, const char* name )
 {
-    if ( type && type->kind == CF_KIND_ENUM && name )
+    if ( !name )
+    {
+        return NULL;
+    }
+    return cf_find_enum_value_by_name_n( type, name, (int32_t)strlen( name ) );
+}
+
+static const cf_enum_value_t*
+cf_lookup_enum_value_by_name( const cf_type_t* type, const char* name, int32_t len )
+{
+    if ( type && type->kind == CF_KIND_ENUM && name && len >= 0 )
     {
+        // Generated codec.
+        if ( type->enum_index_of_name )
+        {
+            int32_t index = type->enum_index_of_name( name, len );
+            CF_STAT_PROBE();
+            return index >= 0 ? &type->enum_array[ index ] : NULL;
+        }
+
+        uint64_t hash = cf_hash_name_n( name, len );
+        if ( type->enum_phash.seeds )
+        {
+            int32_t                index      = cf_phash_find( &type->enum_phash, hash, type->enum_count );
+            const cf_enum_value_t* enum_value = &type->enum_array[ index ];
+            CF_STAT_PROBE();
+            return cf_name_matches( enum_value->name, enum_value->name_hash, name, len, hash ) ? enum_value
+                                                                                               : NULL;
+        }
+
         for ( int32_t i = 0; i < type->enum_count; ++i )
         {
             const cf_enum_value_t* enum_value = &type->enum_array[ i ];
-            if ( strcmp( enum_value->name, name ) == 0 )
+            CF_STAT_PROBE();
+            if ( cf_name_matches( enum_value->name, enum_value->name_hash, name, len, hash ) )
             {
                 return enum_value;
             }
@@ -144,14 +4758,56 @@ cf_find_enum_value_by_name( const cf_type_t* type, const char* name )
     return NULL;
 }
 
-const cf_enum_value_t*
-cf_find_enum_value_by_value( const cf_type_t* type, int32_t value )
+static const cf_enum_value_t*
+cf_lookup_enum_value_by_value( const cf_type_t* type, int32_t value )
 {
     if ( type && type->kind == CF_KIND_ENUM )
     {
+        // Dense: direct index.
+        if ( type->enum_by_value )
+        {
+            CF_STAT_PROBE();
+            uint32_t offset = (uint32_t)value - (uint32_t)type->enum_min;
+            if ( offset < (uint32_t)type->enum_range && type->enum_by_value[ offset ] >= 0 )
+            {
+                return &type->enum_array[ type->enum_by_value[ offset ] ];
+            }
+            return NULL;
+        }
+
+        // Generated codec.
+        if ( type->enum_index_of_value )
+        {
+            int32_t index = type->enum_index_of_value( value );
+            CF_STAT_PROBE();
+            return index >= 0 ? &type->enum_array[ index ] : NULL;
+        }
+
+        // Sparse: binary search for the first entry with this value.
+        if ( type->enum_sorted )
+        {
+            int32_t lo = 0;
+            int32_t hi = type->enum_count;
+            while ( lo < hi )
+            {
+                int32_t mid = lo + ( hi - lo ) / 2;
+                CF_STAT_PROBE();
+                if ( type->enum_array[ type->enum_sorted[ mid ] ].value < value )
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if ( lo < type->enum_count && type->enum_array[ type->enum_sorted[ lo ] ].value == value )
+            {
+                return &type->enum_array[ type->enum_sorted[ lo ] ];
+            }
+            return NULL;
+        }
+
         for ( int32_t i = 0; i < type->enum_count; ++i )
         {
             const cf_enum_value_t* enum_value = &type->enum_array[ i ];
+            CF_STAT_PROBE();
             if ( enum_value->value == value )
             {
                 return enum_value;
@@ -161,4 +4817,96 @@ cf_find_enum_value_by_value( const cf_type_t* type, int32_t value )
     return NULL;
 }
 
+const cf_field_t*
+cf_find_field_n( const cf_type_t* type, const char* name, int32_t len )
+{
+    CF_STAT_BEGIN();
+    const cf_field_t* field = cf_lookup_field( type, name, len );
+    CF_STAT_RECORD( CF_STAT_FIELD, field );
+    return field;
+}
+
+const cf_enum_value_t*
+cf_find_enum_value_by_name_n( const cf_type_t* type, const char* name, int32_t len )
+{
+    CF_STAT_BEGIN();
+    const cf_enum_value_t* enum_value = cf_lookup_enum_value_by_name( type, name, len );
+    CF_STAT_RECORD( CF_STAT_ENUM_BY_NAME, enum_value );
+    return enum_value;
+}
+
+const cf_enum_value_t*
+cf_find_enum_value_by_value( const cf_type_t* type, int32_t value )
+{
+    CF_STAT_BEGIN();
+    const cf_enum_value_t* enum_value = cf_lookup_enum_value_by_value( type, value );
+    CF_STAT_RECORD( CF_STAT_ENUM_BY_VALUE, enum_value );
+    return enum_value;
+}
+
+bool
+cf_enum_is_valid( const cf_type_t* type, int32_t value )
+{
+    if ( type && type->kind == CF_KIND_ENUM && type->enum_valid_bits )
+    {
+        uint32_t offset = (uint32_t)value - (uint32_t)type->enum_min;
+        return offset < (uint32_t)type->enum_range &&
+               ( type->enum_valid_bits[ offset >> 5 ] >> ( offset & 31 ) ) & 1u;
+    }
+    return cf_find_enum_value_by_value( type, value ) != NULL;
+}
+
+void
+cf_stats_snapshot( cf_stats_t* out )
+{
+    memset( out, 0, sizeof( *out ) );
+#if defined( CFLEX_STATS )
+    cf_reader_t* reader = (cf_reader_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.readers );
+    for ( ; reader; reader = reader->next )
+    {
+        for ( int32_t i = 0; i < CF_STAT_LOOKUP_COUNT; ++i )
+        {
+            const cf_stat_counters_t* counters = &reader->stats.lookups[ i ];
+            out->lookups[ i ].calls += counters->calls;
+            out->lookups[ i ].hits += counters->hits;
+            out->lookups[ i ].misses += counters->misses;
+            out->lookups[ i ].probes += counters->probes;
+        }
+    }
+#endif
+}
+
+void
+cf_stats_reset( void )
+{
+#if defined( CFLEX_STATS )
+    cf_reader_t* reader = (cf_reader_t*)cf_atomic_load_ptr( (void* volatile*)&g_registry.readers );
+    for ( ; reader; reader = reader->next ) { memset( &reader->stats, 0, sizeof( reader->stats ) ); }
+#endif
+}
+
+void
+cf_stats_dump( void )
+{
+#if !defined( CFLEX_STATS )
+    printf( "cflex stats: disabled, build with CFLEX_STATS\n" );
+#else
+    static const char* lookup_names[ CF_STAT_LOOKUP_COUNT ] = {
+        "type_by_name", "type_by_id", "field", "enum_by_name", "enum_by_value",
+    };
+
+    cf_stats_t stats;
+    cf_stats_snapshot( &stats );
+    printf( "%-14s %12s %12s %12s %12s %8s\n", "cflex lookup", "calls", "hits", "misses", "probes", "avg" );
+    for ( int32_t i = 0; i < CF_STAT_LOOKUP_COUNT; ++i )
+    {
+        const cf_stat_counters_t* counters = &stats.lookups[ i ];
+        double average = counters->calls ? (double)counters->probes / (double)counters->calls : 0.0;
+        printf( "%-14s %12llu %12llu %12llu %12llu %8.2f\n", lookup_names[ i ],
+                (unsigned long long)counters->calls, (unsigned long long)counters->hits,
+                (unsigned long long)counters->misses, (unsigned long long)counters->probes, average );
+    }
+#endif
+}
+
 #endif    // CFLEX_IMPLEMENTATION_H
@@ -1,6 +1,9 @@
 #ifndef CFLEX_MACROS_H
 #define CFLEX_MACROS_H
 
+// Annotations read by cflex_build; they expand to nothing.
+// CF_FIELD( base ) marks a struct's first member as the embedded parent struct.
+// CF_STRUCT( codegen ) also generates <type>_write(), _read(), _hash() and _equal().
 #define CF_STRUCT( ... )
 #define CF_FIELD( ... )
 #define CF_ENUM( ... )
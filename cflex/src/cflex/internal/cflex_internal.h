@@ -2,9 +2,205 @@
 #define CFLEX_INTERNAL_H
 
 #include "../cflex.h"
+#include <string.h>
 
 // This function is intended for use by the generated code only.
 // It registers a table of type pointers with the cflex runtime.
+// Registering the same table twice has no effect.
 void cf_register_type_table(const cf_type_t* types[], int32_t count);
 
+// Removes a table previously passed to cf_register_type_table(). Its types can no
+// longer be found and their dense indices are reset to -1.
+void cf_unregister_type_table( const cf_type_t* types[] );
+
+// Generated cf_type_t descriptors are exported so that other modules can reference them
+// from their field tables; a type is best reflected only by the module that owns it. If
+// several modules do reflect it, the linker keeps one descriptor and the registry
+// deduplicates the type by ID.
+#if defined( _MSC_VER )
+#    define CF_SHARED __declspec( selectany )
+#else
+#    define CF_SHARED __attribute__( ( weak ) )
+#endif
+
+// --- Packed Modules ---
+//
+// Modules generated with `cflex_build --packed` contain no per-type pointers, so they
+// need no load-time relocations: all names live in one string blob, all perfect hash
+// tables in one lookup blob, and types, fields and enum values are flat arrays that
+// refer to each other by offset or index. The runtime materializes regular cf_type_t
+// descriptors from a packed module when it is first registered.
+
+#define CF_PACKED_NONE 0xffffffffu
+
+// cf_packed_type_t.prim of a struct whose first field embeds its parent (CF_FIELD( base )).
+#define CF_PACKED_HAS_BASE 0x1
+
+// Hot data (kind, size, counts) comes first.
+typedef struct cf_packed_type_t
+{
+    uint8_t  kind;      // cf_kind_t
+    uint8_t  prim;      // cf_prim_t for primitives, CF_PACKED_HAS_BASE flag for structs
+    uint16_t align;
+    uint32_t size;
+    uint32_t first;     // Index of the first field or enum value
+    uint32_t count;     // Number of fields or enum values
+    uint32_t name;      // Offset into the string blob, CF_PACKED_NONE with --strip-names
+    uint32_t lookup;    // Offset of the name hash in the lookup blob (seeds, then slots), or CF_PACKED_NONE
+    uint64_t id;
+} cf_packed_type_t;
+
+typedef struct cf_packed_field_t
+{
+    uint32_t name;      // Offset into the string blob, CF_PACKED_NONE with --strip-names
+    uint32_t type;      // Index into the module's type ID references
+    uint32_t offset;
+} cf_packed_field_t;
+
+typedef struct cf_packed_value_t
+{
+    uint32_t name;    // Offset into the string blob, CF_PACKED_NONE with --strip-names
+    int32_t  value;
+} cf_packed_value_t;
+
+// Generated name <-> value codecs of an enum, one per enum in declaration order.
+typedef struct cf_packed_codec_t
+{
+    int32_t ( *index_of_name )( const char* name, int32_t len );
+    int32_t ( *index_of_value )( int32_t value );
+} cf_packed_codec_t;
+
+typedef struct cf_packed_module_t
+{
+    const char*                     strings;
+    const uint16_t*                 lookup;
+    const cf_packed_type_t*         types;
+    const cf_packed_field_t*        fields;
+    const cf_packed_value_t*        values;
+    const uint64_t*                 refs;    // Field type IDs, resolved against the registry
+    const cf_packed_codec_t*        codecs;
+    int32_t                         num_types;
+    int32_t                         num_fields;
+    int32_t                         num_values;
+    const uint64_t*                 field_hashes;    // Name hashes, set instead of names with --strip-names
+    const uint64_t*                 value_hashes;
+    const cf_struct_funcs_t* const* funcs;    // Generated functions by type index, NULL if none
+} cf_packed_module_t;
+
+// Registers (or unregisters) a packed module. The materialized descriptors are kept until
+// cf_shutdown(), so type pointers stay valid across unregister/register cycles.
+void cf_register_packed_module( const cf_packed_module_t* module );
+void cf_unregister_packed_module( const cf_packed_module_t* module );
+
+// --- Linker Sections ---
+//
+// Modules generated with `cflex_build --linker-sections` also place a pointer to their
+// type table in a dedicated linker section. When the runtime is compiled with
+// CFLEX_LINKER_SECTIONS it registers every table found there on the first query, so
+// no cf_initialize() or <module>_register_types() calls are needed.
+//
+// As with any section-based registration, a module in a static library is only
+// found if its object file is linked in.
+
+typedef struct cf_module_t
+{
+    const cf_type_t**         types;
+    int32_t                   count;
+    const cf_packed_module_t* packed;    // Set instead of `types` for packed modules
+} cf_module_t;
+
+#if defined( _MSC_VER )
+// Entries are sorted between the runtime's ".cflex$a" and ".cflex$z" markers.
+#    pragma section( ".cflex$m", read )
+#    define CF_MODULE_SECTION __declspec( allocate( ".cflex$m" ) )
+#elif defined( __APPLE__ )
+#    define CF_MODULE_SECTION __attribute__( ( used, section( "__DATA,cflex_modules" ) ) )
+#else
+// The name must be a C identifier so the linker provides __start_/__stop_ symbols.
+#    define CF_MODULE_SECTION __attribute__( ( used, section( "cflex_modules" ) ) )
+#endif
+
+// --- Generated Functions ---
+//
+// cf_hash_object() and the <type>_hash() functions of CF_STRUCT( codegen ) structs mix the
+// same leaves in the same order through cf_hash_bits(), so a type hashes alike on both paths.
+// The <type>_equal() functions OR the cf_diff_bits() of every leaf, with no early exit.
+
+#define CF_OBJECT_HASH_SEED 0xcbf29ce484222325ull
+
+// Mixes a value of up to 8 bytes into an object hash.
+static inline uint64_t
+cf_hash_bits( uint64_t hash, const void* value, size_t size )
+{
+    uint64_t bits = 0;
+    memcpy( &bits, value, size );
+    hash = ( hash ^ bits ) * 0xff51afd7ed558ccdull;
+    return hash ^ ( hash >> 32 );
+}
+
+// Returns zero if two values of up to 8 bytes are bitwise equal.
+static inline uint64_t
+cf_diff_bits( const void* a, const void* b, size_t size )
+{
+    uint64_t bits_a = 0;
+    uint64_t bits_b = 0;
+    memcpy( &bits_a, a, size );
+    memcpy( &bits_b, b, size );
+    return bits_a ^ bits_b;
+}
+
+// --- Images ---
+//
+// The layout written by cf_image_write(), in the writer's byte order:
+//
+//     cf_image_header_t
+//     cf_image_type_t[ num_sections ]     one per section
+//     cf_image_leaf_t[ num_leaves ]       the flattened leaves of every section's type
+//     sections                            each at a multiple of CF_IMAGE_ALIGN
+//     strings                             type names and leaf paths, then string values
+//
+// Names and string values are stored as their offset in the string section plus one, so
+// 0 is NULL. Every string is NUL-terminated.
+
+#define CF_IMAGE_MAGIC      "CFLEXIMG"
+#define CF_IMAGE_VERSION    1
+#define CF_IMAGE_BYTE_ORDER 0x01020304u
+#define CF_IMAGE_ALIGN      64
+
+typedef struct cf_image_header_t
+{
+    char     magic[ 8 ];    // CF_IMAGE_MAGIC, without the terminator
+    uint32_t version;
+    uint32_t byte_order;      // CF_IMAGE_BYTE_ORDER as the writer stores it
+    uint32_t pointer_size;    // Size of the string slots
+    uint32_t num_sections;
+    uint32_t num_leaves;
+    uint32_t reserved;
+    uint64_t size;       // Bytes in the whole image
+    uint64_t strings;    // Offset of the string section
+    uint64_t strings_size;
+    uint64_t relocated_base;    // Address string slots point into once opened, 0 before
+} cf_image_header_t;
+
+typedef struct cf_image_type_t
+{
+    uint64_t id;      // cf_type_t.id
+    uint64_t data;    // Offset of the objects
+    uint64_t count;
+    uint32_t name;    // String offset + 1, 0 without a name
+    uint32_t kind;    // cf_kind_t
+    uint32_t size;
+    uint32_t align;
+    uint32_t first_leaf;    // Index into the leaf table
+    uint32_t num_leaves;
+} cf_image_type_t;
+
+typedef struct cf_image_leaf_t
+{
+    uint32_t path;    // String offset + 1, 0 without a name
+    uint32_t offset;
+    uint32_t size;
+    uint32_t prim;    // cf_prim_t
+} cf_image_leaf_t;
+
 #endif // CFLEX_INTERNAL_H
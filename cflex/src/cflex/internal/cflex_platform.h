@@ -0,0 +1,343 @@
+#ifndef CFLEX_PLATFORM_H
+#define CFLEX_PLATFORM_H
+
+/*==============================================================================================
+
+    Platform
+
+    Minimal atomics, thread-local storage, thread exit callbacks and yielding for the
+    cflex runtime. MSVC (and clang-cl) use compiler intrinsics and fiber local storage;
+    GCC and Clang use the __atomic builtins, which work on plain variables under strict
+    C11, and pthread keys. Also the byte order and the vector instruction sets the byte
+    scanners and swaps may use.
+
+==============================================================================================*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if defined( _MSC_VER )
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN 1
+#    endif
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    include <windows.h>
+#    include <intrin.h>
+#    include <stdlib.h>
+#    define CF_THREAD_LOCAL __declspec( thread )
+#else
+#    include <pthread.h>
+#    include <sched.h>
+#    define CF_THREAD_LOCAL _Thread_local
+#endif
+
+/*============================================================================================*/
+
+#if defined( _MSC_VER )
+
+// Orders plain volatile accesses. x86 only needs a compiler barrier; ARM64 needs
+// a hardware barrier, since MSVC does not give volatile acquire/release semantics there.
+#    if defined( _M_ARM64 )
+#        define CF_ORDER_BARRIER() __dmb( _ARM64_BARRIER_ISH )
+#    else
+#        define CF_ORDER_BARRIER() _ReadWriteBarrier()
+#    endif
+
+// Loads are acquire, stores are release. Use cf_atomic_fence() where a store must be
+// visible before a later load (store-load ordering).
+
+static inline void*
+cf_atomic_load_ptr( void* volatile* ptr )
+{
+    void* value = *ptr;
+    CF_ORDER_BARRIER();
+    return value;
+}
+
+static inline void
+cf_atomic_store_ptr( void* volatile* ptr, void* value )
+{
+    CF_ORDER_BARRIER();
+    *ptr = value;
+}
+
+static inline bool
+cf_atomic_cas_ptr( void* volatile* ptr, void* expected, void* desired )
+{
+    return _InterlockedCompareExchangePointer( ptr, desired, expected ) == expected;
+}
+
+static inline bool
+cf_atomic_cas_u32( volatile uint32_t* ptr, uint32_t expected, uint32_t desired )
+{
+    return (uint32_t)_InterlockedCompareExchange( (volatile long*)ptr, (long)desired, (long)expected ) ==
+           expected;
+}
+
+static inline uint32_t
+cf_atomic_load_u32( volatile uint32_t* ptr )
+{
+    uint32_t value = *ptr;
+    CF_ORDER_BARRIER();
+    return value;
+}
+
+static inline void
+cf_atomic_store_u32( volatile uint32_t* ptr, uint32_t value )
+{
+    CF_ORDER_BARRIER();
+    *ptr = value;
+}
+
+static inline uint32_t
+cf_atomic_exchange_u32( volatile uint32_t* ptr, uint32_t value )
+{
+    return (uint32_t)_InterlockedExchange( (volatile long*)ptr, (long)value );
+}
+
+// 32-bit x86 has no plain 64-bit load or store; the interlocked forms are atomic there.
+static inline uint64_t
+cf_atomic_load_u64( volatile uint64_t* ptr )
+{
+#    if defined( _M_IX86 )
+    return (uint64_t)_InterlockedCompareExchange64( (volatile __int64*)ptr, 0, 0 );
+#    else
+    uint64_t value = *ptr;
+    CF_ORDER_BARRIER();
+    return value;
+#    endif
+}
+
+static inline void
+cf_atomic_store_u64( volatile uint64_t* ptr, uint64_t value )
+{
+#    if defined( _M_IX86 )
+    InterlockedExchange64( (volatile LONG64*)ptr, (LONG64)value );
+#    else
+    CF_ORDER_BARRIER();
+    *ptr = value;
+#    endif
+}
+
+// Full sequentially consistent fence.
+static inline void
+cf_atomic_fence( void )
+{
+    MemoryBarrier();
+}
+
+static inline void
+cf_thread_yield( void )
+{
+    SwitchToThread();
+}
+
+// A key whose callback runs with the thread's value when a thread exits. Fiber local
+// storage is used since, unlike TLS, it has such a callback.
+#    define CF_THREAD_CALLBACK NTAPI
+typedef DWORD cf_thread_key_t;
+
+static inline bool
+cf_thread_key_create( cf_thread_key_t* key, void( CF_THREAD_CALLBACK* callback )( void* ) )
+{
+    *key = FlsAlloc( callback );
+    return *key != FLS_OUT_OF_INDEXES;
+}
+
+static inline void
+cf_thread_key_set( cf_thread_key_t key, void* value )
+{
+    FlsSetValue( key, value );
+}
+
+#else
+
+// Loads are acquire, stores are release. Use cf_atomic_fence() where a store must be
+// visible before a later load (store-load ordering).
+
+static inline void*
+cf_atomic_load_ptr( void* volatile* ptr )
+{
+    return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+cf_atomic_store_ptr( void* volatile* ptr, void* value )
+{
+    __atomic_store_n( ptr, value, __ATOMIC_RELEASE );
+}
+
+static inline bool
+cf_atomic_cas_ptr( void* volatile* ptr, void* expected, void* desired )
+{
+    return __atomic_compare_exchange_n( ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+static inline bool
+cf_atomic_cas_u32( volatile uint32_t* ptr, uint32_t expected, uint32_t desired )
+{
+    return __atomic_compare_exchange_n( ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+static inline uint32_t
+cf_atomic_load_u32( volatile uint32_t* ptr )
+{
+    return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+cf_atomic_store_u32( volatile uint32_t* ptr, uint32_t value )
+{
+    __atomic_store_n( ptr, value, __ATOMIC_RELEASE );
+}
+
+static inline uint32_t
+cf_atomic_exchange_u32( volatile uint32_t* ptr, uint32_t value )
+{
+    return __atomic_exchange_n( ptr, value, __ATOMIC_SEQ_CST );
+}
+
+static inline uint64_t
+cf_atomic_load_u64( volatile uint64_t* ptr )
+{
+    return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+cf_atomic_store_u64( volatile uint64_t* ptr, uint64_t value )
+{
+    __atomic_store_n( ptr, value, __ATOMIC_RELEASE );
+}
+
+// Full sequentially consistent fence.
+static inline void
+cf_atomic_fence( void )
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+}
+
+static inline void
+cf_thread_yield( void )
+{
+    sched_yield();
+}
+
+// A key whose callback runs with the thread's value when a thread exits.
+#    define CF_THREAD_CALLBACK
+typedef pthread_key_t cf_thread_key_t;
+
+static inline bool
+cf_thread_key_create( cf_thread_key_t* key, void( CF_THREAD_CALLBACK* callback )( void* ) )
+{
+    return pthread_key_create( key, callback ) == 0;
+}
+
+static inline void
+cf_thread_key_set( cf_thread_key_t key, void* value )
+{
+    pthread_setspecific( key, value );
+}
+
+#endif
+
+/*============================================================================================*/
+
+// A writer-only spin lock. Readers of the registry never take it.
+typedef struct cf_spin_lock_t
+{
+    volatile uint32_t locked;
+} cf_spin_lock_t;
+
+static inline void
+cf_spin_lock( cf_spin_lock_t* lock )
+{
+    while ( cf_atomic_exchange_u32( &lock->locked, 1 ) != 0 ) { cf_thread_yield(); }
+}
+
+static inline void
+cf_spin_unlock( cf_spin_lock_t* lock )
+{
+    cf_atomic_store_u32( &lock->locked, 0 );
+}
+
+/*============================================================================================*/
+
+// Every MSVC target is little-endian.
+#if defined( _MSC_VER ) || ( defined( __BYTE_ORDER__ ) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+#    define CF_LITTLE_ENDIAN 1
+#else
+#    define CF_LITTLE_ENDIAN 0
+#endif
+
+// SSE2 is part of every x86-64 target, so it is used without a runtime check. AVX2 is used
+// only when the compiler targets it (-mavx2, /arch:AVX2).
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#    define CF_HAS_SSE2 1
+#    include <emmintrin.h>
+#else
+#    define CF_HAS_SSE2 0
+#endif
+#if defined( __AVX2__ )
+#    define CF_HAS_AVX2 1
+#    include <immintrin.h>
+#else
+#    define CF_HAS_AVX2 0
+#endif
+
+// SSSE3 adds the byte shuffle (pshufb) of the byte-order swaps. Not part of the x86-64
+// baseline, so it is used only when the compiler targets it (-mssse3 and up, /arch:AVX2).
+#if defined( __SSSE3__ ) || CF_HAS_AVX2
+#    define CF_HAS_SSSE3 1
+#    include <tmmintrin.h>
+#else
+#    define CF_HAS_SSSE3 0
+#endif
+
+// Index of the lowest set bit. `mask` must not be 0.
+static inline int32_t
+cf_ctz32( uint32_t mask )
+{
+#if defined( _MSC_VER )
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return (int32_t)index;
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+
+// Reverse the bytes of a value; each compiles to a single instruction.
+static inline uint16_t
+cf_bswap16( uint16_t value )
+{
+#if defined( _MSC_VER )
+    return _byteswap_ushort( value );
+#else
+    return __builtin_bswap16( value );
+#endif
+}
+
+static inline uint32_t
+cf_bswap32( uint32_t value )
+{
+#if defined( _MSC_VER )
+    return _byteswap_ulong( value );
+#else
+    return __builtin_bswap32( value );
+#endif
+}
+
+static inline uint64_t
+cf_bswap64( uint64_t value )
+{
+#if defined( _MSC_VER )
+    return _byteswap_uint64( value );
+#else
+    return __builtin_bswap64( value );
+#endif
+}
+
+/*============================================================================================*/
+#endif    // CFLEX_PLATFORM_H
@@ -0,0 +1,864 @@
+#include "cflex_bench_types.h"
+#include "cflex.h"
+#include "cflex_bench_generated.h"
+#include "internal/cflex_internal.h"    // cf_register_type_table() for the synthetic types
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*==============================================================================================
+
+    cflex_bench
+
+    Microbenchmarks of the cflex runtime. Every benchmark runs a fixed number of operations
+    a few times and keeps the fastest run, reported in nanoseconds per operation.
+
+        cflex_bench [--quick] [--json <results.json>] [--compare <baseline.json>]
+                    [--threshold <fraction>]
+
+    --json writes the results in the format --compare reads, so a stored run serves as the
+    baseline of the next. --compare exits with 1 if any benchmark got slower than the
+    baseline by more than the threshold (0.15 by default). A benchmark whose operations fail
+    is reported as failed instead of timed, and the run exits with 2. Benchmarks that look
+    up or write names are skipped when the generated tables have them stripped.
+
+==============================================================================================*/
+
+#define BENCH_MAX_RESULTS 64
+#define BENCH_NAME_LENGTH 64
+#define BENCH_REPEATS     3
+#define BENCH_OPS         ( 1 << 20 )
+#define BENCH_QUICK_OPS   ( 1 << 16 )
+
+#define BENCH_NUM_QUERIES  1024    // Lookup keys cycled through by the lookup benchmarks
+#define BENCH_SYNTH_FIELDS 8       // Fields of each synthetic struct
+#define BENCH_NUM_ENTITIES 4096    // Array length of the bulk benchmarks
+
+typedef struct bench_result_t
+{
+    char   name[ BENCH_NAME_LENGTH ];
+    double ns_per_op;
+    long   ops;
+} bench_result_t;
+
+// A benchmark body: performs `ops` operations on `ctx`.
+typedef void ( *bench_fn_t )( void* ctx, long ops );
+
+static bench_result_t     g_results[ BENCH_MAX_RESULTS ];
+static int32_t            g_num_results  = 0;
+static int32_t            g_num_failures = 0;
+static long               g_ops          = BENCH_OPS;
+static volatile uintptr_t g_sink         = 0;        // Keeps the compiler from dropping results
+static bool               g_failed       = false;    // Set by a benchmark body whose operation failed
+
+/*============================================================================================*/
+
+// Wall clock time in nanoseconds. timespec_get() is the only C11 clock with sub-second
+// resolution; runs are short enough that clock adjustments do not matter.
+static double
+bench_now_ns( void )
+{
+    struct timespec ts;
+    timespec_get( &ts, TIME_UTC );
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Marks the benchmark in progress as failed unless `ok`.
+static void
+bench_check( bool ok )
+{
+    if ( !ok )
+    {
+        g_failed = true;
+    }
+}
+
+// Reports a benchmark that could not run, which keeps it out of the results.
+static void
+bench_fail( const char* name )
+{
+    g_num_failures++;
+    printf( "%-40s %10s\n", name, "FAILED" );
+}
+
+// Reports a benchmark that does not apply to this build.
+static void
+bench_skip( const char* name, const char* reason )
+{
+    printf( "%-40s %10s (%s)\n", name, "skipped", reason );
+}
+
+// Runs a benchmark and records its fastest run, or reports it as failed.
+static void
+bench_run( const char* name, bench_fn_t fn, void* ctx, long ops )
+{
+    double best = 0.0;
+    g_failed    = false;
+    for ( int32_t i = 0; i < BENCH_REPEATS && !g_failed; ++i )
+    {
+        double start = bench_now_ns();
+        fn( ctx, ops );
+        double elapsed = bench_now_ns() - start;
+        if ( i == 0 || elapsed < best )
+        {
+            best = elapsed;
+        }
+    }
+    if ( g_failed )
+    {
+        bench_fail( name );
+        return;
+    }
+
+    if ( g_num_results < BENCH_MAX_RESULTS )
+    {
+        bench_result_t* result = &g_results[ g_num_results++ ];
+        snprintf( result->name, sizeof( result->name ), "%s", name );
+        result->ns_per_op = best / (double)ops;
+        result->ops       = ops;
+        printf( "%-40s %10.2f ns/op\n", name, result->ns_per_op );
+    }
+}
+
+/*==============================================================================================
+
+    Synthetic Registry
+
+==============================================================================================*/
+
+// `count` structs named "synth_<n>_t" with BENCH_SYNTH_FIELDS int32_t fields "f0".."f<n>",
+// registered as one table. Built by hand, so lookups take the scan paths the generator's
+// perfect hashes avoid.
+typedef struct synth_set_t
+{
+    cf_type_t*        types;
+    cf_type_state_t*  states;
+    const cf_type_t** table;
+    cf_field_t*       fields;
+    char ( *names )[ 24 ];
+    int32_t count;
+} synth_set_t;
+
+static const char* synth_field_names[ BENCH_SYNTH_FIELDS ] = { "f0", "f1", "f2", "f3",
+                                                               "f4", "f5", "f6", "f7" };
+
+static bool
+synth_create( synth_set_t* set, int32_t count )
+{
+    memset( set, 0, sizeof( *set ) );
+    set->types  = (cf_type_t*)calloc( (size_t)count, sizeof( cf_type_t ) );
+    set->states = (cf_type_state_t*)calloc( (size_t)count, sizeof( cf_type_state_t ) );
+    set->table  = (const cf_type_t**)calloc( (size_t)count, sizeof( const cf_type_t* ) );
+    set->fields = (cf_field_t*)calloc( BENCH_SYNTH_FIELDS, sizeof( cf_field_t ) );
+    set->names  = calloc( (size_t)count, sizeof( *set->names ) );
+    set->count  = count;
+    if ( !set->types || !set->states || !set->table || !set->fields || !set->names )
+    {
+        return false;
+    }
+
+    // The descriptors have const members, so they are filled in through initialized copies.
+    for ( int32_t i = 0; i < BENCH_SYNTH_FIELDS; ++i )
+    {
+        cf_field_t field = { synth_field_names[ i ], &cf_type_i32, i * 4, 0,
+                             cf_hash_name( synth_field_names[ i ] ) };
+        memcpy( &set->fields[ i ], &field, sizeof( field ) );
+    }
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        snprintf( set->names[ i ], sizeof( set->names[ i ] ), "synth_%d_t", (int)i );
+        set->states[ i ].index = -1;
+
+        cf_type_t type         = { .name         = set->names[ i ],
+                                   .kind         = CF_KIND_STRUCT,
+                                   .size         = BENCH_SYNTH_FIELDS * 4,
+                                   .align        = 4,
+                                   .id           = cf_hash_name( set->names[ i ] ),
+                                   .state        = &set->states[ i ],
+                                   .struct_array = set->fields,
+                                   .struct_count = BENCH_SYNTH_FIELDS };
+        memcpy( &set->types[ i ], &type, sizeof( type ) );
+        set->table[ i ] = &set->types[ i ];
+    }
+
+    cf_register_type_table( set->table, count );
+    return true;
+}
+
+static void
+synth_destroy( synth_set_t* set )
+{
+    if ( set->table )
+    {
+        cf_unregister_type_table( set->table );
+    }
+    free( set->types );
+    free( set->states );
+    free( set->table );
+    free( set->fields );
+    free( (void*)set->names );
+    memset( set, 0, sizeof( *set ) );
+}
+
+/*==============================================================================================
+
+    Lookup Benchmarks
+
+==============================================================================================*/
+
+typedef struct lookup_ctx_t
+{
+    char             names[ BENCH_NUM_QUERIES ][ 24 ];
+    uint64_t         ids[ BENCH_NUM_QUERIES ];
+    const cf_type_t* type;
+} lookup_ctx_t;
+
+static lookup_ctx_t g_lookup;
+
+// Fills the query keys: `hit_percent` of them name registered synthetic types, spread
+// over the whole set, and the rest name types that do not exist.
+static void
+lookup_prepare( const synth_set_t* set, int32_t hit_percent )
+{
+    for ( int32_t i = 0; i < BENCH_NUM_QUERIES; ++i )
+    {
+        bool hit = ( i * 100 / BENCH_NUM_QUERIES ) < hit_percent;
+        if ( hit )
+        {
+            int32_t index = (int32_t)( ( (uint32_t)i * 2654435761u ) % (uint32_t)set->count );
+            snprintf( g_lookup.names[ i ], sizeof( g_lookup.names[ i ] ), "%s", set->names[ index ] );
+        }
+        else
+        {
+            snprintf( g_lookup.names[ i ], sizeof( g_lookup.names[ i ] ), "missing_%d_t", (int)i );
+        }
+        g_lookup.ids[ i ] = cf_hash_name( g_lookup.names[ i ] );
+    }
+}
+
+static void
+bench_type_by_name( void* ctx, long ops )
+{
+    lookup_ctx_t* lookup = (lookup_ctx_t*)ctx;
+    uintptr_t     sink   = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sink += (uintptr_t)cf_find_type_by_name( lookup->names[ i & ( BENCH_NUM_QUERIES - 1 ) ] );
+    }
+    g_sink = sink;
+}
+
+static void
+bench_type_by_id( void* ctx, long ops )
+{
+    lookup_ctx_t* lookup = (lookup_ctx_t*)ctx;
+    uintptr_t     sink   = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sink += (uintptr_t)cf_find_type_by_id( lookup->ids[ i & ( BENCH_NUM_QUERIES - 1 ) ] );
+    }
+    g_sink = sink;
+}
+
+// Cycles through every field name of lookup->type plus one miss.
+static void
+bench_field( void* ctx, long ops )
+{
+    lookup_ctx_t* lookup = (lookup_ctx_t*)ctx;
+    int32_t       count  = lookup->type->struct_count + 1;
+    uintptr_t     sink   = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        int32_t     index = (int32_t)( i % count );
+        const char* name =
+            index < lookup->type->struct_count ? lookup->type->struct_array[ index ].name : "missing";
+        sink += (uintptr_t)cf_find_field( lookup->type, name );
+    }
+    g_sink = sink;
+}
+
+static void
+bench_enum_by_name( void* ctx, long ops )
+{
+    lookup_ctx_t* lookup = (lookup_ctx_t*)ctx;
+    int32_t       count  = lookup->type->enum_count;
+    uintptr_t     sink   = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sink +=
+            (uintptr_t)cf_find_enum_value_by_name( lookup->type, lookup->type->enum_array[ i % count ].name );
+    }
+    g_sink = sink;
+}
+
+static void
+bench_enum_by_value( void* ctx, long ops )
+{
+    lookup_ctx_t* lookup = (lookup_ctx_t*)ctx;
+    int32_t       count  = lookup->type->enum_count;
+    uintptr_t     sink   = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sink += (uintptr_t)cf_find_enum_value_by_value( lookup->type,
+                                                        lookup->type->enum_array[ i % count ].value );
+    }
+    g_sink = sink;
+}
+
+static void
+run_lookup_benchmarks( void )
+{
+    static const int32_t registry_sizes[] = { 256, 2048, 8192 };
+    static const int32_t hit_percents[]   = { 100, 50, 0 };
+    char                 name[ BENCH_NAME_LENGTH ];
+
+    for ( size_t s = 0; s < sizeof( registry_sizes ) / sizeof( registry_sizes[ 0 ] ); ++s )
+    {
+        synth_set_t set;
+        if ( !synth_create( &set, registry_sizes[ s ] ) )
+        {
+            printf( "Out of memory for %d synthetic types, skipped.\n", (int)registry_sizes[ s ] );
+            synth_destroy( &set );
+            continue;
+        }
+
+        for ( size_t h = 0; h < sizeof( hit_percents ) / sizeof( hit_percents[ 0 ] ); ++h )
+        {
+            lookup_prepare( &set, hit_percents[ h ] );
+            snprintf( name, sizeof( name ), "type_by_name/%d/hit%d", (int)set.count, (int)hit_percents[ h ] );
+            bench_run( name, bench_type_by_name, &g_lookup, g_ops );
+            snprintf( name, sizeof( name ), "type_by_id/%d/hit%d", (int)set.count, (int)hit_percents[ h ] );
+            bench_run( name, bench_type_by_id, &g_lookup, g_ops );
+        }
+
+        if ( s == 0 )
+        {
+            g_lookup.type = &set.types[ 0 ];
+            bench_run( "field/scan", bench_field, &g_lookup, g_ops );
+        }
+        synth_destroy( &set );
+    }
+
+    // The generated tables are queried by their own names, which --strip-names leaves out.
+    g_lookup.type = cf_find_type_by_name( "bench_entity_t" );
+    if ( !g_lookup.type )
+    {
+        bench_fail( "field/generated" );
+    }
+    else if ( !g_lookup.type->struct_array[ 0 ].name )
+    {
+        bench_skip( "field/generated", "names are stripped" );
+    }
+    else
+    {
+        bench_run( "field/generated", bench_field, &g_lookup, g_ops );
+    }
+
+    static const char* enum_names[]    = { "bench_state_t", "bench_event_t" };
+    static const char* enum_variants[] = { "dense", "sparse" };
+    for ( size_t e = 0; e < sizeof( enum_names ) / sizeof( enum_names[ 0 ] ); ++e )
+    {
+        g_lookup.type = cf_find_type_by_name( enum_names[ e ] );
+        snprintf( name, sizeof( name ), "enum_by_name/%s", enum_variants[ e ] );
+        if ( !g_lookup.type )
+        {
+            bench_fail( name );
+        }
+        else if ( !g_lookup.type->enum_array[ 0 ].name )
+        {
+            bench_skip( name, "names are stripped" );
+        }
+        else
+        {
+            bench_run( name, bench_enum_by_name, &g_lookup, g_ops );
+        }
+
+        snprintf( name, sizeof( name ), "enum_by_value/%s", enum_variants[ e ] );
+        if ( !g_lookup.type )
+        {
+            bench_fail( name );
+        }
+        else
+        {
+            bench_run( name, bench_enum_by_value, &g_lookup, g_ops );
+        }
+    }
+}
+
+/*==============================================================================================
+
+    Bulk Benchmarks
+
+    One operation is one entity, so results compare directly with the lookups.
+
+==============================================================================================*/
+
+typedef struct bulk_ctx_t
+{
+    bench_entity_t*  entities;
+    float*           values;
+    cf_path_t        path;
+    const cf_type_t* type;
+    uint8_t*         buffer;
+    size_t           buffer_size;
+    char*            json;
+    size_t           json_size;
+    uint8_t*         image;
+    size_t           image_size;
+    cf_migration_t*  migration;
+    void*            migrated;
+    cf_byte_order_t  order;
+} bulk_ctx_t;
+
+static void
+bench_path_get( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    float       sum  = 0.0f;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sum += cf_path_get_f32( &bulk->path, &bulk->entities[ i & ( BENCH_NUM_ENTITIES - 1 ) ] );
+    }
+    g_sink = (uintptr_t)sum;
+}
+
+static void
+bench_path_gather( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        cf_path_gather( &bulk->path, bulk->entities, sizeof( bench_entity_t ), BENCH_NUM_ENTITIES,
+                        bulk->values );
+    }
+    g_sink = (uintptr_t)bulk->values[ 1 ];
+}
+
+static void
+bench_serialize( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink =
+            cf_serialize( bulk->type, bulk->entities, BENCH_NUM_ENTITIES, bulk->buffer, bulk->buffer_size );
+        bench_check( g_sink != 0 );
+    }
+}
+
+static void
+bench_deserialize( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink =
+            cf_deserialize( bulk->type, bulk->entities, BENCH_NUM_ENTITIES, bulk->buffer, bulk->buffer_size );
+        bench_check( g_sink != 0 );
+    }
+}
+
+static void
+bench_encode( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink = cf_encode( bulk->type, bulk->entities, BENCH_NUM_ENTITIES, bulk->order, bulk->buffer,
+                            bulk->buffer_size );
+        bench_check( g_sink != 0 );
+    }
+}
+
+static void
+bench_decode( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink = cf_decode( bulk->type, bulk->entities, BENCH_NUM_ENTITIES, bulk->order, bulk->buffer,
+                            bulk->buffer_size );
+        bench_check( g_sink != 0 );
+    }
+}
+
+static void
+bench_hash( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    uint64_t    sink = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        sink ^= cf_hash_object( bulk->type, &bulk->entities[ i & ( BENCH_NUM_ENTITIES - 1 ) ] );
+    }
+    g_sink = (uintptr_t)sink;
+}
+
+static void
+bench_equal( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    uintptr_t   sink = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        const bench_entity_t* entity = &bulk->entities[ i & ( BENCH_NUM_ENTITIES - 1 ) ];
+        sink += cf_objects_equal( bulk->type, entity, &bulk->entities[ 0 ] );
+    }
+    g_sink = sink;
+}
+
+static void
+bench_json_write( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        cf_json_writer_t writer;
+        cf_json_writer_init( &writer, bulk->json, bulk->json_size, NULL, NULL );
+        bench_check( cf_json_write_array( &writer, bulk->type, bulk->entities, BENCH_NUM_ENTITIES ) );
+        g_sink = writer.used;
+    }
+}
+
+static void
+bench_json_read( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        cf_json_reader_t reader;
+        cf_json_reader_init( &reader, bulk->json, bulk->json_size, NULL, 0 );
+        int32_t count = cf_json_read_array( &reader, bulk->type, bulk->entities, BENCH_NUM_ENTITIES );
+        bench_check( count == BENCH_NUM_ENTITIES );
+        g_sink = (uintptr_t)count;
+    }
+}
+
+static void
+bench_image_write( void* ctx, long ops )
+{
+    bulk_ctx_t*        bulk    = (bulk_ctx_t*)ctx;
+    cf_image_section_t section = { bulk->type, bulk->entities, BENCH_NUM_ENTITIES };
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink = cf_image_write( &section, 1, bulk->image, bulk->image_size );
+        bench_check( g_sink != 0 );
+    }
+}
+
+// Opening an image and getting its objects costs the same for any number of them.
+static void
+bench_image_open( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        cf_image_t image;
+        int32_t    count = 0;
+        if ( cf_image_open( &image, bulk->image, bulk->image_size ) )
+        {
+            g_sink = (uintptr_t)cf_image_get_section( &image, 0, bulk->type, &count );
+        }
+        bench_check( count == BENCH_NUM_ENTITIES );
+        g_sink += (uintptr_t)count;
+    }
+}
+
+static void
+bench_migrate( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    for ( long done = 0; done < ops; done += BENCH_NUM_ENTITIES )
+    {
+        g_sink = cf_migrate( bulk->migration, bulk->entities, bulk->migrated, BENCH_NUM_ENTITIES );
+        bench_check( g_sink != 0 );
+    }
+}
+
+// Visits every leaf of every entity through the cached flattened layout.
+static void
+bench_leaves( void* ctx, long ops )
+{
+    bulk_ctx_t* bulk = (bulk_ctx_t*)ctx;
+    uintptr_t   sink = 0;
+    for ( long i = 0; i < ops; ++i )
+    {
+        int32_t          count;
+        const cf_leaf_t* leaves = cf_get_leaves( bulk->type, &count );
+        const uint8_t*   entity = (const uint8_t*)&bulk->entities[ i & ( BENCH_NUM_ENTITIES - 1 ) ];
+        for ( int32_t j = 0; j < count; ++j ) { sink += entity[ leaves[ j ].offset ]; }
+    }
+    g_sink = sink;
+}
+
+static void
+run_bulk_benchmarks( void )
+{
+    bulk_ctx_t bulk;
+    bulk.entities  = (bench_entity_t*)calloc( BENCH_NUM_ENTITIES, sizeof( bench_entity_t ) );
+    bulk.values    = (float*)calloc( BENCH_NUM_ENTITIES, sizeof( float ) );
+    bulk.type      = cf_find_type_by_name( "bench_entity_t" );
+    bulk.buffer    = (uint8_t*)malloc( BENCH_NUM_ENTITIES * sizeof( bench_entity_t ) );
+    bulk.json_size = BENCH_NUM_ENTITIES * 512;
+    bulk.json      = (char*)malloc( bulk.json_size );
+    if ( !bulk.entities || !bulk.values || !bulk.type || !bulk.buffer || !bulk.json )
+    {
+        printf( "Bulk benchmarks skipped.\n" );
+        free( bulk.entities );
+        free( bulk.values );
+        free( bulk.buffer );
+        free( bulk.json );
+        return;
+    }
+
+    for ( int32_t i = 0; i < BENCH_NUM_ENTITIES; ++i )
+    {
+        bulk.entities[ i ].id         = i;
+        bulk.entities[ i ].position.y = (float)i;
+        bulk.entities[ i ].velocity.x = (float)i * 0.25f;
+        bulk.entities[ i ].health     = 100.0f;
+        bulk.entities[ i ].spawn_time = (double)i * 0.001;
+    }
+
+    bulk.path = cf_path_compile( bulk.type, "position.y" );
+    bench_run( "path/get_f32", bench_path_get, &bulk, g_ops );
+    bench_run( "path/gather_f32", bench_path_gather, &bulk, g_ops );
+    bench_run( "leaves/visit", bench_leaves, &bulk, g_ops / 8 );
+
+    bulk.buffer_size = cf_serialize( bulk.type, bulk.entities, BENCH_NUM_ENTITIES, NULL, 0 );
+    bench_run( "serialize/entity", bench_serialize, &bulk, g_ops );
+    bench_run( "deserialize/entity", bench_deserialize, &bulk, g_ops );
+
+    // The host's order is a plain cf_serialize(); the other one swaps every leaf.
+    bulk.order = cf_host_byte_order();
+    bench_run( "encode/native/entity", bench_encode, &bulk, g_ops );
+    bulk.order = bulk.order == CF_BYTE_ORDER_LITTLE ? CF_BYTE_ORDER_BIG : CF_BYTE_ORDER_LITTLE;
+    bench_run( "encode/swap/entity", bench_encode, &bulk, g_ops );
+    bench_run( "decode/swap/entity", bench_decode, &bulk, g_ops );
+    bench_run( "hash/entity", bench_hash, &bulk, g_ops );
+    bench_run( "equal/entity", bench_equal, &bulk, g_ops );
+
+    // The reader parses what the writer produced. JSON keys are field names, which
+    // --strip-names leaves out.
+    cf_json_writer_t writer;
+    if ( !bulk.type->struct_array[ 0 ].name )
+    {
+        bench_skip( "json/write/entity", "names are stripped" );
+        bench_skip( "json/read/entity", "names are stripped" );
+    }
+    else
+    {
+        bench_run( "json/write/entity", bench_json_write, &bulk, g_ops / 8 );
+        cf_json_writer_init( &writer, bulk.json, bulk.json_size, NULL, NULL );
+        if ( cf_json_write_array( &writer, bulk.type, bulk.entities, BENCH_NUM_ENTITIES ) )
+        {
+            bulk.json_size = writer.used;
+            bench_run( "json/read/entity", bench_json_read, &bulk, g_ops / 8 );
+        }
+        else
+        {
+            bench_fail( "json/read/entity" );
+        }
+    }
+
+    cf_image_section_t section = { bulk.type, bulk.entities, BENCH_NUM_ENTITIES };
+    bulk.image_size            = cf_image_write( &section, 1, NULL, 0 );
+    bulk.image                 = (uint8_t*)malloc( bulk.image_size );
+    if ( bulk.image )
+    {
+        bench_run( "image/write/entity", bench_image_write, &bulk, g_ops );
+        bench_run( "image/open/entity", bench_image_open, &bulk, g_ops );
+    }
+    else
+    {
+        bench_fail( "image/write/entity" );
+        bench_fail( "image/open/entity" );
+    }
+
+    // To the same layout under another name, then to a later version of the struct.
+    bulk.migrated = calloc( BENCH_NUM_ENTITIES, sizeof( bench_entity_v2_t ) );
+    if ( bulk.migrated )
+    {
+        bulk.migration = cf_migration_compile( bulk.type, cf_find_type_by_name( "bench_message_t" ), NULL );
+        if ( bulk.migration )
+        {
+            bench_run( "migrate/copy/entity", bench_migrate, &bulk, g_ops );
+            cf_migration_free( bulk.migration );
+        }
+        bulk.migration = cf_migration_compile( bulk.type, cf_find_type_by_name( "bench_entity_v2_t" ), NULL );
+        if ( bulk.migration )
+        {
+            bench_run( "migrate/plan/entity", bench_migrate, &bulk, g_ops );
+            cf_migration_free( bulk.migration );
+        }
+    }
+
+    // The same objects as bench_message_t, through its generated functions.
+    _Static_assert( sizeof( bench_message_t ) == sizeof( bench_entity_t ),
+                    "bench_message_t mirrors bench_entity_t" );
+    bulk.type = cf_find_type_by_name( "bench_message_t" );
+    if ( bulk.type )
+    {
+        bench_run( "serialize/message", bench_serialize, &bulk, g_ops );
+        bench_run( "deserialize/message", bench_deserialize, &bulk, g_ops );
+        bench_run( "hash/message", bench_hash, &bulk, g_ops );
+        bench_run( "equal/message", bench_equal, &bulk, g_ops );
+    }
+
+    free( bulk.entities );
+    free( bulk.values );
+    free( bulk.buffer );
+    free( bulk.json );
+    free( bulk.image );
+    free( bulk.migrated );
+}
+
+/*==============================================================================================
+
+    Results
+
+==============================================================================================*/
+
+static bool
+write_json( const char* path )
+{
+    FILE* fp = fopen( path, "w" );
+    if ( !fp )
+    {
+        fprintf( stderr, "Error: Could not open file for writing: %s\n", path );
+        return false;
+    }
+
+    fprintf( fp, "{\n  \"benchmarks\": [\n" );
+    for ( int32_t i = 0; i < g_num_results; ++i )
+    {
+        const bench_result_t* result = &g_results[ i ];
+        fprintf( fp, "    { \"name\": \"%s\", \"ns_per_op\": %.4f, \"ops\": %ld }%s\n", result->name,
+                 result->ns_per_op, result->ops, i + 1 < g_num_results ? "," : "" );
+    }
+    fprintf( fp, "  ]\n}\n" );
+    fclose( fp );
+    return true;
+}
+
+// Compares the results with a file written by --json. Returns the number of regressions,
+// or -1 if the baseline cannot be read.
+static int32_t
+compare_baseline( const char* path, double threshold )
+{
+    FILE* fp = fopen( path, "r" );
+    if ( !fp )
+    {
+        fprintf( stderr, "Error: Could not open baseline: %s\n", path );
+        return -1;
+    }
+
+    printf( "\n%-40s %12s %12s %9s\n", "Benchmark", "Baseline", "Current", "Change" );
+
+    int32_t num_regressions = 0;
+    char    line[ 256 ];
+    while ( fgets( line, sizeof( line ), fp ) )
+    {
+        // One result per line, as written by write_json().
+        char   name[ BENCH_NAME_LENGTH ];
+        double baseline;
+        if ( sscanf( line, " { \"name\": \"%63[^\"]\", \"ns_per_op\": %lf", name, &baseline ) != 2 )
+        {
+            continue;
+        }
+
+        const bench_result_t* current = NULL;
+        for ( int32_t i = 0; i < g_num_results && !current; ++i )
+        {
+            current = strcmp( g_results[ i ].name, name ) == 0 ? &g_results[ i ] : NULL;
+        }
+        if ( !current )
+        {
+            printf( "%-40s %12.2f %12s\n", name, baseline, "missing" );
+            continue;
+        }
+
+        double change     = baseline > 0.0 ? current->ns_per_op / baseline - 1.0 : 0.0;
+        bool   regression = change > threshold;
+        num_regressions += regression;
+        printf( "%-40s %12.2f %12.2f %+8.1f%%%s\n", name, baseline, current->ns_per_op, change * 100.0,
+                regression ? "  REGRESSION" : "" );
+    }
+    fclose( fp );
+
+    printf( "%d regression(s) above %.0f%%.\n", (int)num_regressions, threshold * 100.0 );
+    return num_regressions;
+}
+
+int
+main( int argc, char** argv )
+{
+    const char* json_path     = NULL;
+    const char* baseline_path = NULL;
+    double      threshold     = 0.15;
+
+    for ( int i = 1; i < argc; ++i )
+    {
+        if ( strcmp( argv[ i ], "--quick" ) == 0 )
+        {
+            g_ops = BENCH_QUICK_OPS;
+        }
+        else if ( strcmp( argv[ i ], "--json" ) == 0 && i + 1 < argc )
+        {
+            json_path = argv[ ++i ];
+        }
+        else if ( strcmp( argv[ i ], "--compare" ) == 0 && i + 1 < argc )
+        {
+            baseline_path = argv[ ++i ];
+        }
+        else if ( strcmp( argv[ i ], "--threshold" ) == 0 && i + 1 < argc )
+        {
+            threshold = atof( argv[ ++i ] );
+        }
+        else
+        {
+            fprintf( stderr,
+                     "Usage: %s [--quick] [--json <results.json>] [--compare <baseline.json>] "
+                     "[--threshold <fraction>]\n",
+                     argv[ 0 ] );
+            return 2;
+        }
+    }
+
+    cf_initialize();
+#if !defined( CFLEX_LINKER_SECTIONS )
+    cflex_bench_register_types();    // Otherwise found through the linker section on the first query
+#endif
+
+    printf( "--- Running C-Flex Benchmarks ---\n" );
+    run_lookup_benchmarks();
+    run_bulk_benchmarks();
+    printf( "---------------------------------\n" );
+
+    int result = g_num_failures > 0 ? 2 : 0;
+    if ( g_num_failures > 0 )
+    {
+        printf( "%d benchmark(s) failed.\n", (int)g_num_failures );
+    }
+    if ( json_path && !write_json( json_path ) )
+    {
+        result = 2;
+    }
+    if ( baseline_path )
+    {
+        int32_t num_regressions = compare_baseline( baseline_path, threshold );
+        if ( num_regressions < 0 )
+        {
+            result = 2;
+        }
+        else if ( num_regressions > 0 && result == 0 )
+        {
+            result = 1;
+        }
+    }
+
+    cf_shutdown();
+    return result;
+}
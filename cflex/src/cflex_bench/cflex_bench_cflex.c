@@ -0,0 +1,7 @@
+// This file is the unity build container for the cflex library for the 'cflex_bench' executable.
+// It includes the library implementation and all necessary generated reflection data for the benchmarks.
+
+// Include the generated C files for the modules this executable needs.
+#include "cflex_bench_generated.c"
+
+#include "cflex_implementation.c"
@@ -0,0 +1,101 @@
+#ifndef CFLEX_BENCH_TYPES_H
+#define CFLEX_BENCH_TYPES_H
+
+#include "cflex_macros.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Generated types for the lookup and bulk benchmarks. The large registries are built from
+// synthetic descriptors at runtime, since cflex_build caps a module at MAX_USER_TYPES.
+
+CF_STRUCT()
+typedef struct bench_vec3_t
+{
+    CF_FIELD() float x;
+    CF_FIELD() float y;
+    CF_FIELD() float z;
+} bench_vec3_t;
+
+// Dense values: looked up through a direct-index table.
+CF_ENUM()
+typedef enum bench_state_t
+{
+    BENCH_STATE_IDLE,
+    BENCH_STATE_WALK,
+    BENCH_STATE_RUN,
+    BENCH_STATE_JUMP,
+    BENCH_STATE_FALL,
+    BENCH_STATE_SWIM,
+    BENCH_STATE_CLIMB,
+    BENCH_STATE_CROUCH,
+    BENCH_STATE_ATTACK,
+    BENCH_STATE_BLOCK,
+    BENCH_STATE_STUNNED,
+    BENCH_STATE_DEAD
+} bench_state_t;
+
+// Spread-out values: looked up through a sorted table.
+CF_ENUM()
+typedef enum bench_event_t
+{
+    BENCH_EVENT_SPAWN   = -5000,
+    BENCH_EVENT_DAMAGE  = 10,
+    BENCH_EVENT_HEAL    = 250,
+    BENCH_EVENT_PICKUP  = 4000,
+    BENCH_EVENT_DESPAWN = 90000
+} bench_event_t;
+
+CF_STRUCT()
+typedef struct bench_entity_t
+{
+    CF_FIELD() int32_t id;
+    CF_FIELD() bench_vec3_t position;
+    CF_FIELD() bench_vec3_t velocity;
+    CF_FIELD() float health;
+    CF_FIELD() float armor;
+    CF_FIELD() uint32_t flags;
+    CF_FIELD() bench_state_t state;
+    CF_FIELD() int64_t owner;
+    CF_FIELD() double spawn_time;
+    CF_FIELD() uint16_t team;
+    CF_FIELD() uint8_t level;
+    CF_FIELD() bool visible;
+} bench_entity_t;
+
+// bench_entity_t with generated functions, to compare them against the copy plans.
+CF_STRUCT( codegen )
+typedef struct bench_message_t
+{
+    CF_FIELD() int32_t id;
+    CF_FIELD() bench_vec3_t position;
+    CF_FIELD() bench_vec3_t velocity;
+    CF_FIELD() float health;
+    CF_FIELD() float armor;
+    CF_FIELD() uint32_t flags;
+    CF_FIELD() bench_state_t state;
+    CF_FIELD() int64_t owner;
+    CF_FIELD() double spawn_time;
+    CF_FIELD() uint16_t team;
+    CF_FIELD() uint8_t level;
+    CF_FIELD() bool visible;
+} bench_message_t;
+
+// A later version of bench_entity_t: fields reordered and widened, one added, one removed.
+CF_STRUCT()
+typedef struct bench_entity_v2_t
+{
+    CF_FIELD() int64_t id;
+    CF_FIELD() bench_state_t state;
+    CF_FIELD() bench_vec3_t position;
+    CF_FIELD() bench_vec3_t velocity;
+    CF_FIELD() double health;
+    CF_FIELD() double armor;
+    CF_FIELD() float shield;
+    CF_FIELD() uint32_t flags;
+    CF_FIELD() int64_t owner;
+    CF_FIELD() double spawn_time;
+    CF_FIELD() uint32_t team;
+    CF_FIELD() uint8_t level;
+} bench_entity_v2_t;
+
+#endif    // CFLEX_BENCH_TYPES_H
@@ -11,6 +11,9 @@
 #include <assert.h>
 #include <string.h>
 
+// Name hashing shared with the cflex runtime.
+#include "../cflex/cflex_hash.h"
+
 // Include the internal API header
 #include "internal/cflex_internal.h"
 
@@ -23,7 +26,11 @@
 #include "internal/cflex_parse_struct.c"
 #include "internal/cflex_parse_enum.c"
 #include "internal/cflex_parse.c"
+#include "internal/cflex_phash.c"
 #include "internal/cflex_output.c"
+#include "internal/cflex_output_packed.c"
+#include "internal/cflex_output_cpp.c"
+#include "internal/cflex_output_codegen.c"
 
 // --- Global State ---
 static file_list_t   header_files = { 0 };
@@ -32,19 +39,22 @@ static parsed_data_t parsed_data  = { 0 };
 int
 main( int argc, char** argv )
 {
-    const char* input_path         = NULL;
-    const char* output_path         = NULL;
-    const char* module_name         = "cflex";
-    bool        include_default_types = false;
+    const char* input_path      = NULL;
+    const char* output_path     = NULL;
+    const char* module_name     = "cflex";
+    bool        linker_sections = false;
+    bool        packed          = false;
+    bool        strip_names     = false;
+    bool        emit_cpp        = false;
+    bool        codegen         = false;
 
     // If no command-line arguments are provided, assume debug mode for IDEs.
     if ( argc == 1 )
     {
         print_fmt( "--- No arguments provided, running in debug mode with hardcoded paths. ---\n" );
-        input_path          = "F:/C/cflex/cflex/src/program";
-        output_path         = "F:/C/cflex/cflex/build/cflex_generated";
-        module_name         = "program";
-        include_default_types = true;    // Typically you'd want this for an executable.
+        input_path  = "F:/C/cflex/cflex/src/program";
+        output_path = "F:/C/cflex/cflex/build/cflex_generated";
+        module_name = "program";
     }
     else
     {
@@ -68,7 +78,32 @@ main( int argc, char** argv )
             }
             else if ( strcmp( arg, "--include-default-types" ) == 0 )
             {
-                include_default_types = true;
+                // Accepted for older build scripts. The runtime now owns the primitive types.
+                arg_idx++;
+            }
+            else if ( strcmp( arg, "--linker-sections" ) == 0 )
+            {
+                linker_sections = true;
+                arg_idx++;
+            }
+            else if ( strcmp( arg, "--packed" ) == 0 )
+            {
+                packed = true;
+                arg_idx++;
+            }
+            else if ( strcmp( arg, "--strip-names" ) == 0 )
+            {
+                strip_names = true;
+                arg_idx++;
+            }
+            else if ( strcmp( arg, "--emit-cpp" ) == 0 )
+            {
+                emit_cpp = true;
+                arg_idx++;
+            }
+            else if ( strcmp( arg, "--codegen" ) == 0 )
+            {
+                codegen = true;
                 arg_idx++;
             }
             else
@@ -90,7 +125,7 @@ main( int argc, char** argv )
     {
         file_print_fmt( stderr,
                         "Usage: %s <input_path> <output_path> [--name <module_name>] "
-                        "[--include-default-types]\n"
+                        "[--linker-sections] [--packed] [--strip-names] [--emit-cpp] [--codegen]\n"
                         "Or run with no arguments for a debug session with hardcoded paths.\n",
                         argv[ 0 ] );
         return 1;
@@ -100,9 +135,25 @@ main( int argc, char** argv )
     print_fmt( "Input Path: %s\n", input_path );
     print_fmt( "Output Path: %s\n", output_path );
     print_fmt( "Module Name: %s\n", module_name );
-    if ( include_default_types )
+    if ( linker_sections )
+    {
+        print_fmt( "Mode: Linker Section Registration\n" );
+    }
+    if ( packed )
+    {
+        print_fmt( "Mode: Packed Tables\n" );
+    }
+    if ( strip_names )
+    {
+        print_fmt( "Mode: Names Stripped\n" );
+    }
+    if ( emit_cpp )
+    {
+        print_fmt( "Mode: C++ Header\n" );
+    }
+    if ( codegen )
     {
-        print_fmt( "Mode: Default Types Included\n" );
+        print_fmt( "Mode: Generated Functions\n" );
     }
 
     // --- Main Logic ---
@@ -122,7 +173,14 @@ main( int argc, char** argv )
     }
 
     // 3. Generate output
-    if ( !generate_output_files( output_path, module_name, include_default_types, &parsed_data, &header_files ) )
+    output_options_t options = { 0 };
+    options.module_name      = module_name;
+    options.linker_sections  = linker_sections;
+    options.packed           = packed;
+    options.strip_names      = strip_names;
+    options.emit_cpp         = emit_cpp;
+    options.codegen          = codegen;
+    if ( !generate_output_files( output_path, &options, &parsed_data, &header_files ) )
     {
         file_print_fmt( stderr, "Error generating output files, aborting.\n" );
         return 1;
@@ -69,6 +69,7 @@ typedef struct parsed_field_t
 {
     char type_name[ MAX_NAME_LENGTH ];
     char name[ MAX_NAME_LENGTH ];
+    bool is_base;    // CF_FIELD( base ): the field embeds the parent struct
 } parsed_field_t;
 
 // Represents a single value within a parsed enum.
@@ -98,6 +99,7 @@ typedef struct parsed_type_t
         {
             parsed_field_t fields[ MAX_FIELDS ];
             int            num_fields;
+            bool           codegen;    // CF_STRUCT( codegen ): emit <type>_write() and friends
         } struct_info;
 
         // Information specific to enums.
@@ -122,19 +124,71 @@ typedef struct parsed_data_t
 // Returns false on failure.
 static bool parse_header_file( const char* filepath, parsed_data_t* data );
 
+/*==============================================================================================
+
+    Perfect Hash
+
+==============================================================================================*/
+
+#define PHASH_MAX_KEYS ( MAX_ENUM_VALUES > MAX_FIELDS ? MAX_ENUM_VALUES : MAX_FIELDS )
+
+// A minimal perfect hash table over a set of names (see cflex_phash.c).
+typedef struct phash_t
+{
+    uint16_t seeds[ PHASH_MAX_KEYS ];    // One seed per bucket
+    uint16_t slots[ PHASH_MAX_KEYS ];    // Key index stored in each slot
+    int32_t  num_buckets;
+    int32_t  num_keys;
+} phash_t;
+
+// Builds a minimal perfect hash over `count` name hashes.
+// Returns false if no table could be built.
+static bool phash_build( const uint64_t* hashes, int32_t count, phash_t* out );
+
 /*==============================================================================================
 
     Output
 
 ==============================================================================================*/
 
+// Options that control what the generated files contain.
+typedef struct output_options_t
+{
+    const char* module_name;
+    bool        linker_sections;    // Place the type table in the cflex linker section
+    bool        packed;             // Emit relocation-free packed tables
+    bool        strip_names;        // Emit name hashes only, plus a .names sidecar file
+    bool        emit_cpp;           // Also emit a C++ header with compile-time descriptors
+    bool        codegen;            // Generate <type>_write() and friends for every struct
+} output_options_t;
+
+// Generates the cflex_generated.c file in packed form (cflex_output_packed.c).
+static bool generate_packed_c_file( FILE*                   fp,
+                                    const output_options_t* options,
+                                    const parsed_data_t*    data,
+                                    const file_list_t*      headers );
+
+// Returns true if <type>_write() and friends are generated for a type (cflex_output_codegen.c).
+static bool wants_codegen( const output_options_t* options, const parsed_type_t* type );
+
+// Checks that every struct that gets generated functions can have them (cflex_output_codegen.c).
+static bool check_codegen_types( const output_options_t* options, const parsed_data_t* data );
+
+// Declares the generated functions of the module's structs (cflex_output_codegen.c).
+static void print_codegen_decls( FILE* fp, const output_options_t* options, const parsed_data_t* data );
+
+// Emits the generated functions and their cf_struct_funcs_t tables (cflex_output_codegen.c).
+static void print_codegen_functions( FILE* fp, const output_options_t* options, const parsed_data_t* data );
+
+// Generates the cflex_generated.hpp file (cflex_output_cpp.c).
+static void generate_hpp_file( FILE* fp, const output_options_t* options, const parsed_data_t* data );
+
 // Generates the cflex_generated.h and cflex_generated.c files.
 // Returns false on failure.
-bool generate_output_files( const char*      output_path,
-                            const char*      module_name,
-                            bool             default_types_only,
-                            const parsed_data_t* data,
-                            const file_list_t*   headers );
+bool generate_output_files( const char*             output_path,
+                            const output_options_t* options,
+                            const parsed_data_t*    data,
+                            const file_list_t*      headers );
 
 /*==============================================================================================
 
@@ -16,37 +16,537 @@ print_uppercase( FILE* fp, const char* str )
 
 /*============================================================================================*/
 
+// The primitive types. The runtime defines them (cflex.h), so generated tables only
+// reference them. `cf_name` is the suffix of the cf_type_<name> variable and of the
+// CF_TYPE_ID_<name> constant.
+typedef struct default_type_t
+{
+    const char* cf_name;
+    const char* c_name;
+    const char* prim;
+} default_type_t;
+
+// clang-format off
+static const default_type_t default_types[] = {
+    { "void", "void",        "CF_PRIM_VOID" },
+    { "bool", "bool",        "CF_PRIM_BOOL" },
+    { "char", "char",        "CF_PRIM_CHAR" },
+    { "i8",   "int8_t",      "CF_PRIM_I8"   },
+    { "i16",  "int16_t",     "CF_PRIM_I16"  },
+    { "i32",  "int32_t",     "CF_PRIM_I32"  },
+    { "i64",  "int64_t",     "CF_PRIM_I64"  },
+    { "u8",   "uint8_t",     "CF_PRIM_U8"   },
+    { "u16",  "uint16_t",    "CF_PRIM_U16"  },
+    { "u32",  "uint32_t",    "CF_PRIM_U32"  },
+    { "u64",  "uint64_t",    "CF_PRIM_U64"  },
+    { "f32",  "float",       "CF_PRIM_F32"  },
+    { "f64",  "double",      "CF_PRIM_F64"  },
+    { "cstr", "const char*", "CF_PRIM_CSTR" },
+};
+// clang-format on
+
+#define NUM_DEFAULT_TYPES ( (int32_t)( sizeof( default_types ) / sizeof( default_types[ 0 ] ) ) )
+
+/*============================================================================================*/
+
 // Maps a C type name to the name used for the cf_type_t variable.
 static const char*
 get_cf_type_name( const char* c_name )
 {
-    // clang-format off
-    if ( str_cmp( c_name, "void" ) == 0 ) return "void";
-    if ( str_cmp( c_name, "bool" ) == 0 ) return "bool";
-    if ( str_cmp( c_name, "char" ) == 0 ) return "char";
-    if ( str_cmp( c_name, "int8_t" ) == 0 ) return "i8";
-    if ( str_cmp( c_name, "int16_t" ) == 0 ) return "i16";
-    if ( str_cmp( c_name, "int32_t" ) == 0 ) return "i32";
-    if ( str_cmp( c_name, "int64_t" ) == 0 ) return "i64";
-    if ( str_cmp( c_name, "uint8_t" ) == 0 ) return "u8";
-    if ( str_cmp( c_name, "uint16_t" ) == 0 ) return "u16";
-    if ( str_cmp( c_name, "uint32_t" ) == 0 ) return "u32";
-    if ( str_cmp( c_name, "uint64_t" ) == 0 ) return "u64";
-    if ( str_cmp( c_name, "float" ) == 0 ) return "f32";
-    if ( str_cmp( c_name, "double" ) == 0 ) return "f64";
-    if ( str_cmp( c_name, "const char*" ) == 0 ) return "cstr";
-    // clang-format on
+    for ( int32_t i = 0; i < NUM_DEFAULT_TYPES; ++i )
+    {
+        if ( str_cmp( c_name, default_types[ i ].c_name ) == 0 )
+        {
+            return default_types[ i ].cf_name;
+        }
+    }
 
     return c_name; // If not a primitive, it's a user-defined type. The name is the same.
 }
 
+// Returns true if `name` is a type reflected by this module.
+static bool
+is_module_type( const parsed_data_t* data, const char* name )
+{
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        if ( str_cmp( data->types[ i ].name, name ) == 0 )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*============================================================================================*/
+
+// Returns the field of a struct annotated with CF_FIELD( base ), or NULL.
+static const parsed_field_t*
+get_base_field( const parsed_type_t* type )
+{
+    const parsed_field_t* fields = type->struct_info.fields;
+    if ( type->kind == PARSED_KIND_STRUCT && type->struct_info.num_fields > 0 && fields[ 0 ].is_base )
+    {
+        return &fields[ 0 ];
+    }
+    return NULL;
+}
+
+// Emits a compile-time check that the base field of a struct is its first member.
+static void
+print_base_assert( FILE* fp, const parsed_type_t* type )
+{
+    const parsed_field_t* base = get_base_field( type );
+    if ( base )
+    {
+        file_print_fmt(
+            fp, "_Static_assert(offsetof(%s, %s) == 0, \"%s.%s: a base field must be the first member\");\n",
+            type->name, base->name, type->name, base->name );
+    }
+}
+
+// Checks that every base field is of a struct type. Base types of other modules are checked
+// by the compiler only.
+static bool
+check_base_fields( const parsed_data_t* data )
+{
+    bool ok = true;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_field_t* base = get_base_field( &data->types[ i ] );
+        if ( !base )
+        {
+            continue;
+        }
+
+        bool is_struct = get_cf_type_name( base->type_name ) == base->type_name;
+        for ( int j = 0; j < data->num_types && is_struct; ++j )
+        {
+            const parsed_type_t* other = &data->types[ j ];
+            is_struct = other->kind == PARSED_KIND_STRUCT || str_cmp( other->name, base->type_name ) != 0;
+        }
+        if ( !is_struct )
+        {
+            file_print_fmt( stderr, "Error: Base field '%s.%s' is not a struct.\n", data->types[ i ].name,
+                            base->name );
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+/*============================================================================================*/
+
+// Declares the field types that are neither primitives nor reflected by this module. The
+// module that reflects them exports them, and the linker resolves the references.
+static void
+print_external_type_decls( FILE* fp, const parsed_data_t* data )
+{
+    static const char* declared[ MAX_USER_TYPES * MAX_FIELDS ];
+    int32_t            num_declared = 0;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != PARSED_KIND_STRUCT )
+        {
+            continue;
+        }
+        for ( int j = 0; j < type->struct_info.num_fields; ++j )
+        {
+            const char* name = type->struct_info.fields[ j ].type_name;
+            if ( get_cf_type_name( name ) != name || is_module_type( data, name ) )
+            {
+                continue;
+            }
+
+            bool seen = false;
+            for ( int32_t k = 0; k < num_declared && !seen; ++k )
+            {
+                seen = str_cmp( declared[ k ], name ) == 0;
+            }
+            if ( !seen )
+            {
+                file_print_fmt( fp, "extern const cf_type_t cf_type_%s;\n", name );
+                declared[ num_declared++ ] = name;
+            }
+        }
+    }
+    if ( num_declared > 0 )
+    {
+        file_print_fmt( fp, "\n" );
+    }
+}
+
+/*============================================================================================*/
+
+// Emits the stable ID constant of a type: CF_TYPE_ID_<cf_name> = cf_hash_name( name ).
+static void
+print_type_id_define( FILE* fp, const char* cf_name, const char* name )
+{
+    file_print_fmt( fp, "#define CF_TYPE_ID_%s 0x%016llxull\n", cf_name,
+                    (unsigned long long)cf_hash_name( name ) );
+}
+
+// Prints the `<module>_type_of( expr )` macro: a _Generic selection over the module's
+// structs and the primitive types, and `cf_type_of` as an alias for the first module
+// header included. Enums are left out: C treats an enum as its underlying integer type,
+// so _Generic cannot tell them apart from each other or from uint32_t.
+static void
+print_type_of_macro( FILE* fp, const output_options_t* options, const parsed_data_t* data )
+{
+    const char* module_name = options->module_name;
+
+    file_print_fmt(
+        fp, "// The reflected type of an expression, selected at compile time. Types that are not\n" );
+    file_print_fmt( fp,
+                    "// reflected fail to compile. Enums are not covered; use cf_type_<enum> instead.\n" );
+    file_print_fmt( fp, "#define %s_type_of( expr ) \\\n", module_name );
+    file_print_fmt( fp, "    _Generic( ( expr ), \\\n" );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != PARSED_KIND_STRUCT )
+        {
+            continue;
+        }
+        // Packed modules have no descriptor variables; their types are found by ID.
+        if ( options->packed )
+        {
+            file_print_fmt( fp, "        %s: cf_find_type_by_id( CF_TYPE_ID_%s ), \\\n", type->name,
+                            type->name );
+        }
+        else
+        {
+            file_print_fmt( fp, "        %s: &cf_type_%s, \\\n", type->name, type->name );
+        }
+    }
+    file_print_fmt( fp, "        CF_PRIMITIVE_TYPE_ASSOCIATIONS )\n\n" );
+
+    file_print_fmt( fp, "#ifndef cf_type_of\n" );
+    file_print_fmt( fp, "#define cf_type_of( expr ) %s_type_of( expr )\n", module_name );
+    file_print_fmt( fp, "#endif\n\n" );
+}
+
+// Prints, for each struct, a CF_FIELDS_<type>( X ) X-macro that expands
+// X( name, c_type, offset, index ) once per field, and enum constants for the field indices
+// and count. Code built on them is specialized per struct at compile time, with no access
+// to the runtime descriptors.
+static void
+print_field_list_macros( FILE* fp, const parsed_data_t* data )
+{
+    file_print_fmt( fp,
+                    "// CF_FIELDS_<type>( X ) expands X( name, c_type, offset, index ) for each field.\n" );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != PARSED_KIND_STRUCT )
+        {
+            continue;
+        }
+
+        file_print_fmt( fp, "#define CF_FIELDS_%s( X )", type->name );
+        for ( int j = 0; j < type->struct_info.num_fields; ++j )
+        {
+            const parsed_field_t* field = &type->struct_info.fields[ j ];
+            file_print_fmt( fp, " \\\n    X( %s, %s, offsetof( %s, %s ), %d )", field->name, field->type_name,
+                            type->name, field->name, j );
+        }
+        file_print_fmt( fp, "\n\n" );
+
+        file_print_fmt( fp, "enum\n{\n" );
+        for ( int j = 0; j < type->struct_info.num_fields; ++j )
+        {
+            file_print_fmt( fp, "    CF_FIELD_INDEX_%s_%s = %d,\n", type->name,
+                            type->struct_info.fields[ j ].name, j );
+        }
+        file_print_fmt( fp, "    CF_FIELD_COUNT_%s = %d\n};\n\n", type->name, type->struct_info.num_fields );
+    }
+}
+
+/*============================================================================================*/
+
+// Formats the initializer of a name member: the quoted name, or NULL when names are stripped.
+static const char*
+quote_name( const char* name, bool strip_names, char* buf, int32_t buf_size )
+{
+    if ( strip_names )
+    {
+        str_copy( buf, "NULL", buf_size );
+    }
+    else
+    {
+        str_print_fmt( buf, buf_size, "\"%s\"", name );
+    }
+    return buf;
+}
+
+/*============================================================================================*/
+
+// Emits an #include for each scanned header, by file name only.
+static void
+print_header_includes( FILE* fp, const file_list_t* headers )
+{
+    for ( int i = 0; i < headers->count; ++i )
+    {
+        const char* filename = str_rchr( headers->files[ i ], '/' );
+        if ( !filename )
+            filename = str_rchr( headers->files[ i ], '\\' );
+        filename = filename ? filename + 1 : headers->files[ i ];
+        file_print_fmt( fp, "#include \"%s\"\n", filename );
+    }
+}
+
+/*============================================================================================*/
+
+// Emits the seed and slot arrays of a perfect hash over a set of name hashes and
+// writes the matching cf_phash_t initializer into `init`. When no table can be
+// built the initializer is empty, NULL is returned and the runtime falls back to
+// a linear scan. The returned table is only valid until the next call.
+static const phash_t*
+generate_phash(
+    FILE* fp, const char* symbol, const uint64_t* hashes, int32_t count, char* init, int32_t init_size )
+{
+    static phash_t phash;
+    if ( !phash_build( hashes, count, &phash ) )
+    {
+        str_copy( init, "{ NULL, NULL, 0 }", init_size );
+        return NULL;
+    }
+
+    file_print_fmt( fp, "static const uint16_t %s_seeds[] = {", symbol );
+    for ( int32_t i = 0; i < phash.num_buckets; ++i )
+    {
+        file_print_fmt( fp, "%s%u", i ? ", " : " ", phash.seeds[ i ] );
+    }
+    file_print_fmt( fp, " };\n" );
+
+    file_print_fmt( fp, "static const uint16_t %s_slots[] = {", symbol );
+    for ( int32_t i = 0; i < phash.num_keys; ++i )
+    {
+        file_print_fmt( fp, "%s%u", i ? ", " : " ", phash.slots[ i ] );
+    }
+    file_print_fmt( fp, " };\n" );
+
+    str_print_fmt( init, init_size, "{ %s_seeds, %s_slots, %d }", symbol, symbol, phash.num_buckets - 1 );
+    return &phash;
+}
+
+/*============================================================================================*/
+
+// Enums whose values span at most this many integers, and no more than
+// ENUM_DENSE_MAX_SPREAD times their value count, get a direct-index table.
+#define ENUM_DENSE_MAX_RANGE  1024
+#define ENUM_DENSE_MAX_SPREAD 4
+
+// Emits the value lookup tables of an enum and writes the matching cf_type_t
+// initializer fields into `init`.
+//   Dense enums:  an index table over [min, max] plus a validity bitmap.
+//   Sparse enums: entry indices sorted by value, for binary search.
+static void
+generate_enum_tables(
+    FILE* fp, const char* module_name, const parsed_type_t* type, char* init, int32_t init_size )
+{
+    const parsed_enum_value_t* values = type->enum_info.values;
+    int32_t                    count  = type->enum_info.num_values;
+    if ( count == 0 )
+    {
+        str_copy( init, ".enum_min = 0, .enum_range = 0", init_size );
+        return;
+    }
+
+    int32_t min = values[ 0 ].value;
+    int32_t max = values[ 0 ].value;
+    for ( int32_t i = 1; i < count; ++i )
+    {
+        min = values[ i ].value < min ? values[ i ].value : min;
+        max = values[ i ].value > max ? values[ i ].value : max;
+    }
+
+    int64_t range = (int64_t)max - (int64_t)min + 1;
+    if ( range <= ENUM_DENSE_MAX_RANGE && range <= (int64_t)count * ENUM_DENSE_MAX_SPREAD )
+    {
+        static int16_t  by_value[ ENUM_DENSE_MAX_RANGE ];
+        static uint32_t valid[ ENUM_DENSE_MAX_RANGE / 32 ];
+        mem_set( by_value, 0xff, sizeof( by_value ) );
+        mem_set( valid, 0, sizeof( valid ) );
+
+        // Aliased values resolve to the first entry declared with that value.
+        for ( int32_t i = count - 1; i >= 0; --i )
+        {
+            int32_t offset     = values[ i ].value - min;
+            by_value[ offset ] = (int16_t)i;
+            valid[ offset / 32 ] |= 1u << ( offset % 32 );
+        }
+
+        file_print_fmt( fp, "static const int16_t cf_%s_%s_by_value[] = {", module_name, type->name );
+        for ( int32_t i = 0; i < range; ++i ) { file_print_fmt( fp, "%s%d", i ? ", " : " ", by_value[ i ] ); }
+        file_print_fmt( fp, " };\n" );
+
+        file_print_fmt( fp, "static const uint32_t cf_%s_%s_valid[] = {", module_name, type->name );
+        for ( int32_t i = 0; i < ( range + 31 ) / 32; ++i )
+        {
+            file_print_fmt( fp, "%s0x%08xu", i ? ", " : " ", valid[ i ] );
+        }
+        file_print_fmt( fp, " };\n" );
+
+        str_print_fmt(
+            init, init_size,
+            ".enum_min = %d, .enum_range = %d, .enum_by_value = cf_%s_%s_by_value, .enum_valid_bits = cf_%s_%s_valid",
+            min, (int32_t)range, module_name, type->name, module_name, type->name );
+    }
+    else
+    {
+        // Stable insertion sort by value, so aliases keep their declaration order.
+        uint16_t sorted[ MAX_ENUM_VALUES ];
+        for ( int32_t i = 0; i < count; ++i )
+        {
+            int32_t j = i;
+            while ( j > 0 && values[ sorted[ j - 1 ] ].value > values[ i ].value )
+            {
+                sorted[ j ] = sorted[ j - 1 ];
+                j--;
+            }
+            sorted[ j ] = (uint16_t)i;
+        }
+
+        file_print_fmt( fp, "static const uint16_t cf_%s_%s_sorted[] = {", module_name, type->name );
+        for ( int32_t i = 0; i < count; ++i ) { file_print_fmt( fp, "%s%u", i ? ", " : " ", sorted[ i ] ); }
+        file_print_fmt( fp, " };\n" );
+
+        str_print_fmt( init, init_size, ".enum_min = %d, .enum_range = 0, .enum_sorted = cf_%s_%s_sorted",
+                       min, module_name, type->name );
+    }
+}
+
+/*============================================================================================*/
+
+// Emits cf_<module>_<enum>_index_of_value, a switch from value to entry index.
+// Aliases resolve to the first entry declared with the value.
+static void
+print_enum_index_of_value( FILE* fp, const char* module_name, const parsed_type_t* type )
+{
+    const parsed_enum_value_t* values = type->enum_info.values;
+    int32_t                    count  = type->enum_info.num_values;
+
+    file_print_fmt( fp, "static int32_t cf_%s_%s_index_of_value(int32_t value) {\n", module_name,
+                    type->name );
+    file_print_fmt( fp, "    switch (value) {\n" );
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        bool is_alias = false;
+        for ( int32_t j = 0; j < i && !is_alias; ++j ) { is_alias = values[ j ].value == values[ i ].value; }
+        if ( !is_alias )
+        {
+            file_print_fmt( fp, "        case %d: return %d;\n", values[ i ].value, i );
+        }
+    }
+    file_print_fmt( fp, "        default: return -1;\n" );
+    file_print_fmt( fp, "    }\n" );
+    file_print_fmt( fp, "}\n" );
+}
+
+/*============================================================================================*/
+
+// Emits the name <-> value codecs of an enum:
+//   cf_<module>_<enum>_index_of_name   perfect hash lookup, reached through cf_type_t
+//   cf_<module>_<enum>_index_of_value  switch over the values, reached through cf_type_t
+//   <enum>_from_string / <enum>_to_string  typed wrappers for hand-written callers
+// Writes the matching cf_type_t initializer fields into `init`.
+static void
+generate_enum_codecs( FILE*                fp,
+                      const char*          module_name,
+                      const parsed_type_t* type,
+                      bool                 strip_names,
+                      char*                init,
+                      int32_t              init_size )
+{
+    const parsed_enum_value_t* values = type->enum_info.values;
+    int32_t                    count  = type->enum_info.num_values;
+    const char*                name   = type->name;
+
+    uint64_t hashes[ MAX_ENUM_VALUES ];
+    char     phash_symbol[ MAX_NAME_LENGTH * 2 ];
+    char     phash_init[ MAX_NAME_LENGTH * 4 ];
+    for ( int32_t i = 0; i < count; ++i ) { hashes[ i ] = cf_hash_name( values[ i ].name ); }
+    str_print_fmt( phash_symbol, sizeof( phash_symbol ), "cf_%s_%s_name_hash", module_name, name );
+    const phash_t* phash =
+        generate_phash( fp, phash_symbol, hashes, count, phash_init, sizeof( phash_init ) );
+
+    // Name -> entry index.
+    file_print_fmt( fp, "static int32_t cf_%s_%s_index_of_name(const char* name, int32_t len) {\n",
+                    module_name, name );
+    if ( phash )
+    {
+        file_print_fmt( fp, "    uint64_t hash = cf_hash_name_n(name, len);\n" );
+        file_print_fmt( fp, "    uint32_t seed = %s_seeds[cf_phash_bucket(hash, %du)];\n", phash_symbol,
+                        phash->num_buckets - 1 );
+        file_print_fmt( fp, "    int32_t index = %s_slots[cf_phash_slot(hash, seed, %du)];\n", phash_symbol,
+                        count );
+        if ( strip_names )
+        {
+            file_print_fmt( fp, "    return cf_%s_%s_values[index].name_hash == hash ? index : -1;\n",
+                            module_name, name );
+        }
+        else
+        {
+            file_print_fmt( fp, "    const char* entry = cf_%s_%s_values[index].name;\n", module_name, name );
+            file_print_fmt(
+                fp,
+                "    return (strncmp(entry, name, (size_t)len) == 0 && entry[len] == '\\0') ? index : -1;\n" );
+        }
+    }
+    else if ( strip_names )
+    {
+        file_print_fmt( fp, "    uint64_t hash = cf_hash_name_n(name, len);\n" );
+        file_print_fmt( fp, "    for (int32_t i = 0; i < %d; ++i) {\n", count );
+        file_print_fmt( fp, "        if (cf_%s_%s_values[i].name_hash == hash) return i;\n", module_name,
+                        name );
+        file_print_fmt( fp, "    }\n" );
+        file_print_fmt( fp, "    return -1;\n" );
+    }
+    else
+    {
+        file_print_fmt( fp, "    for (int32_t i = 0; i < %d; ++i) {\n", count );
+        file_print_fmt( fp, "        const char* entry = cf_%s_%s_values[i].name;\n", module_name, name );
+        file_print_fmt(
+            fp, "        if (strncmp(entry, name, (size_t)len) == 0 && entry[len] == '\\0') return i;\n" );
+        file_print_fmt( fp, "    }\n" );
+        file_print_fmt( fp, "    return -1;\n" );
+    }
+    file_print_fmt( fp, "}\n" );
+
+    print_enum_index_of_value( fp, module_name, type );
+
+    // Typed wrappers.
+    file_print_fmt( fp, "bool %s_from_string(const char* str, %s* out_value) {\n", name, name );
+    file_print_fmt( fp, "    int32_t index = str ? cf_%s_%s_index_of_name(str, (int32_t)strlen(str)) : -1;\n",
+                    module_name, name );
+    file_print_fmt( fp, "    if (index < 0) return false;\n" );
+    file_print_fmt( fp, "    *out_value = (%s)cf_%s_%s_values[index].value;\n", name, module_name, name );
+    file_print_fmt( fp, "    return true;\n" );
+    file_print_fmt( fp, "}\n" );
+    file_print_fmt( fp, "const char* %s_to_string(%s value) {\n", name, name );
+    file_print_fmt( fp, "    int32_t index = cf_%s_%s_index_of_value((int32_t)value);\n", module_name, name );
+    file_print_fmt( fp, "    return index >= 0 ? cf_%s_%s_values[index].name : NULL;\n", module_name, name );
+    file_print_fmt( fp, "}\n" );
+
+    str_print_fmt(
+        init, init_size,
+        ".enum_phash = %s, .enum_index_of_name = cf_%s_%s_index_of_name, .enum_index_of_value = cf_%s_%s_index_of_value",
+        phash_init, module_name, name, module_name, name );
+}
+
 /*============================================================================================*/
 
 // Generates the content of the `<module_name>_generated.h` file.
 static void
-generate_h_file( FILE* fp, const char* module_name, bool include_default_types, const parsed_data_t* data )
+generate_h_file( FILE*                   fp,
+                 const output_options_t* options,
+                 const parsed_data_t*    data,
+                 const file_list_t*      headers )
 {
-    UNUSED(data);
+    const char* module_name = options->module_name;
+
     file_print_fmt( fp, "// THIS FILE IS-GENERATED BY CFLEX_BUILD. DO NOT EDIT.\n" );
     file_print_fmt( fp, "#ifndef " );
     print_uppercase( fp, module_name );
@@ -55,29 +555,58 @@ generate_h_file( FILE* fp, const char* module_name, bool include_default_types,
     print_uppercase( fp, module_name );
     file_print_fmt( fp, "_GENERATED_H\n\n" );
 
-    file_print_fmt( fp, "#include \"cflex.h\"\n\n" );
-
-    if ( include_default_types )
-    {
-        // clang-format off
-        file_print_fmt( fp, "extern const cf_type_t cf_type_void;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_bool;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_char;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_i8;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_i16;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_i32;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_i64;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_u8;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_u16;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_u32;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_u64;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_f32;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_f64;\n" );
-        file_print_fmt( fp, "extern const cf_type_t cf_type_cstr;\n\n" );
-        // clang-format on
-    }
-
-    file_print_fmt( fp, "void %s_register_types(void);\n\n", module_name );
+    file_print_fmt( fp, "#include \"cflex.h\"\n" );
+    print_header_includes( fp, headers );
+    file_print_fmt( fp, "\n" );
+
+    file_print_fmt( fp, "#ifdef __cplusplus\nextern \"C\" {\n#endif\n\n" );
+
+    // Exported types, so other modules can reference them. Packed modules have no cf_type_t
+    // variables to export; they reference other modules' types by ID.
+    if ( !options->packed && data->num_types > 0 )
+    {
+        for ( int i = 0; i < data->num_types; ++i )
+        {
+            file_print_fmt( fp, "extern const cf_type_t cf_type_%s;\n", data->types[ i ].name );
+        }
+        file_print_fmt( fp, "\n" );
+    }
+
+    // Stable type IDs. The primitive IDs are defined by cflex.h.
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        print_type_id_define( fp, data->types[ i ].name, data->types[ i ].name );
+    }
+    if ( data->num_types > 0 )
+    {
+        file_print_fmt( fp, "\n" );
+    }
+
+    print_type_of_macro( fp, options, data );
+    print_field_list_macros( fp, data );
+    print_codegen_decls( fp, options, data );
+
+    // Typed enum codecs.
+    bool has_enums = false;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind == PARSED_KIND_ENUM )
+        {
+            file_print_fmt( fp, "bool %s_from_string(const char* str, %s* out_value);\n", type->name,
+                            type->name );
+            file_print_fmt( fp, "const char* %s_to_string(%s value);\n", type->name, type->name );
+            has_enums = true;
+        }
+    }
+    if ( has_enums )
+    {
+        file_print_fmt( fp, "\n" );
+    }
+
+    file_print_fmt( fp, "void %s_register_types(void);\n", module_name );
+    file_print_fmt( fp, "void %s_unregister_types(void);\n\n", module_name );
+    file_print_fmt( fp, "#ifdef __cplusplus\n}\n#endif\n\n" );
     file_print_fmt( fp, "#endif // " );
     print_uppercase( fp, module_name );
     file_print_fmt( fp, "_GENERATED_H\n" );
@@ -87,46 +616,26 @@ generate_h_file( FILE* fp, const char* module_name, bool include_default_types,
 
 // Generates the content of the `<module_name>_generated.c` file.
 static void
-generate_c_file( FILE*           fp,
-                 const char*     module_name,
-                 bool            include_default_types,
-                 const parsed_data_t* data,
-                 const file_list_t*   headers )
+generate_c_file( FILE*                   fp,
+                 const output_options_t* options,
+                 const parsed_data_t*    data,
+                 const file_list_t*      headers )
 {
+    const char* module_name = options->module_name;
+    bool        strip_names = options->strip_names;
+    char        name_init[ MAX_NAME_LENGTH + 2 ];
+
     file_print_fmt( fp, "// THIS FILE IS-GENERATED BY CFLEX_BUILD. DO NOT EDIT.\n" );
     file_print_fmt( fp, "#include \"internal/cflex_internal.h\"\n" );
     file_print_fmt( fp, "#include \"%s_generated.h\"\n", module_name );
-    file_print_fmt( fp, "#include <stddef.h>\n\n" );
+    file_print_fmt( fp, "#include <stddef.h>\n" );
+    file_print_fmt( fp, "#include <string.h>\n\n" );
 
-    for ( int i = 0; i < headers->count; ++i )
-    {
-        const char* filename = str_rchr( headers->files[ i ], '/' );
-        if ( !filename )
-            filename = str_rchr( headers->files[ i ], '\\' );
-        filename = filename ? filename + 1 : headers->files[ i ];
-        file_print_fmt( fp, "#include \"%s\"\n", filename );
-    }
+    print_header_includes( fp, headers );
     file_print_fmt( fp, "\n" );
 
-    if ( include_default_types )
-    {
-        // clang-format off
-        file_print_fmt( fp, "const cf_type_t cf_type_void = { .name = \"void\",        .kind = CF_KIND_PRIMITIVE, .size = 0,                   .align = 0,                     .prim = CF_PRIM_VOID };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_bool = { .name = \"bool\",        .kind = CF_KIND_PRIMITIVE, .size = sizeof(bool),        .align = _Alignof(bool),        .prim = CF_PRIM_BOOL };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_char = { .name = \"char\",        .kind = CF_KIND_PRIMITIVE, .size = sizeof(char),        .align = _Alignof(char),        .prim = CF_PRIM_CHAR };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_i8   = { .name = \"int8_t\",      .kind = CF_KIND_PRIMITIVE, .size = sizeof(int8_t),      .align = _Alignof(int8_t),      .prim = CF_PRIM_I8 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_i16  = { .name = \"int16_t\",     .kind = CF_KIND_PRIMITIVE, .size = sizeof(int16_t),     .align = _Alignof(int16_t),     .prim = CF_PRIM_I16 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_i32  = { .name = \"int32_t\",     .kind = CF_KIND_PRIMITIVE, .size = sizeof(int32_t),     .align = _Alignof(int32_t),     .prim = CF_PRIM_I32 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_i64  = { .name = \"int64_t\",     .kind = CF_KIND_PRIMITIVE, .size = sizeof(int64_t),     .align = _Alignof(int64_t),     .prim = CF_PRIM_I64 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_u8   = { .name = \"uint8_t\",     .kind = CF_KIND_PRIMITIVE, .size = sizeof(uint8_t),     .align = _Alignof(uint8_t),     .prim = CF_PRIM_U8 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_u16  = { .name = \"uint16_t\",    .kind = CF_KIND_PRIMITIVE, .size = sizeof(uint16_t),    .align = _Alignof(uint16_t),    .prim = CF_PRIM_U16 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_u32  = { .name = \"uint32_t\",    .kind = CF_KIND_PRIMITIVE, .size = sizeof(uint32_t),    .align = _Alignof(uint32_t),    .prim = CF_PRIM_U32 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_u64  = { .name = \"uint64_t\",    .kind = CF_KIND_PRIMITIVE, .size = sizeof(uint64_t),    .align = _Alignof(uint64_t),    .prim = CF_PRIM_U64 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_f32  = { .name = \"float\",       .kind = CF_KIND_PRIMITIVE, .size = sizeof(float),       .align = _Alignof(float),       .prim = CF_PRIM_F32 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_f64  = { .name = \"double\",      .kind = CF_KIND_PRIMITIVE, .size = sizeof(double),      .align = _Alignof(double),      .prim = CF_PRIM_F64 };\n" );
-        file_print_fmt( fp, "const cf_type_t cf_type_cstr = { .name = \"const char*\", .kind = CF_KIND_PRIMITIVE, .size = sizeof(const char*), .align = _Alignof(const char*), .prim = CF_PRIM_CSTR };\n\n" );
-        // clang-format on
-    }
+    print_external_type_decls( fp, data );
+    print_codegen_functions( fp, options, data );
 
     for ( int i = 0; i < data->num_types; ++i )
     {
@@ -138,15 +647,56 @@ generate_c_file( FILE*           fp,
             {
                 const parsed_field_t* field        = &type->struct_info.fields[ j ];
                 const char*           cf_type_name = get_cf_type_name( field->type_name );
-                file_print_fmt( fp, "    { \"%s\", &cf_type_%s, offsetof(%s, %s), 0 },\n", field->name,
-                                cf_type_name, type->name, field->name );
+                file_print_fmt( fp, "    { %s, &cf_type_%s, offsetof(%s, %s), %s, 0x%016llxull },\n",
+                                quote_name( field->name, strip_names, name_init, sizeof( name_init ) ),
+                                cf_type_name, type->name, field->name, field->is_base ? "CF_FIELD_BASE" : "0",
+                                (unsigned long long)cf_hash_name( field->name ) );
             }
             file_print_fmt( fp, "};\n" );
+            print_base_assert( fp, type );
+
+            // Field name lookup table.
+            uint64_t hashes[ MAX_FIELDS ];
+            char     phash_symbol[ MAX_NAME_LENGTH * 2 ];
+            char     phash_init[ MAX_NAME_LENGTH * 4 ];
+            for ( int j = 0; j < type->struct_info.num_fields; ++j )
+            {
+                hashes[ j ] = cf_hash_name( type->struct_info.fields[ j ].name );
+            }
+            str_print_fmt( phash_symbol, sizeof( phash_symbol ), "cf_%s_%s_field_hash", module_name,
+                           type->name );
+            generate_phash( fp, phash_symbol, hashes, type->struct_info.num_fields, phash_init,
+                            sizeof( phash_init ) );
+
+            const parsed_field_t* base = get_base_field( type );
+            char                  parent_init[ MAX_NAME_LENGTH + 16 ];
+            if ( base )
+            {
+                str_print_fmt( parent_init, sizeof( parent_init ), "&cf_type_%s",
+                               get_cf_type_name( base->type_name ) );
+            }
+            else
+            {
+                str_copy( parent_init, "NULL", sizeof( parent_init ) );
+            }
+
+            char funcs_init[ MAX_NAME_LENGTH * 2 + 32 ];
+            if ( wants_codegen( options, type ) )
+            {
+                str_print_fmt( funcs_init, sizeof( funcs_init ), "&cf_%s_%s_funcs", module_name, type->name );
+            }
+            else
+            {
+                str_copy( funcs_init, "NULL", sizeof( funcs_init ) );
+            }
+
+            file_print_fmt( fp, "static cf_type_state_t cf_state_%s = { .index = -1 };\n", type->name );
             file_print_fmt(
                 fp,
-                "static const cf_type_t cf_type_%s = { .name = \"%s\", .kind = CF_KIND_STRUCT, .size = sizeof(%s), .align = _Alignof(%s), .struct_array = cf_%s_%s_fields, .struct_count = %d, .struct_parent = NULL, .struct_is_anonymous = false };\n\n",
-                type->name, type->name, type->name, type->name, module_name, type->name,
-                type->struct_info.num_fields );
+                "CF_SHARED const cf_type_t cf_type_%s = { .name = %s, .kind = CF_KIND_STRUCT, .size = sizeof(%s), .align = _Alignof(%s), .id = CF_TYPE_ID_%s, .state = &cf_state_%s, .struct_array = cf_%s_%s_fields, .struct_count = %d, .struct_parent = %s, .struct_is_anonymous = false, .struct_phash = %s, .struct_funcs = %s };\n\n",
+                type->name, quote_name( type->name, strip_names, name_init, sizeof( name_init ) ), type->name,
+                type->name, type->name, type->name, module_name, type->name, type->struct_info.num_fields,
+                parent_init, phash_init, funcs_init );
         }
         else if ( type->kind == PARSED_KIND_ENUM )
         {
@@ -154,26 +704,31 @@ generate_c_file( FILE*           fp,
             for ( int j = 0; j < type->enum_info.num_values; ++j )
             {
                 const parsed_enum_value_t* value = &type->enum_info.values[ j ];
-                file_print_fmt( fp, "    { \"%s\", %d },\n", value->name, value->value );
+                file_print_fmt( fp, "    { %s, %d, 0x%016llxull },\n",
+                                quote_name( value->name, strip_names, name_init, sizeof( name_init ) ),
+                                value->value, (unsigned long long)cf_hash_name( value->name ) );
             }
             file_print_fmt( fp, "};\n" );
+
+            // Value lookup tables and name <-> value codecs.
+            char tables_init[ MAX_NAME_LENGTH * 8 ];
+            char codecs_init[ MAX_NAME_LENGTH * 8 ];
+            generate_enum_tables( fp, module_name, type, tables_init, sizeof( tables_init ) );
+            generate_enum_codecs( fp, module_name, type, strip_names, codecs_init, sizeof( codecs_init ) );
+
+            file_print_fmt( fp, "static cf_type_state_t cf_state_%s = { .index = -1 };\n", type->name );
             file_print_fmt(
                 fp,
-                "static const cf_type_t cf_type_%s = { .name = \"%s\", .kind = CF_KIND_ENUM, .size = sizeof(%s), .align = _Alignof(%s), .enum_array = cf_%s_%s_values, .enum_count = %d, .enum_is_bitflag = false };\n\n",
-                type->name, type->name, type->name, type->name, module_name, type->name,
-                type->enum_info.num_values );
+                "CF_SHARED const cf_type_t cf_type_%s = { .name = %s, .kind = CF_KIND_ENUM, .size = sizeof(%s), .align = _Alignof(%s), .id = CF_TYPE_ID_%s, .state = &cf_state_%s, .enum_array = cf_%s_%s_values, .enum_count = %d, .enum_is_bitflag = false, %s, %s };\n\n",
+                type->name, quote_name( type->name, strip_names, name_init, sizeof( name_init ) ), type->name,
+                type->name, type->name, type->name, module_name, type->name, type->enum_info.num_values,
+                tables_init, codecs_init );
         }
     }
 
-    if ( ( include_default_types ) || ( data->num_types > 0 ) )
+    if ( data->num_types > 0 )
     {
         file_print_fmt( fp, "static const cf_type_t* %s_type_array[] = {\n", module_name );
-        if ( include_default_types )
-        {
-            file_print_fmt(
-                fp,
-                "    &cf_type_void, &cf_type_bool, &cf_type_char, &cf_type_i8, &cf_type_i16, &cf_type_i32, &cf_type_i64, &cf_type_u8, &cf_type_u16, &cf_type_u32, &cf_type_u64, &cf_type_f32, &cf_type_f64, &cf_type_cstr,\n" );
-        }
         for ( int i = 0; i < data->num_types; ++i )
         {
             file_print_fmt( fp, "    &cf_type_%s,\n", data->types[ i ].name );
@@ -181,6 +736,18 @@ generate_c_file( FILE*           fp,
         file_print_fmt( fp, "};\n" );
         file_print_fmt( fp, "static const int32_t %s_type_count = sizeof(%s_type_array) / sizeof(%s_type_array[0]);\n\n",
                         module_name, module_name, module_name );
+
+        // The runtime finds this entry on its own, so no registration call is needed.
+        if ( options->linker_sections )
+        {
+            file_print_fmt(
+                fp,
+                "static const cf_module_t cf_module_%s = { .types = %s_type_array, .count = sizeof(%s_type_array) / sizeof(%s_type_array[0]) };\n",
+                module_name, module_name, module_name, module_name );
+            file_print_fmt(
+                fp, "CF_MODULE_SECTION const cf_module_t* const cf_module_entry_%s = &cf_module_%s;\n\n",
+                module_name, module_name );
+        }
     }
     else
     {
@@ -190,18 +757,124 @@ generate_c_file( FILE*           fp,
 
     file_print_fmt( fp, "void %s_register_types(void) {\n", module_name );
     file_print_fmt( fp, "    cf_register_type_table(%s_type_array, %s_type_count);\n", module_name, module_name );
+    file_print_fmt( fp, "}\n\n" );
+    file_print_fmt( fp, "void %s_unregister_types(void) {\n", module_name );
+    file_print_fmt( fp, "    cf_unregister_type_table(%s_type_array);\n", module_name );
     file_print_fmt( fp, "}\n" );
 }
 
 /*============================================================================================*/
 
+// Checks that no two names that share a lookup scope (the module's types, a struct's
+// fields, an enum's values) share a hash. Stripped builds can only tell names apart by hash.
+static bool
+check_name_hashes( const parsed_data_t* data )
+{
+    static uint64_t type_hashes[ MAX_USER_TYPES + NUM_DEFAULT_TYPES ];
+    static char     type_names[ MAX_USER_TYPES + NUM_DEFAULT_TYPES ][ MAX_NAME_LENGTH ];
+    int32_t         num_types = 0;
+
+    // The primitives share the registry with every module.
+    for ( int32_t i = 0; i < NUM_DEFAULT_TYPES; ++i )
+    {
+        str_copy( type_names[ num_types ], default_types[ i ].c_name, MAX_NAME_LENGTH );
+        type_hashes[ num_types++ ] = cf_hash_name( default_types[ i ].c_name );
+    }
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        str_copy( type_names[ num_types ], data->types[ i ].name, MAX_NAME_LENGTH );
+        type_hashes[ num_types++ ] = cf_hash_name( data->types[ i ].name );
+    }
+
+    bool ok = true;
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        for ( int32_t j = i + 1; j < num_types; ++j )
+        {
+            if ( type_hashes[ i ] == type_hashes[ j ] && str_cmp( type_names[ i ], type_names[ j ] ) != 0 )
+            {
+                file_print_fmt( stderr, "Error: Types '%s' and '%s' have the same name hash.\n",
+                                type_names[ i ], type_names[ j ] );
+                ok = false;
+            }
+        }
+    }
+
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type    = &data->types[ i ];
+        bool                 is_enum = type->kind == PARSED_KIND_ENUM;
+        int32_t              count   = is_enum ? type->enum_info.num_values : type->struct_info.num_fields;
+        for ( int32_t j = 0; j < count; ++j )
+        {
+            const char* a = is_enum ? type->enum_info.values[ j ].name : type->struct_info.fields[ j ].name;
+            for ( int32_t k = j + 1; k < count; ++k )
+            {
+                const char* b =
+                    is_enum ? type->enum_info.values[ k ].name : type->struct_info.fields[ k ].name;
+                if ( cf_hash_name( a ) == cf_hash_name( b ) && str_cmp( a, b ) != 0 )
+                {
+                    file_print_fmt( stderr, "Error: '%s' and '%s' in '%s' have the same name hash.\n", a, b,
+                                    type->name );
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+/*============================================================================================*/
+
+// Generates the `<module_name>_generated.names` sidecar of a stripped build. Each line maps
+// a name hash back to its name: "<hash> type <name>", "<hash> field <type>.<name>" or
+// "<hash> value <type>.<name>".
+static void
+generate_names_file( FILE* fp, const output_options_t* options, const parsed_data_t* data )
+{
+    file_print_fmt( fp, "# cflex name hashes for module '%s'. Generated by cflex_build --strip-names.\n",
+                    options->module_name );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        file_print_fmt( fp, "0x%016llx type %s\n", (unsigned long long)cf_hash_name( type->name ),
+                        type->name );
+        if ( type->kind == PARSED_KIND_STRUCT )
+        {
+            for ( int j = 0; j < type->struct_info.num_fields; ++j )
+            {
+                const char* name = type->struct_info.fields[ j ].name;
+                file_print_fmt( fp, "0x%016llx field %s.%s\n", (unsigned long long)cf_hash_name( name ),
+                                type->name, name );
+            }
+        }
+        else if ( type->kind == PARSED_KIND_ENUM )
+        {
+            for ( int j = 0; j < type->enum_info.num_values; ++j )
+            {
+                const char* name = type->enum_info.values[ j ].name;
+                file_print_fmt( fp, "0x%016llx value %s.%s\n", (unsigned long long)cf_hash_name( name ),
+                                type->name, name );
+            }
+        }
+    }
+}
+
+/*============================================================================================*/
+
 bool
-generate_output_files( const char*      output_path,
-                       const char*      module_name,
-                       bool             include_default_types,
-                       const parsed_data_t* data,
-                       const file_list_t*   headers )
+generate_output_files( const char*             output_path,
+                       const output_options_t* options,
+                       const parsed_data_t*    data,
+                       const file_list_t*      headers )
 {
+    const char* module_name = options->module_name;
+    if ( !check_base_fields( data ) || !check_codegen_types( options, data ) ||
+         ( options->strip_names && !check_name_hashes( data ) ) )
+    {
+        return false;
+    }
+
     char h_path[ MAX_PATH_LENGTH ];
     char c_path[ MAX_PATH_LENGTH ];
     str_print_fmt( h_path, sizeof( h_path ), "%s/%s_generated.h", output_path, module_name );
@@ -213,7 +886,7 @@ generate_output_files( const char*      output_path,
         file_print_fmt( stderr, "Error: Could not open file for writing: %s\n", h_path );
         return false;
     }
-    generate_h_file( fp_h, module_name, include_default_types, data );
+    generate_h_file( fp_h, options, data, headers );
     fclose( fp_h );
     print_fmt( "Generated %s\n", h_path );
 
@@ -223,10 +896,53 @@ generate_output_files( const char*      output_path,
         file_print_fmt( stderr, "Error: Could not open file for writing: %s\n", c_path );
         return false;
     }
-    generate_c_file( fp_c, module_name, include_default_types, data, headers );
+    bool ok = true;
+    if ( options->packed )
+    {
+        ok = generate_packed_c_file( fp_c, options, data, headers );
+    }
+    else
+    {
+        generate_c_file( fp_c, options, data, headers );
+    }
     fclose( fp_c );
+    if ( !ok )
+    {
+        file_print_fmt( stderr, "Error: Could not generate packed tables for %s\n", c_path );
+        return false;
+    }
     print_fmt( "Generated %s\n", c_path );
 
+    if ( options->emit_cpp )
+    {
+        char hpp_path[ MAX_PATH_LENGTH ];
+        str_print_fmt( hpp_path, sizeof( hpp_path ), "%s/%s_generated.hpp", output_path, module_name );
+        FILE* fp_hpp = fopen( hpp_path, "w" );
+        if ( !fp_hpp )
+        {
+            file_print_fmt( stderr, "Error: Could not open file for writing: %s\n", hpp_path );
+            return false;
+        }
+        generate_hpp_file( fp_hpp, options, data );
+        fclose( fp_hpp );
+        print_fmt( "Generated %s\n", hpp_path );
+    }
+
+    if ( options->strip_names )
+    {
+        char names_path[ MAX_PATH_LENGTH ];
+        str_print_fmt( names_path, sizeof( names_path ), "%s/%s_generated.names", output_path, module_name );
+        FILE* fp_names = fopen( names_path, "w" );
+        if ( !fp_names )
+        {
+            file_print_fmt( stderr, "Error: Could not open file for writing: %s\n", names_path );
+            return false;
+        }
+        generate_names_file( fp_names, options, data );
+        fclose( fp_names );
+        print_fmt( "Generated %s\n", names_path );
+    }
+
     return true;
 }
 
@@ -0,0 +1,286 @@
+/*==============================================================================================
+
+    Codegen Output
+
+    Emits straight-line functions for the structs annotated CF_STRUCT( codegen ), or for
+    every struct with cflex_build --codegen:
+
+        <type>_write / <type>_read     one object in the cf_serialize() format
+        <type>_hash / <type>_equal     the same results as cf_hash_object() and cf_objects_equal()
+
+    Nested struct fields of the module are expanded to their leaves, so each function is a
+    fixed sequence of copies, hashes and compares at constant offsets, with one bounds check.
+    The runtime reaches them through cf_type_t.struct_funcs.
+
+==============================================================================================*/
+
+#define MAX_CODEGEN_LEAVES 256
+#define MAX_CODEGEN_DEPTH  32
+
+// The primitive and enum members of a struct as member access paths, e.g. "position.x".
+typedef struct codegen_leaves_t
+{
+    char    paths[ MAX_CODEGEN_LEAVES ][ MAX_NAME_LENGTH ];
+    int32_t count;
+} codegen_leaves_t;
+
+// Returns true if functions are generated for `type`.
+static bool
+wants_codegen( const output_options_t* options, const parsed_type_t* type )
+{
+    return type->kind == PARSED_KIND_STRUCT && ( options->codegen || type->struct_info.codegen );
+}
+
+// Returns the type reflected by this module under `name`, or NULL.
+static const parsed_type_t*
+find_module_type( const parsed_data_t* data, const char* name )
+{
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        if ( str_cmp( data->types[ i ].name, name ) == 0 )
+        {
+            return &data->types[ i ];
+        }
+    }
+    return NULL;
+}
+
+// Appends the leaves of `type` to `leaves`, each prefixed with `prefix`. Fails for field types
+// whose layout this module does not know and for strings, whose length is only known at run
+// time.
+static bool
+collect_codegen_leaves( const parsed_data_t* data,
+                        const parsed_type_t* type,
+                        const char*          prefix,
+                        int32_t              depth,
+                        codegen_leaves_t*    leaves )
+{
+    for ( int i = 0; i < type->struct_info.num_fields; ++i )
+    {
+        const parsed_field_t* field   = &type->struct_info.fields[ i ];
+        const char*           cf_name = get_cf_type_name( field->type_name );
+        const parsed_type_t*  nested  = find_module_type( data, field->type_name );
+        if ( cf_name == field->type_name && !nested )
+        {
+            file_print_fmt(
+                stderr,
+                "Error: Cannot generate functions for '%s': field '%s' has type '%s', which this module does not reflect.\n",
+                type->name, field->name, field->type_name );
+            return false;
+        }
+        if ( str_cmp( cf_name, "cstr" ) == 0 )
+        {
+            file_print_fmt( stderr, "Error: Cannot generate functions for '%s': string field '%s'.\n",
+                            type->name, field->name );
+            return false;
+        }
+
+        char path[ MAX_NAME_LENGTH ];
+        str_print_fmt( path, sizeof( path ), "%s%s", prefix, field->name );
+        if ( nested && nested->kind == PARSED_KIND_STRUCT )
+        {
+            if ( depth >= MAX_CODEGEN_DEPTH )
+            {
+                file_print_fmt( stderr,
+                                "Error: Cannot generate functions for '%s': fields nested too deeply.\n",
+                                type->name );
+                return false;
+            }
+            char nested_prefix[ MAX_NAME_LENGTH ];
+            str_print_fmt( nested_prefix, sizeof( nested_prefix ), "%s.", path );
+            if ( !collect_codegen_leaves( data, nested, nested_prefix, depth + 1, leaves ) )
+            {
+                return false;
+            }
+            continue;
+        }
+
+        if ( leaves->count >= MAX_CODEGEN_LEAVES )
+        {
+            file_print_fmt( stderr, "Error: Cannot generate functions for '%s': more than %d members.\n",
+                            type->name, MAX_CODEGEN_LEAVES );
+            return false;
+        }
+        str_copy( leaves->paths[ leaves->count++ ], path, MAX_NAME_LENGTH );
+    }
+    return true;
+}
+
+static bool
+check_codegen_types( const output_options_t* options, const parsed_data_t* data )
+{
+    static codegen_leaves_t leaves;
+
+    bool ok = true;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        if ( wants_codegen( options, &data->types[ i ] ) )
+        {
+            leaves.count = 0;
+            ok           = collect_codegen_leaves( data, &data->types[ i ], "", 0, &leaves ) && ok;
+        }
+    }
+    return ok;
+}
+
+/*============================================================================================*/
+
+static void
+print_codegen_decls( FILE* fp, const output_options_t* options, const parsed_data_t* data )
+{
+    bool any = false;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( !wants_codegen( options, type ) )
+        {
+            continue;
+        }
+        if ( !any )
+        {
+            file_print_fmt(
+                fp, "// Generated functions of CF_STRUCT( codegen ) structs, see cf_struct_funcs_t.\n" );
+            any = true;
+        }
+
+        const char* name = type->name;
+        file_print_fmt( fp, "size_t %s_write(const %s* object, void* buffer, size_t buffer_size);\n", name,
+                        name );
+        file_print_fmt( fp, "size_t %s_read(%s* object, const void* buffer, size_t buffer_size);\n", name,
+                        name );
+        file_print_fmt( fp, "uint64_t %s_hash(const %s* object);\n", name, name );
+        file_print_fmt( fp, "bool %s_equal(const %s* a, const %s* b);\n", name, name, name );
+    }
+    if ( any )
+    {
+        file_print_fmt( fp, "\n" );
+    }
+}
+
+// Prints the serialized size of a struct: the sum of its leaf sizes.
+static void
+print_codegen_size( FILE* fp, const codegen_leaves_t* leaves )
+{
+    file_print_fmt( fp, "    const size_t size = " );
+    for ( int32_t i = 0; i < leaves->count; ++i )
+    {
+        file_print_fmt( fp, "%ssizeof(object->%s)", i ? " + " : "", leaves->paths[ i ] );
+    }
+    file_print_fmt( fp, "%s;\n", leaves->count ? "" : "0" );
+}
+
+// Silences an unused parameter in the functions of a struct without members.
+static void
+print_codegen_unused( FILE* fp, const codegen_leaves_t* leaves, const char* param )
+{
+    if ( leaves->count == 0 )
+    {
+        file_print_fmt( fp, "    (void)%s;\n", param );
+    }
+}
+
+// Emits the functions of one struct, thunks with the untyped signatures of
+// cf_struct_funcs_t, and the table cf_<module>_<type>_funcs.
+static void
+print_codegen_struct( FILE*                fp,
+                      const char*          module_name,
+                      const parsed_data_t* data,
+                      const parsed_type_t* type )
+{
+    static codegen_leaves_t leaves;
+    leaves.count = 0;
+    collect_codegen_leaves( data, type, "", 0, &leaves );
+
+    const char* name = type->name;
+
+    // Write: one bounds check, then a copy per leaf.
+    file_print_fmt( fp, "size_t %s_write(const %s* object, void* buffer, size_t buffer_size) {\n", name,
+                    name );
+    print_codegen_size( fp, &leaves );
+    file_print_fmt( fp, "    uint8_t* out = (uint8_t*)buffer;\n" );
+    file_print_fmt( fp, "    if (!out) return size;\n" );
+    file_print_fmt( fp, "    if (buffer_size < size) return 0;\n" );
+    for ( int32_t i = 0; i < leaves.count; ++i )
+    {
+        const char* path = leaves.paths[ i ];
+        file_print_fmt( fp, "    memcpy(out, &object->%s, sizeof(object->%s)); out += sizeof(object->%s);\n",
+                        path, path, path );
+    }
+    print_codegen_unused( fp, &leaves, "object" );
+    file_print_fmt( fp, "    return size;\n" );
+    file_print_fmt( fp, "}\n" );
+
+    // Read: the same steps in reverse direction.
+    file_print_fmt( fp, "size_t %s_read(%s* object, const void* buffer, size_t buffer_size) {\n", name,
+                    name );
+    print_codegen_size( fp, &leaves );
+    file_print_fmt( fp, "    const uint8_t* in = (const uint8_t*)buffer;\n" );
+    file_print_fmt( fp, "    if (!in || buffer_size < size) return 0;\n" );
+    for ( int32_t i = 0; i < leaves.count; ++i )
+    {
+        const char* path = leaves.paths[ i ];
+        file_print_fmt( fp, "    memcpy(&object->%s, in, sizeof(object->%s)); in += sizeof(object->%s);\n",
+                        path, path, path );
+    }
+    print_codegen_unused( fp, &leaves, "object" );
+    file_print_fmt( fp, "    return size;\n" );
+    file_print_fmt( fp, "}\n" );
+
+    // Hash: every leaf mixed in declaration order, as cf_hash_object() does.
+    file_print_fmt( fp, "uint64_t %s_hash(const %s* object) {\n", name, name );
+    file_print_fmt( fp, "    uint64_t hash = CF_OBJECT_HASH_SEED;\n" );
+    for ( int32_t i = 0; i < leaves.count; ++i )
+    {
+        const char* path = leaves.paths[ i ];
+        file_print_fmt( fp, "    hash = cf_hash_bits(hash, &object->%s, sizeof(object->%s));\n", path, path );
+    }
+    print_codegen_unused( fp, &leaves, "object" );
+    file_print_fmt( fp, "    return hash;\n" );
+    file_print_fmt( fp, "}\n" );
+
+    // Equal: every leaf compared, without an early exit.
+    file_print_fmt( fp, "bool %s_equal(const %s* a, const %s* b) {\n", name, name, name );
+    file_print_fmt( fp, "    uint64_t diff = 0;\n" );
+    for ( int32_t i = 0; i < leaves.count; ++i )
+    {
+        const char* path = leaves.paths[ i ];
+        file_print_fmt( fp, "    diff |= cf_diff_bits(&a->%s, &b->%s, sizeof(a->%s));\n", path, path, path );
+    }
+    print_codegen_unused( fp, &leaves, "a" );
+    print_codegen_unused( fp, &leaves, "b" );
+    file_print_fmt( fp, "    return diff == 0;\n" );
+    file_print_fmt( fp, "}\n" );
+
+    // Untyped thunks for cf_struct_funcs_t; the compiler folds the typed calls into them.
+    file_print_fmt(
+        fp,
+        "static size_t cf_%s_%s_write(const void* object, void* buffer, size_t buffer_size) { return %s_write((const %s*)object, buffer, buffer_size); }\n",
+        module_name, name, name, name );
+    file_print_fmt(
+        fp,
+        "static size_t cf_%s_%s_read(void* object, const void* buffer, size_t buffer_size) { return %s_read((%s*)object, buffer, buffer_size); }\n",
+        module_name, name, name, name );
+    file_print_fmt(
+        fp, "static uint64_t cf_%s_%s_hash(const void* object) { return %s_hash((const %s*)object); }\n",
+        module_name, name, name, name );
+    file_print_fmt(
+        fp,
+        "static bool cf_%s_%s_equal(const void* a, const void* b) { return %s_equal((const %s*)a, (const %s*)b); }\n",
+        module_name, name, name, name, name );
+    file_print_fmt(
+        fp,
+        "static const cf_struct_funcs_t cf_%s_%s_funcs = { cf_%s_%s_write, cf_%s_%s_read, cf_%s_%s_hash, cf_%s_%s_equal };\n\n",
+        module_name, name, module_name, name, module_name, name, module_name, name, module_name, name );
+}
+
+static void
+print_codegen_functions( FILE* fp, const output_options_t* options, const parsed_data_t* data )
+{
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        if ( wants_codegen( options, &data->types[ i ] ) )
+        {
+            print_codegen_struct( fp, options->module_name, data, &data->types[ i ] );
+        }
+    }
+}
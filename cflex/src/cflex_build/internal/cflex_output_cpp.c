@@ -0,0 +1,127 @@
+/*==============================================================================================
+
+    C++ Output
+
+    Emits <module>_generated.hpp (cflex_build --emit-cpp): a cf::type_desc<T> specialization
+    per struct and enum, for use with cflex.hpp. Structs list their fields as member
+    pointers, so C++ code can visit them without reading the runtime descriptors.
+
+==============================================================================================*/
+
+// Prints the members every type_desc<T> specialization shares.
+static void
+print_cpp_common_members( FILE*                   fp,
+                          const output_options_t* options,
+                          const parsed_type_t*    type,
+                          const char*             kind )
+{
+    if ( options->strip_names )
+    {
+        file_print_fmt( fp, "    static constexpr const char* name  = nullptr;\n" );
+    }
+    else
+    {
+        file_print_fmt( fp, "    static constexpr const char* name  = \"%s\";\n", type->name );
+    }
+    file_print_fmt( fp, "    static constexpr uint64_t    id    = CF_TYPE_ID_%s;\n", type->name );
+    file_print_fmt( fp, "    static constexpr cf_kind_t   kind  = %s;\n", kind );
+    file_print_fmt( fp, "    static constexpr int32_t     size  = sizeof( %s );\n", type->name );
+    file_print_fmt( fp, "    static constexpr int32_t     align = alignof( %s );\n\n", type->name );
+
+    // Packed modules have no descriptor variables; their types are found by ID.
+    if ( options->packed )
+    {
+        file_print_fmt( fp, "    static const cf_type_t* type() { return cf_find_type_by_id( id ); }\n" );
+    }
+    else
+    {
+        file_print_fmt( fp, "    static constexpr const cf_type_t* type() { return &cf_type_%s; }\n",
+                        type->name );
+    }
+}
+
+// Prints the type_desc<T> specialization of a struct.
+static void
+print_cpp_struct( FILE* fp, const output_options_t* options, const parsed_type_t* type )
+{
+    const parsed_field_t* base = get_base_field( type );
+
+    file_print_fmt( fp, "template <>\nstruct type_desc<%s>\n{\n", type->name );
+    print_cpp_common_members( fp, options, type, "CF_KIND_STRUCT" );
+    file_print_fmt( fp, "\n    static constexpr int32_t field_count = %d;\n", type->struct_info.num_fields );
+    file_print_fmt( fp, "    using parent                         = %s;\n\n",
+                    base ? base->type_name : "void" );
+
+    file_print_fmt( fp, "    template <typename Visitor>\n" );
+    file_print_fmt( fp, "    static constexpr void\n" );
+    file_print_fmt( fp, "    visit_fields( Visitor&& visitor )\n" );
+    file_print_fmt( fp, "    {\n" );
+    for ( int i = 0; i < type->struct_info.num_fields; ++i )
+    {
+        const parsed_field_t* field = &type->struct_info.fields[ i ];
+        file_print_fmt( fp, "        visitor( field_t<%s, decltype( %s::%s )>{ ", type->name, type->name,
+                        field->name );
+        if ( options->strip_names )
+        {
+            file_print_fmt( fp, "nullptr" );
+        }
+        else
+        {
+            file_print_fmt( fp, "\"%s\"", field->name );
+        }
+        file_print_fmt( fp, ", &%s::%s, %d, 0x%016llxull } );\n", type->name, field->name, i,
+                        (unsigned long long)cf_hash_name( field->name ) );
+    }
+    if ( type->struct_info.num_fields == 0 )
+    {
+        file_print_fmt( fp, "        (void)visitor;\n" );
+    }
+    file_print_fmt( fp, "    }\n};\n\n" );
+}
+
+// Prints the type_desc<T> specialization of an enum.
+static void
+print_cpp_enum( FILE* fp, const output_options_t* options, const parsed_type_t* type )
+{
+    file_print_fmt( fp, "template <>\nstruct type_desc<%s>\n{\n", type->name );
+    print_cpp_common_members( fp, options, type, "CF_KIND_ENUM" );
+    file_print_fmt( fp, "\n    static constexpr int32_t value_count = %d;\n", type->enum_info.num_values );
+    file_print_fmt( fp, "};\n\n" );
+}
+
+// Generates the content of the `<module_name>_generated.hpp` file.
+static void
+generate_hpp_file( FILE* fp, const output_options_t* options, const parsed_data_t* data )
+{
+    const char* module_name = options->module_name;
+
+    file_print_fmt( fp, "// THIS FILE IS-GENERATED BY CFLEX_BUILD. DO NOT EDIT.\n" );
+    file_print_fmt( fp, "#ifndef " );
+    print_uppercase( fp, module_name );
+    file_print_fmt( fp, "_GENERATED_HPP\n" );
+    file_print_fmt( fp, "#define " );
+    print_uppercase( fp, module_name );
+    file_print_fmt( fp, "_GENERATED_HPP\n\n" );
+
+    file_print_fmt( fp, "#include \"cflex.hpp\"\n" );
+    file_print_fmt( fp, "#include \"%s_generated.h\"\n\n", module_name );
+
+    file_print_fmt( fp, "namespace cf\n{\n\n" );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind == PARSED_KIND_STRUCT )
+        {
+            print_cpp_struct( fp, options, type );
+        }
+        else
+        {
+            print_cpp_enum( fp, options, type );
+        }
+    }
+    file_print_fmt( fp, "}    // namespace cf\n\n" );
+
+    file_print_fmt( fp, "#endif // " );
+    print_uppercase( fp, module_name );
+    file_print_fmt( fp, "_GENERATED_HPP\n" );
+}
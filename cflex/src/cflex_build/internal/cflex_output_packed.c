@@ -0,0 +1,539 @@
+/*==============================================================================================
+
+    Packed Output
+
+    Emits the relocation-free form of a module's reflection data (cflex_build --packed).
+    Instead of cf_type_t descriptors full of pointers, the module gets:
+
+        cf_<module>_strings   every name, NUL-terminated and deduplicated, in one blob
+        cf_<module>_lookup    every perfect hash table (seeds, then slots) in one blob
+        cf_<module>_types     cf_packed_type_t records, hot data first
+        cf_<module>_fields    cf_packed_field_t records, grouped by struct
+        cf_<module>_values    cf_packed_value_t records, grouped by enum
+        cf_<module>_refs      IDs of the field types, resolved by the runtime
+
+    Records refer to each other by offset or index, so none of this needs a load-time
+    relocation in a position independent executable. The runtime materializes regular
+    cf_type_t descriptors from it on registration.
+
+==============================================================================================*/
+
+// Offset of a missing table; matches CF_PACKED_NONE in the runtime.
+#define PACKED_NONE 0xffffffffu
+
+#define PACKED_MAX_TYPES  ( MAX_USER_TYPES + NUM_DEFAULT_TYPES )
+#define PACKED_MAX_FIELDS ( MAX_USER_TYPES * MAX_FIELDS )
+#define PACKED_MAX_VALUES ( MAX_USER_TYPES * MAX_ENUM_VALUES )
+#define PACKED_MAX_LOOKUP ( PACKED_MAX_FIELDS + PACKED_MAX_VALUES + PACKED_MAX_TYPES * PHASH_MAX_KEYS )
+
+// Offsets and indices computed before anything is printed. Static to keep them off the stack.
+typedef struct packed_layout_t
+{
+    bool     strip_names;
+    char*    strings;
+    int32_t  strings_size;
+    uint16_t lookup[ PACKED_MAX_LOOKUP ];
+    int32_t  lookup_size;
+    uint64_t refs[ PACKED_MAX_FIELDS ];
+    int32_t  num_refs;
+
+    uint32_t type_name[ PACKED_MAX_TYPES ];
+    uint32_t type_lookup[ PACKED_MAX_TYPES ];
+    uint32_t field_name[ PACKED_MAX_FIELDS ];
+    uint32_t field_ref[ PACKED_MAX_FIELDS ];
+    uint32_t value_name[ PACKED_MAX_VALUES ];
+} packed_layout_t;
+
+/*============================================================================================*/
+
+// Adds a name to the string blob and returns its offset. Names already in the blob are
+// shared, which folds the many "x", "y", "name" fields of a module into one copy each.
+// Stripped builds keep no names at all.
+static uint32_t
+packed_add_string( packed_layout_t* layout, const char* str )
+{
+    if ( layout->strip_names )
+    {
+        return PACKED_NONE;
+    }
+
+    for ( int32_t offset = 0; offset < layout->strings_size; )
+    {
+        const char* entry = layout->strings + offset;
+        if ( str_cmp( entry, str ) == 0 )
+        {
+            return (uint32_t)offset;
+        }
+        offset += str_len( entry ) + 1;
+    }
+
+    int32_t offset = layout->strings_size;
+    int32_t size   = str_len( str ) + 1;
+    mem_copy( layout->strings + offset, str, size );
+    layout->strings_size += size;
+    return (uint32_t)offset;
+}
+
+// Builds a perfect hash over `count` names, appends it to the lookup blob and returns its
+// offset, or PACKED_NONE when no table could be built.
+static uint32_t
+packed_add_phash( packed_layout_t* layout, const uint64_t* hashes, int32_t count )
+{
+    static phash_t phash;
+    if ( !phash_build( hashes, count, &phash ) )
+    {
+        return PACKED_NONE;
+    }
+
+    uint32_t offset = (uint32_t)layout->lookup_size;
+    for ( int32_t i = 0; i < phash.num_buckets; ++i )
+    {
+        layout->lookup[ layout->lookup_size++ ] = phash.seeds[ i ];
+    }
+    for ( int32_t i = 0; i < phash.num_keys; ++i )
+    {
+        layout->lookup[ layout->lookup_size++ ] = phash.slots[ i ];
+    }
+    return offset;
+}
+
+// Returns the index of a field type ID in the reference table, adding it if needed.
+static uint32_t
+packed_add_ref( packed_layout_t* layout, uint64_t id )
+{
+    for ( int32_t i = 0; i < layout->num_refs; ++i )
+    {
+        if ( layout->refs[ i ] == id )
+        {
+            return (uint32_t)i;
+        }
+    }
+    layout->refs[ layout->num_refs ] = id;
+    return (uint32_t)layout->num_refs++;
+}
+
+/*============================================================================================*/
+
+// Computes every offset of the packed module. Field types, including the primitives
+// shared by the runtime, are referenced by ID and resolved on registration.
+static bool
+packed_build_layout( const output_options_t* options, const parsed_data_t* data, packed_layout_t* layout )
+{
+    int32_t capacity = 0;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        capacity += str_len( type->name ) + 1;
+        if ( type->kind == PARSED_KIND_STRUCT )
+        {
+            for ( int j = 0; j < type->struct_info.num_fields; ++j )
+            {
+                capacity += str_len( type->struct_info.fields[ j ].name ) + 1;
+            }
+        }
+        else if ( type->kind == PARSED_KIND_ENUM )
+        {
+            for ( int j = 0; j < type->enum_info.num_values; ++j )
+            {
+                capacity += str_len( type->enum_info.values[ j ].name ) + 1;
+            }
+        }
+    }
+
+    layout->strings = (char*)mem_alloc( capacity + 1 );
+    if ( !layout->strings )
+    {
+        return false;
+    }
+    layout->strip_names  = options->strip_names;
+    layout->strings_size = 0;
+    layout->lookup_size  = 0;
+    layout->num_refs     = 0;
+
+    int32_t num_types    = 0;
+    int32_t num_fields   = 0;
+    int32_t num_values   = 0;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        uint64_t             hashes[ PHASH_MAX_KEYS ];
+
+        layout->type_name[ num_types ]   = packed_add_string( layout, type->name );
+        layout->type_lookup[ num_types ] = PACKED_NONE;
+        if ( type->kind == PARSED_KIND_STRUCT )
+        {
+            for ( int j = 0; j < type->struct_info.num_fields; ++j )
+            {
+                const parsed_field_t* field      = &type->struct_info.fields[ j ];
+                layout->field_name[ num_fields ] = packed_add_string( layout, field->name );
+                layout->field_ref[ num_fields ]  = packed_add_ref( layout, cf_hash_name( field->type_name ) );
+                hashes[ j ]                      = cf_hash_name( field->name );
+                num_fields++;
+            }
+            layout->type_lookup[ num_types ] =
+                packed_add_phash( layout, hashes, type->struct_info.num_fields );
+        }
+        else if ( type->kind == PARSED_KIND_ENUM )
+        {
+            for ( int j = 0; j < type->enum_info.num_values; ++j )
+            {
+                layout->value_name[ num_values++ ] =
+                    packed_add_string( layout, type->enum_info.values[ j ].name );
+                hashes[ j ] = cf_hash_name( type->enum_info.values[ j ].name );
+            }
+            layout->type_lookup[ num_types ] = packed_add_phash( layout, hashes, type->enum_info.num_values );
+        }
+        num_types++;
+    }
+
+    return true;
+}
+
+/*============================================================================================*/
+
+// Emits cf_<module>_<suffix>, the name hashes of every struct field or enum value of the
+// module in the order of the packed field or value array.
+static void
+print_packed_name_hashes(
+    FILE* fp, const char* module_name, const parsed_data_t* data, parsed_kind_t kind, const char* suffix )
+{
+    int32_t count = 0;
+    file_print_fmt( fp, "static const uint64_t cf_%s_%s[] = {\n", module_name, suffix );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != kind )
+        {
+            continue;
+        }
+
+        bool    is_enum = type->kind == PARSED_KIND_ENUM;
+        int32_t num     = is_enum ? type->enum_info.num_values : type->struct_info.num_fields;
+        for ( int32_t j = 0; j < num; ++j, ++count )
+        {
+            const char* name =
+                is_enum ? type->enum_info.values[ j ].name : type->struct_info.fields[ j ].name;
+            file_print_fmt( fp, "    0x%016llxull,\n", (unsigned long long)cf_hash_name( name ) );
+        }
+    }
+    file_print_fmt( fp, "%s};\n", count ? "" : "    0\n" );
+}
+
+/*============================================================================================*/
+
+// Emits the name <-> value codecs of an enum against the packed arrays; see
+// generate_enum_codecs() for the regular form. `first` is the index of the enum's first
+// value in cf_<module>_values.
+static void
+generate_packed_enum_codecs( FILE*                fp,
+                             const char*          module_name,
+                             const parsed_type_t* type,
+                             bool                 strip_names,
+                             uint32_t             lookup,
+                             int32_t              first )
+{
+    int32_t     count = type->enum_info.num_values;
+    const char* name  = type->name;
+
+    // Name -> entry index.
+    file_print_fmt( fp, "static int32_t cf_%s_%s_index_of_name(const char* name, int32_t len) {\n",
+                    module_name, name );
+    if ( lookup != PACKED_NONE )
+    {
+        uint32_t num_buckets = cf_phash_num_buckets( (uint32_t)count );
+        file_print_fmt( fp, "    uint64_t hash = cf_hash_name_n(name, len);\n" );
+        file_print_fmt( fp, "    uint32_t seed = cf_%s_lookup[%u + cf_phash_bucket(hash, %uu)];\n",
+                        module_name, lookup, num_buckets - 1 );
+        file_print_fmt( fp, "    int32_t index = cf_%s_lookup[%u + cf_phash_slot(hash, seed, %du)];\n",
+                        module_name, lookup + num_buckets, count );
+        if ( strip_names )
+        {
+            file_print_fmt( fp, "    return cf_%s_value_hashes[%d + index] == hash ? index : -1;\n",
+                            module_name, first );
+        }
+        else
+        {
+            file_print_fmt( fp, "    const char* entry = cf_%s_strings + cf_%s_values[%d + index].name;\n",
+                            module_name, module_name, first );
+            file_print_fmt(
+                fp,
+                "    return (strncmp(entry, name, (size_t)len) == 0 && entry[len] == '\\0') ? index : -1;\n" );
+        }
+    }
+    else if ( strip_names )
+    {
+        file_print_fmt( fp, "    uint64_t hash = cf_hash_name_n(name, len);\n" );
+        file_print_fmt( fp, "    for (int32_t i = 0; i < %d; ++i) {\n", count );
+        file_print_fmt( fp, "        if (cf_%s_value_hashes[%d + i] == hash) return i;\n", module_name,
+                        first );
+        file_print_fmt( fp, "    }\n" );
+        file_print_fmt( fp, "    return -1;\n" );
+    }
+    else
+    {
+        file_print_fmt( fp, "    for (int32_t i = 0; i < %d; ++i) {\n", count );
+        file_print_fmt( fp, "        const char* entry = cf_%s_strings + cf_%s_values[%d + i].name;\n",
+                        module_name, module_name, first );
+        file_print_fmt(
+            fp, "        if (strncmp(entry, name, (size_t)len) == 0 && entry[len] == '\\0') return i;\n" );
+        file_print_fmt( fp, "    }\n" );
+        file_print_fmt( fp, "    return -1;\n" );
+    }
+    file_print_fmt( fp, "}\n" );
+
+    // Value -> entry index.
+    print_enum_index_of_value( fp, module_name, type );
+
+    // Typed wrappers.
+    file_print_fmt( fp, "bool %s_from_string(const char* str, %s* out_value) {\n", name, name );
+    file_print_fmt( fp, "    int32_t index = str ? cf_%s_%s_index_of_name(str, (int32_t)strlen(str)) : -1;\n",
+                    module_name, name );
+    file_print_fmt( fp, "    if (index < 0) return false;\n" );
+    file_print_fmt( fp, "    *out_value = (%s)cf_%s_values[%d + index].value;\n", name, module_name, first );
+    file_print_fmt( fp, "    return true;\n" );
+    file_print_fmt( fp, "}\n" );
+    file_print_fmt( fp, "const char* %s_to_string(%s value) {\n", name, name );
+    if ( strip_names )
+    {
+        file_print_fmt( fp, "    (void)value;\n" );
+        file_print_fmt( fp, "    return NULL;    // Names are stripped\n" );
+    }
+    else
+    {
+        file_print_fmt( fp, "    int32_t index = cf_%s_%s_index_of_value((int32_t)value);\n", module_name,
+                        name );
+        file_print_fmt( fp, "    return index >= 0 ? cf_%s_strings + cf_%s_values[%d + index].name : NULL;\n",
+                        module_name, module_name, first );
+    }
+    file_print_fmt( fp, "}\n" );
+}
+
+/*============================================================================================*/
+
+// Generates the content of the `<module_name>_generated.c` file in packed form.
+static bool
+generate_packed_c_file( FILE*                   fp,
+                        const output_options_t* options,
+                        const parsed_data_t*    data,
+                        const file_list_t*      headers )
+{
+    const char*            module_name = options->module_name;
+    static packed_layout_t layout;
+    if ( !packed_build_layout( options, data, &layout ) )
+    {
+        return false;
+    }
+
+    file_print_fmt( fp, "// THIS FILE IS-GENERATED BY CFLEX_BUILD. DO NOT EDIT.\n" );
+    file_print_fmt( fp, "#include \"internal/cflex_internal.h\"\n" );
+    file_print_fmt( fp, "#include \"%s_generated.h\"\n", module_name );
+    file_print_fmt( fp, "#include <stddef.h>\n" );
+    file_print_fmt( fp, "#include <string.h>\n\n" );
+
+    print_header_includes( fp, headers );
+    file_print_fmt( fp, "\n" );
+
+    print_codegen_functions( fp, options, data );
+
+    // String blob, one name per line.
+    file_print_fmt( fp, "static const char cf_%s_strings[] =\n", module_name );
+    for ( int32_t offset = 0; offset < layout.strings_size; )
+    {
+        const char* entry = layout.strings + offset;
+        file_print_fmt( fp, "    \"%s\\0\"\n", entry );
+        offset += str_len( entry ) + 1;
+    }
+    file_print_fmt( fp, "    \"\";\n" );
+
+    // Lookup blob.
+    file_print_fmt( fp, "static const uint16_t cf_%s_lookup[] = {", module_name );
+    for ( int32_t i = 0; i < layout.lookup_size; ++i )
+    {
+        file_print_fmt( fp, "%s%u", i == 0 ? "\n    " : ( i % 16 ) ? ", " : ",\n    ", layout.lookup[ i ] );
+    }
+    file_print_fmt( fp, "%s};\n", layout.lookup_size ? "\n" : " 0 " );
+
+    // Field type references.
+    file_print_fmt( fp, "static const uint64_t cf_%s_refs[] = {\n", module_name );
+    for ( int32_t i = 0; i < layout.num_refs; ++i )
+    {
+        file_print_fmt( fp, "    0x%016llxull,\n", (unsigned long long)layout.refs[ i ] );
+    }
+    file_print_fmt( fp, "%s};\n", layout.num_refs ? "" : "    0\n" );
+
+    // Fields.
+    int32_t num_fields = 0;
+    file_print_fmt( fp, "static const cf_packed_field_t cf_%s_fields[] = {\n", module_name );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != PARSED_KIND_STRUCT )
+        {
+            continue;
+        }
+        for ( int j = 0; j < type->struct_info.num_fields; ++j, ++num_fields )
+        {
+            file_print_fmt( fp, "    { %u, %u, offsetof(%s, %s) },\n", layout.field_name[ num_fields ],
+                            layout.field_ref[ num_fields ], type->name, type->struct_info.fields[ j ].name );
+        }
+    }
+    file_print_fmt( fp, "%s};\n", num_fields ? "" : "    { 0 }\n" );
+    for ( int i = 0; i < data->num_types; ++i ) { print_base_assert( fp, &data->types[ i ] ); }
+
+    // Enum values.
+    int32_t num_values = 0;
+    file_print_fmt( fp, "static const cf_packed_value_t cf_%s_values[] = {\n", module_name );
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind != PARSED_KIND_ENUM )
+        {
+            continue;
+        }
+        for ( int j = 0; j < type->enum_info.num_values; ++j, ++num_values )
+        {
+            file_print_fmt( fp, "    { %u, %d },\n", layout.value_name[ num_values ],
+                            type->enum_info.values[ j ].value );
+        }
+    }
+    file_print_fmt( fp, "%s};\n", num_values ? "" : "    { 0 }\n" );
+
+    // Name hashes, which replace the names in stripped builds.
+    if ( options->strip_names )
+    {
+        print_packed_name_hashes( fp, module_name, data, PARSED_KIND_STRUCT, "field_hashes" );
+        print_packed_name_hashes( fp, module_name, data, PARSED_KIND_ENUM, "value_hashes" );
+    }
+    file_print_fmt( fp, "\n" );
+
+    // Enum codecs.
+    int32_t num_enums = 0;
+    int32_t first     = 0;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        const parsed_type_t* type = &data->types[ i ];
+        if ( type->kind == PARSED_KIND_ENUM )
+        {
+            generate_packed_enum_codecs( fp, module_name, type, options->strip_names, layout.type_lookup[ i ],
+                                         first );
+            first += type->enum_info.num_values;
+            num_enums++;
+        }
+    }
+    if ( num_enums > 0 )
+    {
+        file_print_fmt( fp, "static const cf_packed_codec_t cf_%s_codecs[] = {\n", module_name );
+        for ( int i = 0; i < data->num_types; ++i )
+        {
+            if ( data->types[ i ].kind == PARSED_KIND_ENUM )
+            {
+                file_print_fmt( fp, "    { cf_%s_%s_index_of_name, cf_%s_%s_index_of_value },\n", module_name,
+                                data->types[ i ].name, module_name, data->types[ i ].name );
+            }
+        }
+        file_print_fmt( fp, "};\n\n" );
+    }
+
+    // Types: kind, prim, align, size, first, count, name, lookup, id.
+    int32_t num_types = 0;
+    file_print_fmt( fp, "static const cf_packed_type_t cf_%s_types[] = {\n", module_name );
+    int32_t field_first = 0;
+    int32_t value_first = 0;
+    for ( int i = 0; i < data->num_types; ++i, ++num_types )
+    {
+        const parsed_type_t* type    = &data->types[ i ];
+        bool                 is_enum = type->kind == PARSED_KIND_ENUM;
+        int32_t              count   = is_enum ? type->enum_info.num_values : type->struct_info.num_fields;
+        int32_t              start   = is_enum ? value_first : field_first;
+        char                 lookup[ 16 ];
+        if ( layout.type_lookup[ num_types ] == PACKED_NONE )
+        {
+            str_copy( lookup, "CF_PACKED_NONE", sizeof( lookup ) );
+        }
+        else
+        {
+            str_print_fmt( lookup, sizeof( lookup ), "%u", layout.type_lookup[ num_types ] );
+        }
+
+        bool has_base = !is_enum && count > 0 && type->struct_info.fields[ 0 ].is_base;
+        file_print_fmt( fp, "    { %s, %s, _Alignof(%s), sizeof(%s), %d, %d, %u, %s, CF_TYPE_ID_%s },\n",
+                        is_enum ? "CF_KIND_ENUM" : "CF_KIND_STRUCT", has_base ? "CF_PACKED_HAS_BASE" : "0",
+                        type->name, type->name, start, count, layout.type_name[ num_types ], lookup,
+                        type->name );
+
+        if ( is_enum )
+            value_first += count;
+        else
+            field_first += count;
+    }
+    file_print_fmt( fp, "%s};\n\n", num_types ? "" : "    { 0 }\n" );
+
+    // Generated functions, by type index. Left out when no struct has any.
+    bool has_funcs = false;
+    for ( int i = 0; i < data->num_types; ++i )
+    {
+        has_funcs = has_funcs || wants_codegen( options, &data->types[ i ] );
+    }
+    if ( has_funcs )
+    {
+        file_print_fmt( fp, "static const cf_struct_funcs_t* const cf_%s_funcs[] = {\n", module_name );
+        for ( int i = 0; i < data->num_types; ++i )
+        {
+            if ( wants_codegen( options, &data->types[ i ] ) )
+            {
+                file_print_fmt( fp, "    &cf_%s_%s_funcs,\n", module_name, data->types[ i ].name );
+            }
+            else
+            {
+                file_print_fmt( fp, "    NULL,\n" );
+            }
+        }
+        file_print_fmt( fp, "};\n\n" );
+    }
+
+    file_print_fmt( fp, "static const cf_packed_module_t cf_%s_module = {\n", module_name );
+    file_print_fmt(
+        fp, "    cf_%s_strings, cf_%s_lookup, cf_%s_types, cf_%s_fields, cf_%s_values, cf_%s_refs, %s%s%s,\n",
+        module_name, module_name, module_name, module_name, module_name, module_name,
+        num_enums ? "cf_" : "NULL", num_enums ? module_name : "", num_enums ? "_codecs" : "" );
+    file_print_fmt( fp, "    %d, %d, %d", num_types, num_fields, num_values );
+    if ( options->strip_names )
+    {
+        file_print_fmt( fp, ",\n    cf_%s_field_hashes, cf_%s_value_hashes", module_name, module_name );
+    }
+    else
+    {
+        file_print_fmt( fp, ",\n    NULL, NULL" );
+    }
+    if ( has_funcs )
+    {
+        file_print_fmt( fp, ",\n    cf_%s_funcs", module_name );
+    }
+    else
+    {
+        file_print_fmt( fp, ",\n    NULL" );
+    }
+    file_print_fmt( fp, "\n" );
+    file_print_fmt( fp, "};\n\n" );
+
+    if ( options->linker_sections && num_types > 0 )
+    {
+        file_print_fmt( fp, "static const cf_module_t cf_module_%s = { .packed = &cf_%s_module };\n",
+                        module_name, module_name );
+        file_print_fmt( fp,
+                        "CF_MODULE_SECTION const cf_module_t* const cf_module_entry_%s = &cf_module_%s;\n\n",
+                        module_name, module_name );
+    }
+
+    file_print_fmt( fp, "void %s_register_types(void) {\n", module_name );
+    file_print_fmt( fp, "    cf_register_packed_module(&cf_%s_module);\n", module_name );
+    file_print_fmt( fp, "}\n\n" );
+    file_print_fmt( fp, "void %s_unregister_types(void) {\n", module_name );
+    file_print_fmt( fp, "    cf_unregister_packed_module(&cf_%s_module);\n", module_name );
+    file_print_fmt( fp, "}\n" );
+
+    mem_free( layout.strings );
+    return true;
+}
+
+/*============================================================================================*/
@@ -5,7 +5,7 @@
     This file contains the core logic for parsing C header files to extract
     reflection data. The parser is a simple, hand-written recursive descent
     parser. It operates on a single file's content loaded into a memory buffer.
-    It is not a full C parser; it only looks for specific patterns (`CF_STRUCT()`,
+    It is not a full C parser; it only looks for specific patterns (`CF_STRUCT( ... )`,
     `CF_ENUM()`) and parses the `typedef struct` and `typedef enum` that follow.
 
 ==============================================================================================*/
@@ -61,7 +61,7 @@ parse_header_file( const char* filepath, parsed_data_t* data )
             // Hard coded branch less comparison.
             bool is_struct = suffix[ 0 ] == 'S' && suffix[ 1 ] == 'T' && suffix[ 2 ] == 'R' &&
                              suffix[ 3 ] == 'U' && suffix[ 4 ] == 'C' && suffix[ 5 ] == 'T' &&
-                             suffix[ 6 ] == '(' && suffix[ 7 ] == ')';
+                             suffix[ 6 ] == '(';
 
             bool is_enum = suffix[ 0 ] == 'E' && suffix[ 1 ] == 'N' && suffix[ 2 ] == 'U' &&
                            suffix[ 3 ] == 'M' && suffix[ 4 ] == '(' && suffix[ 5 ] == ')';
@@ -77,7 +77,8 @@ parse_header_file( const char* filepath, parsed_data_t* data )
                 continue;
             }
 
-            int32_t advance = is_struct ? 8 : 6;    // length of "STRUCT()" or "ENUM()"
+            // Length of "STRUCT(" or "ENUM()"; parse_struct() reads the annotation argument.
+            int32_t advance = is_struct ? 7 : 6;
             cursor          = parser( suffix + advance, data );
             if ( !cursor )
             {
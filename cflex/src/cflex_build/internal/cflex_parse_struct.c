@@ -4,8 +4,10 @@
 
 ==============================================================================================*/
 
+// Parses a field following its CF_FIELD( ... ) annotation. `args` holds the annotation
+// argument, empty or "base".
 static const char*
-parse_field( const char* cursor, parsed_type_t* type )
+parse_field( const char* cursor, const char* args, parsed_type_t* type )
 {
     if ( type->struct_info.num_fields >= MAX_FIELDS )
     {
@@ -14,6 +16,17 @@ parse_field( const char* cursor, parsed_type_t* type )
     }
 
     parsed_field_t* field = &type->struct_info.fields[ type->struct_info.num_fields ];
+    field->is_base        = str_cmp( args, "base" ) == 0;
+    if ( !field->is_base && str_len( args ) > 0 )
+    {
+        print_fmt( "Parse error: unknown CF_FIELD argument '%s'\n", args );
+        return NULL;
+    }
+    if ( field->is_base && type->struct_info.num_fields > 0 )
+    {
+        print_fmt( "Parse error: CF_FIELD( base ) must annotate the first field\n" );
+        return NULL;
+    }
 
     cursor                = str_left_trim( cursor );
     cursor                = read_identifier( cursor, field->type_name, MAX_NAME_LENGTH );
@@ -32,10 +45,24 @@ parse_field( const char* cursor, parsed_type_t* type )
 
 /*============================================================================================*/
 
+// Parses a struct following `CF_STRUCT(`. The annotation argument is empty or "codegen".
 static const char*
 parse_struct( const char* cursor, parsed_data_t* data )
 {
-    bool is_typedef           = false;
+    bool is_typedef = false;
+
+    char args[ MAX_NAME_LENGTH ];
+    cursor = read_identifier( cursor, args, sizeof( args ) );
+    cursor = expect_char( cursor, ')' );
+    if ( !cursor )
+        return NULL;
+
+    bool codegen = str_cmp( args, "codegen" ) == 0;
+    if ( !codegen && str_len( args ) > 0 )
+    {
+        print_fmt( "Parse error: unknown CF_STRUCT argument '%s'\n", args );
+        return NULL;
+    }
 
     cursor                    = str_left_trim( cursor );
     const char* after_typedef = optional_keyword( cursor, "typedef" );
@@ -79,6 +106,7 @@ parse_struct( const char* cursor, parsed_data_t* data )
     parsed_type_t* type          = &data->types[ data->num_types ];
     type->kind                   = PARSED_KIND_STRUCT;
     type->struct_info.num_fields = 0;
+    type->struct_info.codegen    = codegen;
 
     // Parse CF_FIELD() inside body
     while ( cursor < body_end )
@@ -87,14 +115,19 @@ parse_struct( const char* cursor, parsed_data_t* data )
         if ( !marker )
             break;
 
-        if ( str_ncmp( marker, "CF_FIELD()", 10 ) != 0 )
+        if ( str_ncmp( marker, "CF_FIELD(", 9 ) != 0 )
         {
             cursor = marker + 1;
             continue;
         }
 
-        cursor = marker + 10;
-        cursor = parse_field( cursor, type );
+        char args[ MAX_NAME_LENGTH ];
+        cursor = read_identifier( marker + 9, args, sizeof( args ) );
+        cursor = expect_char( cursor, ')' );
+        if ( !cursor )
+            return NULL;
+
+        cursor = parse_field( cursor, args, type );
         if ( !cursor )
             return NULL;
     }
@@ -146,8 +179,9 @@ parse_struct( const char* cursor, parsed_data_t* data )
         print_fmt( "Parsed Struct '%s' with %d fields\n", type->name, type->struct_info.num_fields );
         for ( int i = 0; i < type->struct_info.num_fields; i++ )
         {
-            print_fmt( "  - Field: %s %s\n", type->struct_info.fields[ i ].type_name,
-                       type->struct_info.fields[ i ].name );
+            print_fmt( "  - Field: %s %s%s\n", type->struct_info.fields[ i ].type_name,
+                       type->struct_info.fields[ i ].name,
+                       type->struct_info.fields[ i ].is_base ? " (base)" : "" );
         }
     }
 
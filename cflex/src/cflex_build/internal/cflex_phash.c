@@ -0,0 +1,125 @@
+/*==============================================================================================
+
+    Perfect Hash
+
+    Builds minimal perfect hash tables over small sets of names (struct fields,
+    enum values). The runtime evaluates them with cf_phash_bucket() and
+    cf_phash_slot() from cflex_hash.h, so both sides always agree.
+
+    Keys are grouped into buckets by a mix of their hash. Buckets are
+    placed largest first; for each bucket we search for a seed that sends all of
+    its keys to free slots. Every slot ends up holding exactly one key, so a
+    lookup is one hash, one table probe and one string compare.
+
+==============================================================================================*/
+
+#define PHASH_MAX_SEED 0xffff
+
+/*============================================================================================*/
+
+// Tries to place every key of a bucket with the given seed.
+// On success the keys are written into `slots` and true is returned.
+
+static bool
+phash_try_seed( const uint64_t* hashes,
+                const int32_t*  keys,
+                int32_t         num_keys,
+                uint32_t        seed,
+                int32_t         count,
+                int32_t*        slots )
+{
+    uint32_t placed[ PHASH_MAX_KEYS ];
+
+    for ( int32_t i = 0; i < num_keys; ++i )
+    {
+        uint32_t slot = cf_phash_slot( hashes[ keys[ i ] ], seed, (uint32_t)count );
+        if ( slots[ slot ] >= 0 )
+        {
+            return false;
+        }
+        for ( int32_t j = 0; j < i; ++j )
+        {
+            if ( placed[ j ] == slot )
+            {
+                return false;
+            }
+        }
+        placed[ i ] = slot;
+    }
+
+    for ( int32_t i = 0; i < num_keys; ++i ) { slots[ placed[ i ] ] = keys[ i ]; }
+    return true;
+}
+
+/*============================================================================================*/
+
+// Builds a minimal perfect hash over `count` name hashes.
+// Returns false if no table could be built (e.g. two names share a 64-bit hash),
+// in which case the caller should emit no table and the runtime falls back to a scan.
+
+static bool
+phash_build( const uint64_t* hashes, int32_t count, phash_t* out )
+{
+    if ( count <= 0 || count > PHASH_MAX_KEYS )
+    {
+        return false;
+    }
+
+    uint32_t num_buckets = cf_phash_num_buckets( (uint32_t)count );
+    uint32_t bucket_mask = num_buckets - 1;
+
+    // Group the keys by bucket. The key lists are static to keep them off the stack.
+    static int32_t bucket_keys[ PHASH_MAX_KEYS ][ PHASH_MAX_KEYS ];
+    int32_t        bucket_size[ PHASH_MAX_KEYS ] = { 0 };
+    for ( int32_t i = 0; i < count; ++i )
+    {
+        uint32_t bucket                                  = cf_phash_bucket( hashes[ i ], bucket_mask );
+        bucket_keys[ bucket ][ bucket_size[ bucket ]++ ] = i;
+    }
+
+    // Place buckets largest first (selection order; the sets are small).
+    int32_t order[ PHASH_MAX_KEYS ];
+    for ( uint32_t i = 0; i < num_buckets; ++i ) { order[ i ] = (int32_t)i; }
+    for ( uint32_t i = 0; i < num_buckets; ++i )
+    {
+        for ( uint32_t j = i + 1; j < num_buckets; ++j )
+        {
+            if ( bucket_size[ order[ j ] ] > bucket_size[ order[ i ] ] )
+            {
+                int32_t tmp = order[ i ];
+                order[ i ]  = order[ j ];
+                order[ j ]  = tmp;
+            }
+        }
+    }
+
+    int32_t slots[ PHASH_MAX_KEYS ];
+    for ( int32_t i = 0; i < count; ++i ) { slots[ i ] = -1; }
+
+    for ( uint32_t i = 0; i < num_buckets; ++i )
+    {
+        int32_t bucket       = order[ i ];
+        out->seeds[ bucket ] = 0;
+        if ( bucket_size[ bucket ] == 0 )
+        {
+            continue;
+        }
+
+        uint32_t seed = 0;
+        while ( !phash_try_seed( hashes, bucket_keys[ bucket ], bucket_size[ bucket ], seed, count, slots ) )
+        {
+            if ( ++seed > PHASH_MAX_SEED )
+            {
+                return false;
+            }
+        }
+        out->seeds[ bucket ] = (uint16_t)seed;
+    }
+
+    for ( int32_t i = 0; i < count; ++i ) { out->slots[ i ] = (uint16_t)slots[ i ]; }
+    out->num_buckets = (int32_t)num_buckets;
+    out->num_keys    = count;
+    return true;
+}
+
+/*============================================================================================*/
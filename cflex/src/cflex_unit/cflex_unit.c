@@ -1,8 +1,12 @@
 #include "cflex_unit_types.h"
 #include "cflex.h"
 #include "cflex_unit_generated.h"
+#include "internal/cflex_internal.h"
 
+#include <locale.h>
+#include <stddef.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 // --- Minimal Test Framework ---
@@ -33,6 +37,10 @@
 
 // --- Test Cases ---
 
+#if defined( CFLEX_EMIT_CPP )
+int test_cpp_bindings( void );    // cflex_unit_cpp.cpp
+#endif
+
 int
 test_find_type_by_name()
 {
@@ -47,6 +55,54 @@ test_find_type_by_name()
     return 0;
 }
 
+int
+test_find_type_by_name_n()
+{
+    // Names are looked up straight out of a larger buffer.
+    const char* buffer                = "test_struct_t.a int32_t";
+
+    const cf_type_t* test_struct_type = cf_find_type_by_name_n( buffer, 13 );
+    TEST_ASSERT( test_struct_type != NULL );
+    TEST_ASSERT( test_struct_type == cf_find_type_by_name( "test_struct_t" ) );
+
+    const cf_type_t* int_type = cf_find_type_by_name_n( buffer + 16, 7 );
+    TEST_ASSERT( int_type != NULL );
+    TEST_ASSERT( strcmp( int_type->name, "int32_t" ) == 0 );
+
+    // A prefix of a registered name must not match.
+    TEST_ASSERT( cf_find_type_by_name_n( buffer, 5 ) == NULL );
+    TEST_ASSERT( cf_find_type_by_name_n( buffer, 0 ) == NULL );
+
+    return 0;
+}
+
+int
+test_type_ids()
+{
+    const cf_type_t* test_struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( test_struct_type != NULL );
+    TEST_ASSERT( test_struct_type->id == CF_TYPE_ID_test_struct_t );
+    TEST_ASSERT( test_struct_type->id == cf_hash_name( "test_struct_t" ) );
+    TEST_ASSERT( cf_find_type_by_id( CF_TYPE_ID_test_struct_t ) == test_struct_type );
+    TEST_ASSERT( cf_find_type_by_id( CF_TYPE_ID_i32 ) == cf_find_type_by_name( "int32_t" ) );
+    TEST_ASSERT( cf_find_type_by_id( cf_hash_name( "non_existent_type" ) ) == NULL );
+
+    // Dense indices cover every registered type exactly once.
+    int32_t num_types = cf_get_num_types();
+    TEST_ASSERT( num_types > 0 );
+    for ( int32_t i = 0; i < num_types; ++i )
+    {
+        const cf_type_t* type = cf_get_type_by_index( i );
+        TEST_ASSERT( type != NULL );
+        TEST_ASSERT( type->state != NULL );
+        TEST_ASSERT( type->state->index == i );
+    }
+    TEST_ASSERT( cf_get_type_by_index( num_types ) == NULL );
+    TEST_ASSERT( cf_get_type_by_index( -1 ) == NULL );
+
+    return 0;
+}
+
 int
 test_table_api()
 {
@@ -78,6 +134,33 @@ test_find_field()
     return 0;
 }
 
+int
+test_find_field_all()
+{
+    // Every field of every registered struct must be found through its lookup table.
+    int32_t num_tables = cf_get_num_tables();
+    for ( int32_t t = 0; t < num_tables; ++t )
+    {
+        const cf_type_t** types;
+        int32_t           count;
+        cf_get_table( t, &types, &count );
+        for ( int32_t i = 0; i < count; ++i )
+        {
+            const cf_type_t* type = types[ i ];
+            if ( type->kind != CF_KIND_STRUCT )
+                continue;
+
+            TEST_ASSERT( type->struct_phash.seeds != NULL );
+            for ( int32_t j = 0; j < type->struct_count; ++j )
+            {
+                const cf_field_t* field = &type->struct_array[ j ];
+                TEST_ASSERT( cf_find_field( type, field->name ) == field );
+            }
+        }
+    }
+    return 0;
+}
+
 int
 test_find_enum_value()
 {
@@ -96,17 +179,1257 @@ test_find_enum_value()
     return 0;
 }
 
+int
+test_find_enum_value_by_value()
+{
+    // Dense enum with a hole and an alias.
+    const cf_type_t* holes_type = cf_find_type_by_name( "test_holes_t" );
+    TEST_ASSERT( holes_type != NULL );
+    TEST_ASSERT( holes_type->enum_by_value != NULL );
+
+    const cf_enum_value_t* val_c = cf_find_enum_value_by_value( holes_type, 2 );
+    TEST_ASSERT( val_c != NULL );
+    TEST_ASSERT( strcmp( val_c->name, "TEST_HOLES_C" ) == 0 );
+    TEST_ASSERT( cf_find_enum_value_by_value( holes_type, 1 ) == NULL );
+    TEST_ASSERT( cf_find_enum_value_by_value( holes_type, -1 ) == NULL );
+    TEST_ASSERT( cf_find_enum_value_by_value( holes_type, 4 ) == NULL );
+
+    TEST_ASSERT( cf_enum_is_valid( holes_type, 0 ) );
+    TEST_ASSERT( !cf_enum_is_valid( holes_type, 1 ) );
+    TEST_ASSERT( cf_enum_is_valid( holes_type, 3 ) );
+    TEST_ASSERT( !cf_enum_is_valid( holes_type, INT32_MIN ) );
+    TEST_ASSERT( !cf_enum_is_valid( holes_type, INT32_MAX ) );
+
+    // Sparse enum.
+    const cf_type_t* sparse_type = cf_find_type_by_name( "test_sparse_t" );
+    TEST_ASSERT( sparse_type != NULL );
+    TEST_ASSERT( sparse_type->enum_by_value == NULL );
+    TEST_ASSERT( sparse_type->enum_sorted != NULL );
+
+    const cf_enum_value_t* val_neg = cf_find_enum_value_by_value( sparse_type, -100 );
+    TEST_ASSERT( val_neg != NULL );
+    TEST_ASSERT( strcmp( val_neg->name, "TEST_SPARSE_NEG" ) == 0 );
+    TEST_ASSERT( cf_find_enum_value_by_value( sparse_type, 100000 ) != NULL );
+    TEST_ASSERT( cf_find_enum_value_by_value( sparse_type, 0 ) == NULL );
+
+    TEST_ASSERT( cf_enum_is_valid( sparse_type, 1 ) );
+    TEST_ASSERT( !cf_enum_is_valid( sparse_type, 2 ) );
+
+    return 0;
+}
+
+int
+test_enum_codecs()
+{
+    // Generated typed codecs.
+    test_enum_t value = TEST_ENUM_A;
+    TEST_ASSERT( test_enum_t_from_string( "TEST_ENUM_C", &value ) );
+    TEST_ASSERT( value == TEST_ENUM_C );
+    TEST_ASSERT( !test_enum_t_from_string( "TEST_ENUM_D", &value ) );
+    TEST_ASSERT( !test_enum_t_from_string( "TEST_ENUM_", &value ) );
+    TEST_ASSERT( value == TEST_ENUM_C );
+
+    TEST_ASSERT( strcmp( test_enum_t_to_string( TEST_ENUM_B ), "TEST_ENUM_B" ) == 0 );
+    TEST_ASSERT( test_enum_t_to_string( (test_enum_t)42 ) == NULL );
+
+    // Aliases: both names parse, the value prints as the first declared name.
+    test_holes_t holes = TEST_HOLES_A;
+    TEST_ASSERT( test_holes_t_from_string( "TEST_HOLES_ALIAS", &holes ) );
+    TEST_ASSERT( holes == TEST_HOLES_C );
+    TEST_ASSERT( strcmp( test_holes_t_to_string( TEST_HOLES_ALIAS ), "TEST_HOLES_C" ) == 0 );
+
+    // The generic lookups reach the same codecs through cf_type_t.
+    const cf_type_t* sparse_type = cf_find_type_by_name( "test_sparse_t" );
+    TEST_ASSERT( sparse_type != NULL );
+    TEST_ASSERT( sparse_type->enum_index_of_name != NULL );
+
+    const char*            buffer  = "TEST_SPARSE_BIG,TEST_SPARSE_ONE";
+    const cf_enum_value_t* val_big = cf_find_enum_value_by_name_n( sparse_type, buffer, 15 );
+    TEST_ASSERT( val_big != NULL );
+    TEST_ASSERT( val_big->value == 100000 );
+    TEST_ASSERT( cf_find_enum_value_by_name_n( sparse_type, buffer, 12 ) == NULL );
+    TEST_ASSERT( cf_find_enum_value_by_name( sparse_type, "TEST_SPARSE_NEG" )->value == -100 );
+
+    return 0;
+}
+
+int
+test_unregister()
+{
+    const cf_type_t* vec_type = cf_find_type_by_name( "test_vec2_t" );
+    TEST_ASSERT( vec_type != NULL );
+    int32_t num_tables = cf_get_num_tables();
+
+    // More tables than the registry used to hold; each lists a type that is already known.
+    static const cf_type_t* extra_tables[ 24 ][ 1 ];
+    for ( int32_t i = 0; i < 24; ++i )
+    {
+        extra_tables[ i ][ 0 ] = vec_type;
+        cf_register_type_table( extra_tables[ i ], 1 );
+    }
+    cf_register_type_table( extra_tables[ 0 ], 1 );    // Ignored, already registered
+    TEST_ASSERT( cf_get_num_tables() == num_tables + 24 );
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == vec_type );
+
+    // Removing the generated module leaves its types reachable through the extra tables only.
+    cflex_unit_unregister_types();
+    TEST_ASSERT( cf_get_num_tables() == num_tables + 23 );
+    TEST_ASSERT( cf_find_type_by_name( "test_struct_t" ) == NULL );
+    TEST_ASSERT( cf_find_type_by_id( CF_TYPE_ID_test_struct_t ) == NULL );
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == vec_type );
+    TEST_ASSERT( cf_get_type_by_index( vec_type->state->index ) == vec_type );
+
+    for ( int32_t i = 0; i < 24; ++i ) { cf_unregister_type_table( extra_tables[ i ] ); }
+    TEST_ASSERT( cf_get_num_tables() == num_tables - 1 );    // The runtime's primitive table remains
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == NULL );
+    TEST_ASSERT( vec_type->state->index == -1 );
+
+    // Registering again makes every type reachable with a fresh dense index.
+    cflex_unit_register_types();
+    const cf_type_t* test_struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( test_struct_type != NULL );
+    TEST_ASSERT( cf_get_type_by_index( test_struct_type->state->index ) == test_struct_type );
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == vec_type );
+    TEST_ASSERT( vec_type->state->index >= 0 );
+
+    // The module's indices are reused when it comes back behind a later table, so the
+    // dense arrays do not grow with every cycle.
+    static cf_type_state_t  tail_state   = { .index = -1 };
+    static const cf_type_t  tail_type    = { .name  = "test_tail_t",
+                                             .kind  = CF_KIND_STRUCT,
+                                             .state = &tail_state };
+    static const cf_type_t* tail_table[] = { &tail_type };
+    cf_register_type_table( tail_table, 1 );
+    int32_t num_types = cf_get_num_types();
+    TEST_ASSERT( tail_state.index == num_types - 1 );
+    for ( int32_t i = 0; i < 3; ++i )
+    {
+        cflex_unit_unregister_types();
+        cflex_unit_register_types();
+        TEST_ASSERT( cf_get_num_types() == num_types );
+        TEST_ASSERT( cf_get_type_by_index( vec_type->state->index ) == vec_type );
+    }
+    cf_unregister_type_table( tail_table );
+    TEST_ASSERT( cf_get_num_types() == num_types - 1 );
+
+    return 0;
+}
+
+int
+test_shared_types()
+{
+    // The primitives are the runtime's, whichever module refers to them.
+    TEST_ASSERT( cf_find_type_by_name( "int32_t" ) == &cf_type_i32 );
+    TEST_ASSERT( cf_find_type_by_id( CF_TYPE_ID_cstr ) == &cf_type_cstr );
+    TEST_ASSERT( cf_type_f32.id == cf_hash_name( "float" ) );
+
+    const cf_type_t* test_struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( test_struct_type != NULL );
+    TEST_ASSERT( cf_find_field( test_struct_type, "a" )->type == &cf_type_i32 );
+#if !defined( CFLEX_PACKED )
+    // Generated types are exported for other modules' field tables.
+    TEST_ASSERT( test_struct_type == &cf_type_test_struct_t );
+    TEST_ASSERT( cf_find_field( test_struct_type, "v" )->type == &cf_type_test_vec2_t );
+#endif
+
+    // Another module's copy of a registered type is deduplicated by ID.
+    static cf_type_state_t  copy_state   = { .index = -1 };
+    static const cf_type_t  vec_copy     = { .name  = "test_vec2_t",
+                                             .kind  = CF_KIND_STRUCT,
+                                             .id    = CF_TYPE_ID_test_vec2_t,
+                                             .state = &copy_state };
+    static const cf_type_t* copy_table[] = { &vec_copy };
+    const cf_type_t*        vec_type     = cf_find_type_by_name( "test_vec2_t" );
+    int32_t                 num_types    = cf_get_num_types();
+
+    cf_register_type_table( copy_table, 1 );
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == vec_type );
+    TEST_ASSERT( cf_get_num_types() == num_types );
+    TEST_ASSERT( copy_state.index == cf_get_type_index( vec_type ) );
+    cf_unregister_type_table( copy_table );
+    TEST_ASSERT( cf_find_type_by_name( "test_vec2_t" ) == vec_type );
+    TEST_ASSERT( copy_state.index == -1 );
+    TEST_ASSERT( cf_get_type_index( vec_type ) >= 0 );
+
+    return 0;
+}
+
+// Counts the types an iteration visits and checks whether `expected` is one of them.
+static int32_t
+count_iter( cf_type_iter_t* it, const cf_type_t* expected, bool* out_found )
+{
+    int32_t count = 0;
+    *out_found    = false;
+    for ( const cf_type_t* type; ( type = cf_iter_next( it ) ); count++ ) { *out_found |= type == expected; }
+    return count;
+}
+
+int
+test_type_relations()
+{
+    const cf_type_t* vec_type    = cf_find_type_by_name( "test_vec2_t" );
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    const cf_type_t* enum_type   = cf_find_type_by_name( "test_enum_t" );
+    TEST_ASSERT( vec_type && struct_type && enum_type );
+
+    cf_type_iter_t it;
+    bool           found;
+    cf_iter_types_by_kind( &it, CF_KIND_PRIMITIVE );
+    TEST_ASSERT( count_iter( &it, &cf_type_i32, &found ) == 14 && found );
+    cf_iter_types_by_kind( &it, CF_KIND_ENUM );
+    TEST_ASSERT( count_iter( &it, enum_type, &found ) == 3 && found );
+    cf_iter_types_by_kind( &it, CF_KIND_COUNT );
+    TEST_ASSERT( cf_iter_next( &it ) == NULL );
+
+    // float is held by test_vec2_t and test_derived_t, and through them by test_struct_t,
+    // test_leaf_t and test_message_t.
+    cf_iter_containers( &it, cf_find_type_by_name( "float" ) );
+    TEST_ASSERT( count_iter( &it, struct_type, &found ) == 5 && found );
+    cf_iter_containers( &it, enum_type );
+    TEST_ASSERT( count_iter( &it, struct_type, &found ) == 3 && found );
+    cf_iter_containers( &it, struct_type );
+    TEST_ASSERT( cf_iter_next( &it ) == NULL );
+
+    // A struct from another table, two levels above test_vec2_t.
+    static cf_field_t       outer_fields[] = { { "inner", NULL, 0, 0, 0 }, { "more", NULL, 0, 0, 0 } };
+    static cf_type_state_t  outer_state    = { .index = -1 };
+    static const cf_type_t  outer_type     = { .name         = "test_outer_t",
+                                               .kind         = CF_KIND_STRUCT,
+                                               .state        = &outer_state,
+                                               .struct_array = outer_fields,
+                                               .struct_count = 2 };
+    static const cf_type_t* outer_table[]  = { &outer_type };
+    outer_fields[ 0 ].type                 = struct_type;
+    outer_fields[ 1 ].type                 = struct_type;
+
+    // test_vec2_t is held by test_struct_t and test_message_t.
+    cf_register_type_table( outer_table, 1 );
+    cf_iter_containers( &it, vec_type );
+    TEST_ASSERT( count_iter( &it, &outer_type, &found ) == 3 && found );
+
+    // An iteration that stops early must be ended before the registry can reclaim memory.
+    cf_iter_types_by_kind( &it, CF_KIND_STRUCT );
+    TEST_ASSERT( cf_iter_next( &it ) != NULL );
+    cf_iter_end( &it );
+    cf_iter_end( &it );
+
+    cf_unregister_type_table( outer_table );
+    cf_iter_containers( &it, vec_type );
+    TEST_ASSERT( count_iter( &it, &outer_type, &found ) == 2 && !found );
+
+    return 0;
+}
+
+int
+test_inheritance()
+{
+    const cf_type_t* base_type    = cf_find_type_by_name( "test_base_t" );
+    const cf_type_t* derived_type = cf_find_type_by_name( "test_derived_t" );
+    const cf_type_t* leaf_type    = cf_find_type_by_name( "test_leaf_t" );
+    const cf_type_t* vec_type     = cf_find_type_by_name( "test_vec2_t" );
+    TEST_ASSERT( base_type && derived_type && leaf_type && vec_type );
+
+    TEST_ASSERT( base_type->struct_parent == NULL );
+    TEST_ASSERT( derived_type->struct_parent == base_type );
+    TEST_ASSERT( leaf_type->struct_parent == derived_type );
+    TEST_ASSERT( cf_find_field( leaf_type, "base" )->flags & CF_FIELD_BASE );
+    TEST_ASSERT( !( cf_find_field( leaf_type, "mode" )->flags & CF_FIELD_BASE ) );
+
+    TEST_ASSERT( cf_get_type_index( leaf_type ) == leaf_type->state->index );
+    TEST_ASSERT( cf_type_is_a( leaf_type, base_type ) );
+    TEST_ASSERT( cf_type_is_a( leaf_type, derived_type ) );
+    TEST_ASSERT( cf_type_is_a( base_type, base_type ) );
+    TEST_ASSERT( !cf_type_is_a( base_type, leaf_type ) );
+    TEST_ASSERT( !cf_type_is_a( vec_type, base_type ) );
+    TEST_ASSERT( !cf_type_is_a( leaf_type, vec_type ) );
+    TEST_ASSERT( !cf_type_is_a( NULL, base_type ) );
+
+    // A subtype from another table is numbered when registered; before that, and after it
+    // is unregistered, the check walks its parent chain.
+    static cf_field_t       sub_fields[] = { { "base", NULL, 0, CF_FIELD_BASE, 0 } };
+    static cf_type_state_t  sub_state    = { .index = -1 };
+    static cf_type_t        sub_type     = { .name         = "test_sub_t",
+                                             .kind         = CF_KIND_STRUCT,
+                                             .state        = &sub_state,
+                                             .struct_array = sub_fields,
+                                             .struct_count = 1 };
+    static const cf_type_t* sub_table[]  = { &sub_type };
+    sub_fields[ 0 ].type                 = leaf_type;
+    sub_type.struct_parent               = leaf_type;
+
+    TEST_ASSERT( cf_type_is_a( &sub_type, base_type ) );
+    cf_register_type_table( sub_table, 1 );
+    TEST_ASSERT( cf_get_type_index( &sub_type ) >= 0 && sub_state.interval != 0 );
+    TEST_ASSERT( cf_type_is_a( &sub_type, derived_type ) );
+    TEST_ASSERT( !cf_type_is_a( derived_type, &sub_type ) );
+    TEST_ASSERT( cf_type_is_a( leaf_type, base_type ) );
+    cf_unregister_type_table( sub_table );
+    TEST_ASSERT( cf_get_type_index( &sub_type ) == -1 && sub_state.interval == 0 );
+    TEST_ASSERT( cf_type_is_a( &sub_type, base_type ) );
+
+    return 0;
+}
+
+int
+test_leaves()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    const cf_type_t* leaf_type   = cf_find_type_by_name( "test_leaf_t" );
+    TEST_ASSERT( struct_type && leaf_type );
+
+    int32_t          count;
+    const cf_leaf_t* leaves = cf_get_leaves( struct_type, &count );
+    TEST_ASSERT( leaves != NULL && count == 4 );
+    TEST_ASSERT( leaves[ 0 ].offset == (int32_t)offsetof( test_struct_t, a ) &&
+                 leaves[ 0 ].prim == CF_PRIM_I32 );
+    TEST_ASSERT( leaves[ 1 ].offset == (int32_t)offsetof( test_struct_t, v.x ) &&
+                 leaves[ 1 ].prim == CF_PRIM_F32 );
+    TEST_ASSERT( leaves[ 2 ].offset == (int32_t)offsetof( test_struct_t, v.y ) );
+    TEST_ASSERT( leaves[ 2 ].size == (int32_t)sizeof( float ) );
+    TEST_ASSERT( leaves[ 3 ].offset == (int32_t)offsetof( test_struct_t, e ) );
+    TEST_ASSERT( leaves[ 3 ].type == cf_find_type_by_name( "test_enum_t" ) );
+    TEST_ASSERT( strcmp( leaves[ 0 ].path, "a" ) == 0 );
+    TEST_ASSERT( strcmp( leaves[ 2 ].path, "v.y" ) == 0 );
+    TEST_ASSERT( strcmp( leaves[ 3 ].path, "e" ) == 0 );
+
+    // Built once, then shared.
+    TEST_ASSERT( cf_get_leaves( struct_type, NULL ) == leaves );
+
+    leaves = cf_get_leaves( leaf_type, &count );
+    TEST_ASSERT( leaves != NULL && count == 3 );
+    TEST_ASSERT( strcmp( leaves[ 0 ].path, "base.base.id" ) == 0 );
+    TEST_ASSERT( strcmp( leaves[ 1 ].path, "base.speed" ) == 0 );
+    TEST_ASSERT( leaves[ 1 ].offset == (int32_t)offsetof( test_leaf_t, base.speed ) );
+    TEST_ASSERT( strcmp( leaves[ 2 ].path, "mode" ) == 0 );
+
+    TEST_ASSERT( cf_get_leaves( &cf_type_i32, &count ) == NULL && count == 0 );
+    TEST_ASSERT( cf_get_leaves( NULL, &count ) == NULL && count == 0 );
+
+    return 0;
+}
+
+// A module that is unloaded once its table is unregistered. The registry must not touch its
+// state afterwards, not even in cf_shutdown().
+typedef struct test_module_t
+{
+    cf_type_state_t  state;
+    cf_type_t        type;
+    const cf_type_t* table[ 1 ];
+} test_module_t;
+
+static const cf_field_t module_fields[] = { { "x", &cf_type_i32, 0, 0, 0 }, { "y", &cf_type_f32, 4, 0, 0 } };
+
+int
+test_leaves_unregister()
+{
+    test_module_t* module = (test_module_t*)calloc( 1, sizeof( test_module_t ) );
+    TEST_ASSERT( module != NULL );
+    const cf_type_t type = { .name         = "test_module_t",
+                             .kind         = CF_KIND_STRUCT,
+                             .size         = 8,
+                             .align        = 4,
+                             .state        = &module->state,
+                             .struct_array = module_fields,
+                             .struct_count = 2 };
+    memcpy( &module->type, &type, sizeof( type ) );
+    module->state.index = -1;
+    module->table[ 0 ]  = &module->type;
+
+    // Only registered structs cache their leaves.
+    int32_t count;
+    TEST_ASSERT( cf_get_leaves( &module->type, &count ) == NULL && count == 0 );
+    cf_register_type_table( module->table, 1 );
+    TEST_ASSERT( cf_get_leaves( &module->type, &count ) != NULL && count == 2 );
+    TEST_ASSERT( module->state.layout != NULL );
+    cf_unregister_type_table( module->table );
+    TEST_ASSERT( module->state.index == -1 && module->state.layout == NULL );
+    free( module );
+
+    cf_shutdown();
+#if !defined( CFLEX_LINKER_SECTIONS )
+    cflex_unit_register_types();
+#endif
+    return 0;
+}
+
+int
+test_paths()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+
+    cf_path_t path_y = cf_path_compile( struct_type, "v.y" );
+    TEST_ASSERT( path_y.type == &cf_type_f32 );
+    TEST_ASSERT( path_y.offset == (int32_t)offsetof( test_struct_t, v.y ) );
+
+    cf_path_t path_v = cf_path_compile( struct_type, "v" );
+    TEST_ASSERT( path_v.type == cf_find_type_by_name( "test_vec2_t" ) );
+
+    TEST_ASSERT( cf_path_compile( struct_type, "v.z" ).type == NULL );
+    TEST_ASSERT( cf_path_compile( struct_type, "a.x" ).type == NULL );
+    TEST_ASSERT( cf_path_compile( struct_type, "v." ).type == NULL );
+    TEST_ASSERT( cf_path_compile( struct_type, ".v" ).type == NULL );
+    TEST_ASSERT( cf_path_compile( struct_type, "" ).type == NULL );
+    TEST_ASSERT( cf_path_compile( struct_type, NULL ).type == NULL );
+    TEST_ASSERT( cf_path_compile( NULL, "v" ).type == NULL );
+
+    test_struct_t objects[ 3 ] = { { 1, { 1.0f, 2.0f }, TEST_ENUM_A },
+                                   { 2, { 3.0f, 4.0f }, TEST_ENUM_B },
+                                   { 3, { 5.0f, 6.0f }, TEST_ENUM_C } };
+    TEST_ASSERT( cf_path_get_f32( &path_y, &objects[ 1 ] ) == 4.0f );
+    cf_path_set_f32( &path_y, &objects[ 1 ], 8.0f );
+    TEST_ASSERT( objects[ 1 ].v.y == 8.0f );
+
+    float ys[ 3 ];
+    cf_path_gather( &path_y, objects, sizeof( test_struct_t ), 3, ys );
+    TEST_ASSERT( ys[ 0 ] == 2.0f && ys[ 1 ] == 8.0f && ys[ 2 ] == 6.0f );
+
+    test_vec2_t vs[ 3 ] = { { 10.0f, 11.0f }, { 12.0f, 13.0f }, { 14.0f, 15.0f } };
+    cf_path_scatter( &path_v, objects, sizeof( test_struct_t ), 3, vs );
+    TEST_ASSERT( objects[ 2 ].v.x == 14.0f && objects[ 2 ].v.y == 15.0f );
+    TEST_ASSERT( objects[ 2 ].a == 3 && objects[ 2 ].e == TEST_ENUM_C );
+
+    return 0;
+}
+
+int
+test_type_of()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    TEST_ASSERT( CF_TYPE( test_struct_t ) == struct_type );
+    TEST_ASSERT( CF_TYPE( f32 ) == &cf_type_f32 );
+
+    test_struct_t value = { 0 };
+    const char*   name  = "name";
+    TEST_ASSERT( cf_type_of( value ) == struct_type );
+    TEST_ASSERT( cf_type_of( value.v ) == CF_TYPE( test_vec2_t ) );
+    TEST_ASSERT( cf_type_of( value.a ) == &cf_type_i32 );
+    TEST_ASSERT( cf_type_of( value.v.x * 2.0 ) == &cf_type_f64 );
+    TEST_ASSERT( cf_type_of( name ) == &cf_type_cstr );
+    TEST_ASSERT( cflex_unit_type_of( (uint8_t)1 ) == &cf_type_u8 );
+
+    return 0;
+}
+
+int
+test_field_lists()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    TEST_ASSERT( CF_FIELD_COUNT_test_struct_t == struct_type->struct_count );
+    TEST_ASSERT( CF_FIELD_INDEX_test_struct_t_e == 2 );
+
+    // Every generated entry agrees with the runtime descriptor.
+#define CHECK_FIELD( field_name, field_type, field_offset, field_index )                         \
+    TEST_ASSERT( strcmp( struct_type->struct_array[ field_index ].name, #field_name ) == 0 );    \
+    TEST_ASSERT( struct_type->struct_array[ field_index ].offset == (int32_t)( field_offset ) ); \
+    TEST_ASSERT( struct_type->struct_array[ field_index ].type->size == (int32_t)sizeof( field_type ) );
+    CF_FIELDS_test_struct_t( CHECK_FIELD )
+#undef CHECK_FIELD
+
+        // A field-wise compare that the compiler sees in full.
+        test_struct_t a = { 1, { 2.0f, 3.0f }, TEST_ENUM_B };
+    test_struct_t     b = a;
+#define FIELD_EQUAL( field_name, field_type, field_offset, field_index ) \
+    &&memcmp( &a.field_name, &b.field_name, sizeof( field_type ) ) == 0
+    TEST_ASSERT( 1 CF_FIELDS_test_struct_t( FIELD_EQUAL ) );
+    b.v.y = 4.0f;
+    TEST_ASSERT( !( 1 CF_FIELDS_test_struct_t( FIELD_EQUAL ) ) );
+#undef FIELD_EQUAL
+
+    return 0;
+}
+
+int
+test_stats()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    const cf_type_t* enum_type   = cf_find_type_by_name( "test_enum_t" );
+    TEST_ASSERT( struct_type && enum_type );
+
+    cf_stats_reset();
+    cf_find_type_by_name( "test_vec2_t" );
+    cf_find_type_by_name( "missing_t" );
+    cf_find_field( struct_type, "v" );
+    cf_find_field( struct_type, "w" );
+    cf_find_enum_value_by_value( enum_type, TEST_ENUM_B );
+
+    cf_stats_t stats;
+    cf_stats_snapshot( &stats );
+#if defined( CFLEX_STATS )
+    const cf_stat_counters_t* by_name = &stats.lookups[ CF_STAT_TYPE_BY_NAME ];
+    TEST_ASSERT( by_name->calls == 2 && by_name->hits == 1 && by_name->misses == 1 );
+    TEST_ASSERT( by_name->probes >= 2 );
+    const cf_stat_counters_t* field = &stats.lookups[ CF_STAT_FIELD ];
+    TEST_ASSERT( field->calls == 2 && field->hits == 1 && field->misses == 1 && field->probes >= 2 );
+    TEST_ASSERT( stats.lookups[ CF_STAT_ENUM_BY_VALUE ].hits == 1 );
+    TEST_ASSERT( stats.lookups[ CF_STAT_TYPE_BY_ID ].calls == 0 );
+    cf_stats_dump();
+
+    // The first lookup after cf_shutdown() registers the built-in tables again. It counts
+    // its own probes only, the same as the next lookup.
+    cf_shutdown();
+    cf_stats_reset();
+    TEST_ASSERT( cf_find_type_by_name( "int32_t" ) == &cf_type_i32 );
+    cf_stats_snapshot( &stats );
+    uint64_t first_probes = stats.lookups[ CF_STAT_TYPE_BY_NAME ].probes;
+    cf_stats_reset();
+    TEST_ASSERT( cf_find_type_by_name( "int32_t" ) == &cf_type_i32 );
+    cf_stats_snapshot( &stats );
+    TEST_ASSERT( first_probes == stats.lookups[ CF_STAT_TYPE_BY_NAME ].probes );
+#    if !defined( CFLEX_LINKER_SECTIONS )
+    cflex_unit_register_types();
+#    endif
+#else
+    for ( int32_t i = 0; i < CF_STAT_LOOKUP_COUNT; ++i ) { TEST_ASSERT( stats.lookups[ i ].calls == 0 ); }
+#endif
+
+    return 0;
+}
+
+// A struct with padding and a string. cflex_build cannot parse `const char*` fields, so it
+// is described by hand.
+typedef struct test_record_t
+{
+    uint8_t     tag;
+    int32_t     count;
+    const char* label;
+    double      weight;
+} test_record_t;
+
+static const cf_field_t record_fields[] = {
+    { "tag", &cf_type_u8, offsetof( test_record_t, tag ), 0, 0 },
+    { "count", &cf_type_i32, offsetof( test_record_t, count ), 0, 0 },
+    { "label", &cf_type_cstr, offsetof( test_record_t, label ), 0, 0 },
+    { "weight", &cf_type_f64, offsetof( test_record_t, weight ), 0, 0 } };
+static cf_type_state_t  record_state    = { .index = -1 };
+static const cf_type_t  record_type     = { .name         = "test_record_t",
+                                            .kind         = CF_KIND_STRUCT,
+                                            .size         = sizeof( test_record_t ),
+                                            .align        = _Alignof( test_record_t ),
+                                            .state        = &record_state,
+                                            .struct_array = record_fields,
+                                            .struct_count = 4 };
+
+int
+test_serialize()
+{
+    // No padding and no strings: the plan is a single copy.
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    test_struct_t structs[ 3 ] = { { 1, { 1.0f, 2.0f }, TEST_ENUM_A },
+                                   { 2, { 3.0f, 4.0f }, TEST_ENUM_B },
+                                   { 3, { 5.0f, 6.0f }, TEST_ENUM_C } };
+    uint8_t       buffer[ 256 ];
+    size_t        size = cf_serialize( struct_type, structs, 3, buffer, sizeof( buffer ) );
+    TEST_ASSERT( size == 3 * sizeof( test_struct_t ) );
+    TEST_ASSERT( cf_serialize( struct_type, structs, 3, NULL, 0 ) == size );
+    TEST_ASSERT( cf_serialize( struct_type, structs, 3, buffer, size - 1 ) == 0 );
+
+    test_struct_t copies[ 3 ];
+    TEST_ASSERT( cf_deserialize( struct_type, copies, 3, buffer, size ) == size );
+    TEST_ASSERT( memcmp( copies, structs, sizeof( structs ) ) == 0 );
+
+    // Padding is skipped and strings are length-prefixed.
+    test_record_t records[ 2 ] = { { 7, -3, "seven", 0.5 }, { 9, 12, NULL, 2.0 } };
+    size                       = cf_serialize( &record_type, records, 2, buffer, sizeof( buffer ) );
+    TEST_ASSERT( size == ( 1 + 4 + 4 + 6 + 8 ) + ( 1 + 4 + 4 + 8 ) );
+    TEST_ASSERT( cf_serialize( &record_type, records, 2, NULL, 0 ) == size );
+    TEST_ASSERT( cf_serialize( &record_type, records, 2, buffer, size - 1 ) == 0 );
+
+    test_record_t read[ 2 ];
+    memset( read, 0, sizeof( read ) );
+    TEST_ASSERT( cf_deserialize( &record_type, read, 2, buffer, size ) == size );
+    TEST_ASSERT( read[ 0 ].tag == 7 && read[ 0 ].count == -3 && read[ 0 ].weight == 0.5 );
+    TEST_ASSERT( strcmp( read[ 0 ].label, "seven" ) == 0 );
+    TEST_ASSERT( read[ 0 ].label >= (const char*)buffer && read[ 0 ].label < (const char*)buffer + size );
+    TEST_ASSERT( read[ 1 ].tag == 9 && read[ 1 ].label == NULL && read[ 1 ].weight == 2.0 );
+    TEST_ASSERT( cf_deserialize( &record_type, read, 2, buffer, size - 1 ) == 0 );
+
+    // Arrays of primitives.
+    int32_t values[ 4 ] = { 1, 2, 3, 4 };
+    TEST_ASSERT( cf_serialize( &cf_type_i32, values, 4, buffer, sizeof( buffer ) ) == sizeof( values ) );
+    TEST_ASSERT( cf_serialize( &cf_type_void, values, 4, buffer, sizeof( buffer ) ) == 0 );
+
+    return 0;
+}
+
+int
+test_codegen()
+{
+    // CF_STRUCT( codegen ): the generic calls dispatch to the generated functions.
+    const cf_type_t* type = cf_find_type_by_name( "test_message_t" );
+    TEST_ASSERT( type != NULL );
+    TEST_ASSERT( type->struct_funcs != NULL );
+
+    // The same struct without generated functions (or state) goes through a copy plan.
+    const cf_type_t generic = { .name         = type->name,
+                                .kind         = CF_KIND_STRUCT,
+                                .size         = type->size,
+                                .align        = type->align,
+                                .struct_array = type->struct_array,
+                                .struct_count = type->struct_count };
+
+    test_message_t messages[ 2 ];
+    memset( messages, 0, sizeof( messages ) );
+    messages[ 0 ] = ( test_message_t ){ 3, { 1.5f, -2.0f }, 1234567890123ll, TEST_ENUM_B };
+    messages[ 1 ] = ( test_message_t ){ 4, { 0.0f, 8.0f }, -1, TEST_ENUM_C };
+
+    uint8_t expected[ 128 ];
+    uint8_t buffer[ 128 ];
+    size_t  size = cf_serialize( &generic, messages, 2, expected, sizeof( expected ) );
+    TEST_ASSERT( size == 2 * ( 1 + 8 + 8 + sizeof( test_enum_t ) ) );
+    TEST_ASSERT( cf_serialize( type, messages, 2, buffer, sizeof( buffer ) ) == size );
+    TEST_ASSERT( memcmp( buffer, expected, size ) == 0 );
+    TEST_ASSERT( cf_serialize( type, messages, 2, NULL, 0 ) == size );
+    TEST_ASSERT( cf_serialize( type, messages, 2, buffer, size - 1 ) == 0 );
+    TEST_ASSERT( test_message_t_write( &messages[ 1 ], NULL, 0 ) == size / 2 );
+
+    // Padding is not read, so the copies compare and hash equal to the originals.
+    test_message_t copies[ 2 ];
+    memset( copies, 0xcd, sizeof( copies ) );
+    TEST_ASSERT( cf_deserialize( type, copies, 2, expected, size - 1 ) == 0 );
+    TEST_ASSERT( cf_deserialize( type, copies, 2, expected, size ) == size );
+    TEST_ASSERT( cf_objects_equal( type, &copies[ 0 ], &messages[ 0 ] ) );
+    TEST_ASSERT( cf_objects_equal( &generic, &copies[ 1 ], &messages[ 1 ] ) );
+    TEST_ASSERT( !cf_objects_equal( type, &copies[ 0 ], &messages[ 1 ] ) );
+    TEST_ASSERT( !cf_objects_equal( &generic, &copies[ 0 ], &messages[ 1 ] ) );
+    TEST_ASSERT( test_message_t_equal( &copies[ 1 ], &messages[ 1 ] ) );
+
+    // Both paths hash alike.
+    TEST_ASSERT( cf_hash_object( type, &copies[ 0 ] ) == cf_hash_object( &generic, &messages[ 0 ] ) );
+    TEST_ASSERT( test_message_t_hash( &messages[ 1 ] ) == cf_hash_object( &generic, &copies[ 1 ] ) );
+    TEST_ASSERT( cf_hash_object( type, &messages[ 0 ] ) != cf_hash_object( type, &messages[ 1 ] ) );
+
+    // Strings hash and compare by content.
+    char        text[] = "message";
+    const char* str_a  = "message";
+    const char* str_b  = text;
+    const char* str_c  = NULL;
+    TEST_ASSERT( cf_objects_equal( &cf_type_cstr, &str_a, &str_b ) );
+    TEST_ASSERT( !cf_objects_equal( &cf_type_cstr, &str_a, &str_c ) );
+    TEST_ASSERT( cf_hash_object( &cf_type_cstr, &str_a ) == cf_hash_object( &cf_type_cstr, &str_b ) );
+    TEST_ASSERT( cf_hash_object( &cf_type_cstr, &str_a ) != cf_hash_object( &cf_type_cstr, &str_c ) );
+
+    return 0;
+}
+
+// Collects flushed JSON text for test_json().
+typedef struct test_json_sink_t
+{
+    char   text[ 512 ];
+    size_t size;
+    int    flushes;
+} test_json_sink_t;
+
+static bool
+test_json_flush( void* user, const char* data, size_t size )
+{
+    test_json_sink_t* sink = (test_json_sink_t*)user;
+    if ( sink->size + size > sizeof( sink->text ) )
+    {
+        return false;
+    }
+    memcpy( sink->text + sink->size, data, size );
+    sink->size += size;
+    sink->flushes++;
+    return true;
+}
+
+int
+test_json()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    test_struct_t structs[ 2 ] = { { 1, { 1.0f, -2.5f }, TEST_ENUM_A },
+                                   { -7, { 0.1f, 3e9f }, (test_enum_t)9 } };
+
+    // Fields in declaration order, enums by name or number, short decimals as such, no whitespace.
+    static const char expected[] =
+        "[{\"a\":1,\"v\":{\"x\":1,\"y\":-2.5},\"e\":\"TEST_ENUM_A\"},"
+        "{\"a\":-7,\"v\":{\"x\":0.1,\"y\":3000000000},\"e\":9}]";
+    char             text[ 512 ];
+    cf_json_writer_t writer;
+    cf_json_writer_init( &writer, text, sizeof( text ), NULL, NULL );
+    TEST_ASSERT( cf_json_write_array( &writer, struct_type, structs, 2 ) );
+    TEST_ASSERT( writer.used == sizeof( expected ) - 1 && writer.total == writer.used );
+    TEST_ASSERT( memcmp( text, expected, writer.used ) == 0 );
+
+    // Without a flush callback the text must fit.
+    cf_json_writer_t small;
+    cf_json_writer_init( &small, text, 16, NULL, NULL );
+    TEST_ASSERT( !cf_json_write_array( &small, struct_type, structs, 2 ) );
+    TEST_ASSERT( small.failed );
+
+    // With one, a tiny buffer streams the same text.
+    test_json_sink_t sink = { { 0 }, 0, 0 };
+    char             chunk[ 8 ];
+    cf_json_writer_init( &small, chunk, sizeof( chunk ), test_json_flush, &sink );
+    TEST_ASSERT( cf_json_write_array( &small, struct_type, structs, 2 ) );
+    TEST_ASSERT( cf_json_writer_flush( &small ) );
+    TEST_ASSERT( sink.size == sizeof( expected ) - 1 && small.total == sink.size && sink.flushes > 10 );
+    TEST_ASSERT( memcmp( sink.text, expected, sink.size ) == 0 );
+
+    // Round trip, and whitespace, field order and unknown fields do not matter.
+    test_struct_t read[ 3 ];
+    memset( read, 0, sizeof( read ) );
+    cf_json_reader_t reader;
+    cf_json_reader_init( &reader, expected, sizeof( expected ) - 1, NULL, 0 );
+    TEST_ASSERT( cf_json_read_array( &reader, struct_type, read, 3 ) == 2 );
+    TEST_ASSERT( reader.pos == reader.length && reader.error == NULL );
+    TEST_ASSERT( memcmp( read, structs, sizeof( structs ) ) == 0 );
+
+    static const char spaced[] =
+        " \n\t{ \"e\" : 2 , \"extra\": [ {\"k\": [1, 2.5e-3, \"\\\"\"]}, null, true ],\n"
+        "                                   \"v\" : { \"y\" : 4E2 }, \"a\" : -12345678901 }";
+    cf_json_reader_init( &reader, spaced, sizeof( spaced ) - 1, NULL, 0 );
+    TEST_ASSERT( !cf_json_read( &reader, struct_type, &read[ 0 ] ) );
+    TEST_ASSERT( reader.error != NULL && strncmp( spaced + reader.pos, "-12345678901", 12 ) == 0 );
+
+    test_struct_t     target = { 5, { 6.0f, 7.0f }, TEST_ENUM_A };
+    static const char ok[] =
+        " { \"e\" : \"TEST_ENUM_C\" , \"extra\": [ {\"k\": [1, 2.5e-3, \"\\\"\"]}, null, true ],\n"
+        "                                     \"v\" : { \"y\" : 4E2 }, \"a\" : -123456789 } ";
+    cf_json_reader_init( &reader, ok, sizeof( ok ) - 1, NULL, 0 );
+    TEST_ASSERT( cf_json_read( &reader, struct_type, &target ) );
+    TEST_ASSERT( reader.pos == reader.length );
+    TEST_ASSERT( target.a == -123456789 && target.v.x == 6.0f && target.v.y == 400.0f &&
+                 target.e == TEST_ENUM_C );
+
+    // Errors stop at the offending character.
+    static const char* const bad[] = {
+        "{\"a\":1",  "{\"e\":\"TEST_ENUM_D\"}", "{\"a\":2147483648}", "{\"a\":1.5}", "{\"v\":[]}",
+        "{\"a\" 1}", "[{}, {}, {}, {}]" };
+    for ( int32_t i = 0; i < (int32_t)( sizeof( bad ) / sizeof( bad[ 0 ] ) ); ++i )
+    {
+        cf_json_reader_init( &reader, bad[ i ], strlen( bad[ i ] ), NULL, 0 );
+        bool ok_read = bad[ i ][ 0 ] == '[' ? cf_json_read_array( &reader, struct_type, read, 3 ) >= 0
+                                            : cf_json_read( &reader, struct_type, &target );
+        TEST_ASSERT( !ok_read && reader.error != NULL );
+    }
+
+    // Strings are escaped on the way out and decoded into the reader's storage.
+    test_record_t records[ 2 ] = {
+        { 255, INT32_MIN, "tab\there \"quoted\" \x01 a long run without escapes", 1.0 / 3.0 },
+        { 0, 0, NULL, -0.0 } };
+    static const char record_text[] =
+        "[{\"tag\":255,\"count\":-2147483648,\"label\":\"tab\\there \\\"quoted\\\" \\u0001 a long run without escapes\","
+        "\"weight\":0.33333333333333331},{\"tag\":0,\"count\":0,\"label\":null,\"weight\":-0}]";
+    cf_json_writer_init( &writer, text, sizeof( text ), NULL, NULL );
+    TEST_ASSERT( cf_json_write_array( &writer, &record_type, records, 2 ) );
+    TEST_ASSERT( writer.used == sizeof( record_text ) - 1 && memcmp( text, record_text, writer.used ) == 0 );
+
+    char          strings[ 64 ];
+    test_record_t read_records[ 2 ];
+    memset( read_records, 0, sizeof( read_records ) );
+    cf_json_reader_init( &reader, text, writer.used, strings, sizeof( strings ) );
+    TEST_ASSERT( cf_json_read_array( &reader, &record_type, read_records, 2 ) == 2 );
+    TEST_ASSERT( cf_objects_equal( &record_type, &read_records[ 0 ], &records[ 0 ] ) );
+    TEST_ASSERT( cf_objects_equal( &record_type, &read_records[ 1 ], &records[ 1 ] ) );
+    TEST_ASSERT( read_records[ 0 ].label == strings );
+
+    static const char unicode[] = "{\"label\":\"\\u00e9\\u20ac\\ud83d\\ude00\\/\"}";
+    cf_json_reader_init( &reader, unicode, sizeof( unicode ) - 1, strings, sizeof( strings ) );
+    TEST_ASSERT( cf_json_read( &reader, &record_type, &read_records[ 0 ] ) );
+    TEST_ASSERT( strcmp( read_records[ 0 ].label, "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80/" ) == 0 );
+
+    // Running out of string storage is an error.
+    cf_json_reader_init( &reader, text, writer.used, strings, 8 );
+    TEST_ASSERT( cf_json_read_array( &reader, &record_type, read_records, 2 ) == -1 );
+    TEST_ASSERT( reader.error != NULL );
+
+    // Numbers keep '.' under a comma-decimal LC_NUMERIC, both on the way out and through
+    // strtod() on the way in. Skipped where no such locale is installed.
+    static const char* const comma_locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8",
+                                                 "German_Germany.1252" };
+    char                     previous[ 64 ];
+    snprintf( previous, sizeof( previous ), "%s", setlocale( LC_NUMERIC, NULL ) );
+    bool comma = false;
+    for ( int32_t i = 0; i < (int32_t)( sizeof( comma_locales ) / sizeof( comma_locales[ 0 ] ) ) && !comma;
+          ++i )
+    {
+        comma = setlocale( LC_NUMERIC, comma_locales[ i ] ) && localeconv()->decimal_point[ 0 ] == ',';
+    }
+    if ( comma )
+    {
+        memset( read_records, 0, sizeof( read_records ) );
+        cf_json_writer_init( &writer, text, sizeof( text ), NULL, NULL );
+        bool written = cf_json_write_array( &writer, &record_type, records, 2 ) &&
+                       writer.used == sizeof( record_text ) - 1 &&
+                       memcmp( text, record_text, writer.used ) == 0;
+        cf_json_reader_init( &reader, record_text, sizeof( record_text ) - 1, strings, sizeof( strings ) );
+        bool read_back = cf_json_read_array( &reader, &record_type, read_records, 2 ) == 2;
+        setlocale( LC_NUMERIC, previous );
+        TEST_ASSERT( written && read_back );
+        TEST_ASSERT( read_records[ 0 ].weight == records[ 0 ].weight );
+    }
+    setlocale( LC_NUMERIC, previous );
+
+    return 0;
+}
+
+int
+test_image()
+{
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    test_struct_t      structs[ 3 ] = { { 1, { 1.0f, 2.0f }, TEST_ENUM_A },
+                                        { 2, { 3.0f, 4.0f }, TEST_ENUM_B },
+                                        { 3, { 5.0f, 6.0f }, TEST_ENUM_C } };
+    test_record_t      records[ 2 ] = { { 7, -3, "seven", 0.5 }, { 9, 12, NULL, 2.0 } };
+    int32_t            values[ 4 ]  = { 10, 20, 30, 40 };
+    cf_image_section_t sections[]   = {
+          { struct_type, structs, 3 }, { &record_type, records, 2 }, { &cf_type_i32, values, 4 } };
+
+    _Alignas( 64 ) static uint8_t buffer[ 4096 ];
+    _Alignas( 64 ) static uint8_t moved[ 4096 ];
+    memset( buffer, 0xcd, sizeof( buffer ) );
+    size_t size = cf_image_write( sections, 3, NULL, 0 );
+    TEST_ASSERT( size > 0 && size <= sizeof( buffer ) );
+    TEST_ASSERT( cf_image_write( sections, 3, buffer, size - 1 ) == 0 );
+    TEST_ASSERT( cf_image_write( sections, 3, buffer, size ) == size );
+    memcpy( moved, buffer, size );
+
+    // Sections are used in place, at 64-byte boundaries.
+    cf_image_t image;
+    TEST_ASSERT( cf_image_open( &image, buffer, size ) );
+    TEST_ASSERT( image.num_sections == 3 );
+    TEST_ASSERT( cf_image_find_section( &image, struct_type ) == 0 );
+    TEST_ASSERT( cf_image_find_section( &image, &cf_type_i32 ) == 2 );
+    TEST_ASSERT( cf_image_find_section( &image, cf_find_type_by_name( "test_vec2_t" ) ) == -1 );
+
+    int32_t              count;
+    const test_struct_t* mapped =
+        (const test_struct_t*)cf_image_get_section( &image, 0, struct_type, &count );
+    TEST_ASSERT( mapped != NULL && count == 3 );
+    TEST_ASSERT( (const uint8_t*)mapped > buffer && (const uint8_t*)mapped < buffer + size );
+    TEST_ASSERT( (uintptr_t)mapped % 64 == 0 );
+    TEST_ASSERT( memcmp( mapped, structs, sizeof( structs ) ) == 0 );
+    const int32_t* mapped_values = (const int32_t*)cf_image_get_section( &image, 2, &cf_type_i32, &count );
+    TEST_ASSERT( mapped_values != NULL && count == 4 && mapped_values[ 3 ] == 40 );
+
+    // Strings point into the image; padding is zeroed.
+    const test_record_t* mapped_records =
+        (const test_record_t*)cf_image_get_section( &image, 1, &record_type, &count );
+    TEST_ASSERT( mapped_records != NULL && count == 2 );
+    TEST_ASSERT( cf_objects_equal( &record_type, &mapped_records[ 0 ], &records[ 0 ] ) );
+    TEST_ASSERT( cf_objects_equal( &record_type, &mapped_records[ 1 ], &records[ 1 ] ) );
+    TEST_ASSERT( mapped_records[ 0 ].label > (const char*)buffer &&
+                 mapped_records[ 0 ].label < (const char*)buffer + size );
+    TEST_ASSERT( ( (const uint8_t*)&mapped_records[ 0 ] )[ 1 ] == 0 &&
+                 ( (const uint8_t*)&mapped_records[ 0 ] )[ 3 ] == 0 );
+
+    // Opening the same memory again keeps the pointers.
+    TEST_ASSERT( cf_image_open( &image, buffer, size ) );
+    mapped_records = (const test_record_t*)cf_image_get_section( &image, 1, &record_type, &count );
+    TEST_ASSERT( mapped_records != NULL && strcmp( mapped_records[ 0 ].label, "seven" ) == 0 );
+
+    // The type of each section must have the layout it was written with.
+    static const cf_field_t renamed_fields[] = {
+        { "tag", &cf_type_u8, offsetof( test_record_t, tag ), 0, 0 },
+        { "total", &cf_type_i32, offsetof( test_record_t, count ), 0, 0 },
+        { "label", &cf_type_cstr, offsetof( test_record_t, label ), 0, 0 },
+        { "weight", &cf_type_f64, offsetof( test_record_t, weight ), 0, 0 } };
+    const cf_type_t renamed_type = { .name         = "test_record_t",
+                                     .kind         = CF_KIND_STRUCT,
+                                     .size         = sizeof( test_record_t ),
+                                     .align        = _Alignof( test_record_t ),
+                                     .struct_array = renamed_fields,
+                                     .struct_count = 4 };
+    TEST_ASSERT( cf_image_get_section( &image, 1, &renamed_type, &count ) == NULL && count == 0 );
+    TEST_ASSERT( cf_image_get_section( &image, 0, &cf_type_i32, &count ) == NULL );
+    TEST_ASSERT( cf_image_get_section( &image, 3, &cf_type_i32, &count ) == NULL );
+
+    // A copy of the unopened image opens anywhere; a truncated or corrupted one does not.
+    TEST_ASSERT( !cf_image_open( &image, moved, size - 1 ) );
+    moved[ 0 ] = 'X';
+    TEST_ASSERT( !cf_image_open( &image, moved, size ) );
+    moved[ 0 ] = buffer[ 0 ];
+    TEST_ASSERT( cf_image_open( &image, moved, size ) );
+    mapped_records = (const test_record_t*)cf_image_get_section( &image, 1, &record_type, &count );
+    TEST_ASSERT( mapped_records != NULL && mapped_records[ 0 ].label > (const char*)moved );
+    TEST_ASSERT( strcmp( mapped_records[ 0 ].label, "seven" ) == 0 && mapped_records[ 1 ].label == NULL );
+
+    // An opened image is tied to its address.
+    memcpy( moved, buffer, size );
+    TEST_ASSERT( !cf_image_open( &image, moved, size ) );
+
+    // Hand-built types without IDs are told apart by name, even with the same layout. The
+    // last leaf is smaller than a pointer and ends the objects, which live on the heap.
+    typedef struct
+    {
+        const char* s;
+        int8_t      a;
+        int32_t     b;
+    } padded_t;
+    static const cf_field_t padded_fields[] = { { "s", &cf_type_cstr, offsetof( padded_t, s ), 0, 0 },
+                                                { "a", &cf_type_i8, offsetof( padded_t, a ), 0, 0 },
+                                                { "b", &cf_type_i32, offsetof( padded_t, b ), 0, 0 } };
+    const cf_type_t         padded_type     = { .name         = "padded_t",
+                                                .kind         = CF_KIND_STRUCT,
+                                                .size         = sizeof( padded_t ),
+                                                .align        = _Alignof( padded_t ),
+                                                .struct_array = padded_fields,
+                                                .struct_count = 3 };
+    const cf_type_t         other_type      = { .name         = "other_t",
+                                                .kind         = CF_KIND_STRUCT,
+                                                .size         = sizeof( padded_t ),
+                                                .align        = _Alignof( padded_t ),
+                                                .struct_array = padded_fields,
+                                                .struct_count = 3 };
+    padded_t*               padded          = malloc( 2 * sizeof( padded_t ) );
+    padded_t*               other           = malloc( sizeof( padded_t ) );
+    TEST_ASSERT( padded != NULL && other != NULL );
+    padded[ 0 ]                          = ( padded_t ){ "first", 1, 2 };
+    padded[ 1 ]                          = ( padded_t ){ NULL, -3, 4 };
+    other[ 0 ]                           = ( padded_t ){ "other", 5, 6 };
+
+    cf_image_section_t padded_sections[] = { { &padded_type, padded, 2 }, { &other_type, other, 1 } };
+    size                                 = cf_image_write( padded_sections, 2, NULL, 0 );
+    bool written                         = size > 0 && size <= sizeof( buffer ) &&
+                   cf_image_write( padded_sections, 2, buffer, sizeof( buffer ) ) == size;
+    free( padded );
+    free( other );
+    TEST_ASSERT( written && cf_image_open( &image, buffer, size ) );
+    TEST_ASSERT( cf_image_find_section( &image, &padded_type ) == 0 );
+    TEST_ASSERT( cf_image_find_section( &image, &other_type ) == 1 );
+    TEST_ASSERT( cf_image_get_section( &image, 0, &other_type, &count ) == NULL );
+    TEST_ASSERT( cf_image_get_section( &image, 1, &padded_type, &count ) == NULL );
+    const padded_t* mapped_padded = (const padded_t*)cf_image_get_section( &image, 0, &padded_type, &count );
+    TEST_ASSERT( mapped_padded != NULL && count == 2 && strcmp( mapped_padded[ 0 ].s, "first" ) == 0 );
+    TEST_ASSERT( mapped_padded[ 1 ].s == NULL && mapped_padded[ 1 ].a == -3 && mapped_padded[ 1 ].b == 4 );
+    const padded_t* mapped_other = (const padded_t*)cf_image_get_section( &image, 1, &other_type, &count );
+    TEST_ASSERT( mapped_other != NULL && count == 1 && strcmp( mapped_other[ 0 ].s, "other" ) == 0 );
+
+    return 0;
+}
+
+// An older test_record_t: fields reordered, narrower, one removed, no label.
+typedef struct test_record_v1_t
+{
+    int16_t count;
+    uint8_t tag;
+    float   weight;
+    int32_t removed;
+} test_record_v1_t;
+
+int
+test_migration()
+{
+    // Fingerprints follow the layout, not the descriptor: stripped names hash alike.
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    const cf_type_t generic = { .name         = struct_type->name,
+                                .kind         = CF_KIND_STRUCT,
+                                .size         = struct_type->size,
+                                .align        = struct_type->align,
+                                .struct_array = struct_type->struct_array,
+                                .struct_count = struct_type->struct_count };
+    TEST_ASSERT( cf_get_fingerprint( struct_type ) != 0 );
+    TEST_ASSERT( cf_get_fingerprint( struct_type ) == cf_get_fingerprint( &generic ) );
+    TEST_ASSERT( cf_get_fingerprint( struct_type ) !=
+                 cf_get_fingerprint( cf_find_type_by_name( "test_vec2_t" ) ) );
+    TEST_ASSERT( cf_get_fingerprint( &cf_type_i32 ) != cf_get_fingerprint( &cf_type_u32 ) );
+    TEST_ASSERT( cf_get_fingerprint( &cf_type_void ) == 0 );
+
+    static const cf_field_t stripped_fields[] = {
+        { NULL, &cf_type_u8, offsetof( test_record_t, tag ), 0, 0x56d7ab194448a4f3ull },        // "tag"
+        { NULL, &cf_type_i32, offsetof( test_record_t, count ), 0, 0xb1e5e28e4479a274ull },     // "count"
+        { NULL, &cf_type_cstr, offsetof( test_record_t, label ), 0, 0x39f7fcec8fcb623dull },    // "label"
+        { NULL, &cf_type_f64, offsetof( test_record_t, weight ), 0, 0x6911f8de1f27bf19ull },    // "weight"
+    };
+    static const cf_type_t stripped_type = { .name         = NULL,
+                                             .kind         = CF_KIND_STRUCT,
+                                             .size         = sizeof( test_record_t ),
+                                             .align        = _Alignof( test_record_t ),
+                                             .struct_array = stripped_fields,
+                                             .struct_count = 4 };
+    TEST_ASSERT( cf_get_fingerprint( &stripped_type ) == cf_get_fingerprint( &record_type ) );
+
+    // Same fingerprint: a plain copy.
+    cf_migration_t* migration = cf_migration_compile( struct_type, &generic, NULL );
+    TEST_ASSERT( migration != NULL && cf_migration_is_copy( migration ) );
+    test_struct_t structs[ 2 ] = { { 1, { 1.0f, 2.0f }, TEST_ENUM_A }, { 2, { 3.0f, 4.0f }, TEST_ENUM_B } };
+    test_struct_t copies[ 2 ];
+    TEST_ASSERT( cf_migrate( migration, structs, copies, 2 ) );
+    TEST_ASSERT( memcmp( copies, structs, sizeof( structs ) ) == 0 );
+    cf_migration_free( migration );
+
+    // Fields matched by name: copied, widened or defaulted, over more than one block.
+    static const cf_field_t v1_fields[] = {
+        { "count", &cf_type_i16, offsetof( test_record_v1_t, count ), 0, 0 },
+        { "tag", &cf_type_u8, offsetof( test_record_v1_t, tag ), 0, 0 },
+        { "weight", &cf_type_f32, offsetof( test_record_v1_t, weight ), 0, 0 },
+        { "removed", &cf_type_i32, offsetof( test_record_v1_t, removed ), 0, 0 } };
+    const cf_type_t v1_type = { .name         = "test_record_t",
+                                .kind         = CF_KIND_STRUCT,
+                                .size         = sizeof( test_record_v1_t ),
+                                .align        = _Alignof( test_record_v1_t ),
+                                .struct_array = v1_fields,
+                                .struct_count = 4 };
+
+    enum
+    {
+        COUNT = 300
+    };
+    static test_record_v1_t old_records[ COUNT ];
+    static test_record_t    new_records[ COUNT ];
+    for ( int32_t i = 0; i < COUNT; ++i )
+    {
+        old_records[ i ] = ( test_record_v1_t ){ (int16_t)( -i ), (uint8_t)i, (float)i * 0.5f, 99 };
+    }
+    memset( new_records, 0xcd, sizeof( new_records ) );
+
+    test_record_t defaults = { 0, 0, "none", 0.0 };
+    migration              = cf_migration_compile( &v1_type, &record_type, &defaults );
+    TEST_ASSERT( migration != NULL && !cf_migration_is_copy( migration ) );
+    TEST_ASSERT( cf_migrate( migration, old_records, new_records, COUNT ) );
+    for ( int32_t i = 0; i < COUNT; ++i )
+    {
+        test_record_t expected = { (uint8_t)i, -i, "none", (double)i * 0.5 };
+        TEST_ASSERT( cf_objects_equal( &record_type, &new_records[ i ], &expected ) );
+    }
+    TEST_ASSERT( cf_migrate( migration, old_records, new_records, 0 ) );
+    TEST_ASSERT( !cf_migrate( migration, NULL, new_records, 1 ) );
+    cf_migration_free( migration );
+
+    // Narrowing is not a conversion: the new field keeps its default.
+    migration = cf_migration_compile( &record_type, &v1_type, NULL );
+    TEST_ASSERT( migration != NULL );
+    test_record_v1_t narrowed;
+    TEST_ASSERT( cf_migrate( migration, &new_records[ 5 ], &narrowed, 1 ) );
+    TEST_ASSERT( narrowed.tag == 5 && narrowed.count == 0 && narrowed.weight == 0.0f &&
+                 narrowed.removed == 0 );
+    cf_migration_free( migration );
+
+    TEST_ASSERT( cf_migration_compile( &cf_type_void, &record_type, NULL ) == NULL );
+
+    return 0;
+}
+
+int
+test_byte_order()
+{
+    // Each value is reversed by its own size, whatever the host's order.
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != NULL );
+    test_struct_t        value    = { 0x01020304, { 1.0f, -2.0f }, TEST_ENUM_C };
+    static const uint8_t big[]    = { 0x01, 0x02, 0x03, 0x04, 0x3f, 0x80, 0x00, 0x00,
+                                      0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02 };
+    static const uint8_t little[] = { 0x04, 0x03, 0x02, 0x01, 0x00, 0x00, 0x80, 0x3f,
+                                      0x00, 0x00, 0x00, 0xc0, 0x02, 0x00, 0x00, 0x00 };
+    uint8_t              buffer[ 1024 ];
+    TEST_ASSERT( cf_encode( struct_type, &value, 1, CF_BYTE_ORDER_BIG, buffer, sizeof( buffer ) ) ==
+                 sizeof( big ) );
+    TEST_ASSERT( memcmp( buffer, big, sizeof( big ) ) == 0 );
+    TEST_ASSERT( cf_encode( struct_type, &value, 1, CF_BYTE_ORDER_LITTLE, buffer, sizeof( buffer ) ) ==
+                 sizeof( little ) );
+    TEST_ASSERT( memcmp( buffer, little, sizeof( little ) ) == 0 );
+    TEST_ASSERT( cf_encode( struct_type, &value, 1, CF_BYTE_ORDER_BIG, NULL, 0 ) == sizeof( big ) );
+    TEST_ASSERT( cf_encode( struct_type, &value, 1, CF_BYTE_ORDER_BIG, buffer, sizeof( big ) - 1 ) == 0 );
+
+    test_struct_t decoded;
+    TEST_ASSERT( cf_decode( struct_type, &decoded, 1, CF_BYTE_ORDER_BIG, big, sizeof( big ) ) ==
+                 sizeof( big ) );
+    TEST_ASSERT( memcmp( &decoded, &value, sizeof( value ) ) == 0 );
+    TEST_ASSERT( cf_decode( struct_type, &decoded, 1, CF_BYTE_ORDER_LITTLE, little, sizeof( little ) ) ==
+                 sizeof( little ) );
+    TEST_ASSERT( memcmp( &decoded, &value, sizeof( value ) ) == 0 );
+    TEST_ASSERT( cf_decode( struct_type, &decoded, 1, CF_BYTE_ORDER_BIG, big, sizeof( big ) - 1 ) == 0 );
+
+    // Arrays round-trip, including the last objects, which are too close to the end for a
+    // whole shuffle window.
+    cf_byte_order_t foreign =
+        cf_host_byte_order() == CF_BYTE_ORDER_LITTLE ? CF_BYTE_ORDER_BIG : CF_BYTE_ORDER_LITTLE;
+    test_struct_t structs[ 37 ];
+    test_struct_t copies[ 37 ];
+    for ( int32_t i = 0; i < 37; ++i )
+    {
+        structs[ i ] = ( test_struct_t ){ i * 1000 + 1, { (float)i, -(float)i }, (test_enum_t)( i % 3 ) };
+    }
+    size_t size = cf_encode( struct_type, structs, 37, foreign, buffer, sizeof( buffer ) );
+    TEST_ASSERT( size == sizeof( structs ) );
+    TEST_ASSERT( memcmp( buffer, structs, size ) != 0 );
+    TEST_ASSERT( cf_decode( struct_type, copies, 37, foreign, buffer, size ) == size );
+    TEST_ASSERT( memcmp( copies, structs, sizeof( structs ) ) == 0 );
+
+    // In host order nothing is swapped.
+    TEST_ASSERT( cf_encode( struct_type, structs, 37, cf_host_byte_order(), buffer, sizeof( buffer ) ) ==
+                 size );
+    TEST_ASSERT( memcmp( buffer, structs, size ) == 0 );
+
+    // Padding is skipped and the string length prefixes are swapped too.
+    test_record_t        records[ 2 ] = { { 7, -3, "seven", 0.5 }, { 9, 12, NULL, 2.0 } };
+    static const uint8_t big_record[] = { 0x07, 0xff, 0xff, 0xff, 0xfd, 0x00, 0x00, 0x00,
+                                          0x05, 's',  'e',  'v',  'e',  'n',  0x00, 0x3f,
+                                          0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    size = cf_encode( &record_type, records, 2, CF_BYTE_ORDER_BIG, buffer, sizeof( buffer ) );
+    TEST_ASSERT( size == cf_serialize( &record_type, records, 2, NULL, 0 ) );
+    TEST_ASSERT( memcmp( buffer, big_record, sizeof( big_record ) ) == 0 );
+    TEST_ASSERT( memcmp( buffer + sizeof( big_record ) + 5, "\xff\xff\xff\xff", 4 ) == 0 );
+
+    test_record_t read[ 2 ];
+    TEST_ASSERT( cf_decode( &record_type, read, 2, CF_BYTE_ORDER_BIG, buffer, size ) == size );
+    TEST_ASSERT( cf_objects_equal( &record_type, &read[ 0 ], &records[ 0 ] ) );
+    TEST_ASSERT( cf_objects_equal( &record_type, &read[ 1 ], &records[ 1 ] ) );
+    TEST_ASSERT( read[ 0 ].label == (const char*)buffer + 9 );
+    TEST_ASSERT( cf_decode( &record_type, read, 2, CF_BYTE_ORDER_BIG, buffer, size - 1 ) == 0 );
+
+    // More leaves than shuffle windows: the rest are swapped one at a time.
+    enum
+    {
+        WIDE = 72
+    };
+    static cf_field_t wide_fields[ WIDE ];
+    double            values[ WIDE ];
+    double            wide_copies[ WIDE ];
+    for ( int32_t i = 0; i < WIDE; ++i )
+    {
+        cf_field_t field = { NULL, &cf_type_f64, i * (int32_t)sizeof( double ), 0, (uint64_t)i + 1 };
+        memcpy( &wide_fields[ i ], &field, sizeof( field ) );
+        values[ i ] = (double)i + 0.25;
+    }
+    const cf_type_t wide_type = { .name         = "wide_t",
+                                  .kind         = CF_KIND_STRUCT,
+                                  .size         = (int32_t)sizeof( values ),
+                                  .align        = _Alignof( double ),
+                                  .struct_array = wide_fields,
+                                  .struct_count = WIDE };
+    TEST_ASSERT( cf_encode( &wide_type, values, 1, CF_BYTE_ORDER_BIG, buffer, sizeof( buffer ) ) ==
+                 sizeof( values ) );
+    for ( int32_t i = 0; i < WIDE; ++i )
+    {
+        uint64_t bits;
+        memcpy( &bits, &values[ i ], sizeof( bits ) );
+        for ( int32_t k = 0; k < 8; ++k )
+        {
+            TEST_ASSERT( buffer[ i * 8 + k ] == (uint8_t)( bits >> ( 56 - 8 * k ) ) );
+        }
+    }
+    TEST_ASSERT( cf_decode( &wide_type, wide_copies, 1, CF_BYTE_ORDER_BIG, buffer, sizeof( values ) ) ==
+                 sizeof( values ) );
+    TEST_ASSERT( memcmp( wide_copies, values, sizeof( values ) ) == 0 );
+
+    return 0;
+}
+
+int
+test_packed_module()
+{
+    // A hand-written packed module: a struct of two int32_t fields and a sparse enum.
+    static const char              strings[] = "packed_point_t\0x\0y\0packed_mode_t\0MODE_A\0MODE_B\0";
+    static const uint16_t          lookup[]  = { 0 };
+    static const uint64_t          refs[]    = { CF_TYPE_ID_i32 };
+    static const cf_packed_field_t fields[]  = { { 15, 0, 0 }, { 17, 0, 4 } };
+    static const cf_packed_value_t values[]  = { { 33, 500 }, { 40, -7 } };
+    static const cf_packed_type_t  types[]   = {
+           { CF_KIND_STRUCT, 0, 4, 8, 0, 2, 0, CF_PACKED_NONE, 0 },
+           { CF_KIND_ENUM, 0, 4, 4, 0, 2, 19, CF_PACKED_NONE, 0 },
+    };
+    static const cf_packed_module_t module = { strings, lookup, types, fields, values, refs, NULL,
+                                               2,       2,      2,     NULL,   NULL,   NULL };
+
+    cf_register_packed_module( &module );
+
+    const cf_type_t* point_type = cf_find_type_by_name( "packed_point_t" );
+    TEST_ASSERT( point_type != NULL );
+    TEST_ASSERT( point_type->kind == CF_KIND_STRUCT );
+    TEST_ASSERT( point_type->size == 8 );
+    TEST_ASSERT( point_type->struct_count == 2 );
+    TEST_ASSERT( point_type->state->index >= 0 );
+
+    const cf_field_t* field_y = cf_find_field( point_type, "y" );
+    TEST_ASSERT( field_y != NULL );
+    TEST_ASSERT( field_y->offset == 4 );
+    TEST_ASSERT( field_y->type == cf_find_type_by_name( "int32_t" ) );
+
+    const cf_type_t* mode_type = cf_find_type_by_name( "packed_mode_t" );
+    TEST_ASSERT( mode_type != NULL );
+    TEST_ASSERT( mode_type->enum_range == 0 );
+    TEST_ASSERT( strcmp( cf_find_enum_value_by_value( mode_type, -7 )->name, "MODE_B" ) == 0 );
+    TEST_ASSERT( cf_find_enum_value_by_name( mode_type, "MODE_A" )->value == 500 );
+
+    // Descriptors survive unregistration, so type pointers stay stable.
+    cf_unregister_packed_module( &module );
+    TEST_ASSERT( cf_find_type_by_name( "packed_point_t" ) == NULL );
+    TEST_ASSERT( point_type->state->index == -1 );
+    cf_register_packed_module( &module );
+    TEST_ASSERT( cf_find_type_by_name( "packed_point_t" ) == point_type );
+    cf_unregister_packed_module( &module );
+
+    return 0;
+}
+
+int
+test_stripped_names()
+{
+    // Descriptors as cflex_build --strip-names emits them: no names, only hashes.
+    static const cf_field_t stripped_fields[] = {
+        { NULL, NULL, 0, 0, 0x08d94607b57949eeull },    // "sx"
+        { NULL, NULL, 4, 0, 0x08d94707b5794ba1ull },    // "sy"
+    };
+    static cf_type_state_t  stripped_state   = { .index = -1 };
+    static const cf_type_t  stripped_type    = { .name         = NULL,
+                                                 .kind         = CF_KIND_STRUCT,
+                                                 .size         = 8,
+                                                 .align        = 4,
+                                                 .id           = 0xa401af6f41bf7ad9ull,    // "stripped_t"
+                                                 .state        = &stripped_state,
+                                                 .struct_array = stripped_fields,
+                                                 .struct_count = 2 };
+    static const cf_type_t* stripped_table[] = { &stripped_type };
+
+    cf_register_type_table( stripped_table, 1 );
+    TEST_ASSERT( cf_find_type_by_name( "stripped_t" ) == &stripped_type );
+    TEST_ASSERT( cf_find_type_by_name_n( "stripped_t_x", 10 ) == &stripped_type );
+    TEST_ASSERT( cf_find_type_by_name( "stripped" ) == NULL );
+    TEST_ASSERT( cf_find_field( &stripped_type, "sy" ) == &stripped_fields[ 1 ] );
+    TEST_ASSERT( cf_find_field( &stripped_type, "sz" ) == NULL );
+    cf_unregister_type_table( stripped_table );
+
+    return 0;
+}
+
 int
 main()
 {
     cf_initialize();
-    cflex_unit_register_types();
+#if !defined( CFLEX_LINKER_SECTIONS )
+    cflex_unit_register_types();    // Otherwise found through the linker section on the first query
+#endif
 
     printf( "--- Running C-Flex Unit Tests ---\n" );
     RUN_TEST( test_find_type_by_name );
+    RUN_TEST( test_find_type_by_name_n );
+    RUN_TEST( test_type_ids );
     RUN_TEST( test_table_api );
     RUN_TEST( test_find_field );
+    RUN_TEST( test_find_field_all );
     RUN_TEST( test_find_enum_value );
+    RUN_TEST( test_find_enum_value_by_value );
+    RUN_TEST( test_enum_codecs );
+    RUN_TEST( test_unregister );
+    RUN_TEST( test_shared_types );
+    RUN_TEST( test_type_relations );
+    RUN_TEST( test_inheritance );
+    RUN_TEST( test_leaves );
+    RUN_TEST( test_leaves_unregister );
+    RUN_TEST( test_paths );
+    RUN_TEST( test_type_of );
+    RUN_TEST( test_field_lists );
+    RUN_TEST( test_stats );
+    RUN_TEST( test_serialize );
+    RUN_TEST( test_codegen );
+    RUN_TEST( test_json );
+    RUN_TEST( test_image );
+    RUN_TEST( test_migration );
+    RUN_TEST( test_byte_order );
+    RUN_TEST( test_packed_module );
+    RUN_TEST( test_stripped_names );
+#if defined( CFLEX_EMIT_CPP )
+    RUN_TEST( test_cpp_bindings );
+#endif
     printf( "---------------------------------\n" );
     printf( "All tests passed!\n" );
 
@@ -0,0 +1,71 @@
+// Built into cflex_unit when CFLEX_EMIT_CPP is ON: checks the generated C++ descriptors of
+// the unit types against the runtime ones. Compiled as C++17.
+
+#include "cflex_unit_generated.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+#define TEST_ASSERT( condition )                                                      \
+    do {                                                                              \
+        if ( !( condition ) )                                                         \
+        {                                                                             \
+            printf( "ASSERT FAILED: %s at %s:%d\n", #condition, __FILE__, __LINE__ ); \
+            return 1;                                                                 \
+        }                                                                             \
+    }                                                                                 \
+    while ( 0 )
+
+// The descriptors are constant expressions.
+static_assert( cf::type_desc<test_struct_t>::kind == CF_KIND_STRUCT, "struct kind" );
+static_assert( cf::type_desc<test_struct_t>::size == sizeof( test_struct_t ), "struct size" );
+static_assert( cf::type_desc<test_struct_t>::id == CF_TYPE_ID_test_struct_t, "struct id" );
+static_assert( cf::type_desc<test_struct_t>::field_count == 3, "struct fields" );
+static_assert( std::is_void<cf::type_desc<test_base_t>::parent>::value, "root has no parent" );
+static_assert( std::is_same<cf::type_desc<test_leaf_t>::parent, test_derived_t>::value,
+               "CF_FIELD( base ) parent" );
+static_assert( cf::type_desc<test_enum_t>::kind == CF_KIND_ENUM, "enum kind" );
+static_assert( cf::type_desc<test_enum_t>::value_count == 3, "enum values" );
+static_assert( cf::type_desc<int32_t>::id == CF_TYPE_ID_i32, "primitive id" );
+
+extern "C" int
+test_cpp_bindings( void )
+{
+    // type_of() reaches the descriptors the C lookups return.
+    const cf_type_t* struct_type = cf_find_type_by_name( "test_struct_t" );
+    TEST_ASSERT( struct_type != nullptr );
+    TEST_ASSERT( cf::type_of<test_struct_t>() == struct_type );
+    TEST_ASSERT( cf::type_of<const test_struct_t>() == struct_type );
+    TEST_ASSERT( cf::type_of<test_enum_t>() == cf_find_type_by_name( "test_enum_t" ) );
+    TEST_ASSERT( cf::type_of<float>() == &cf_type_f32 );
+    TEST_ASSERT( std::strcmp( cf::type_desc<test_struct_t>::name, struct_type->name ) == 0 );
+
+    // Each field matches its runtime field: name, offset and type.
+    test_struct_t object   = { 7, { 1.5f, -2.0f }, TEST_ENUM_B };
+    int32_t       visited  = 0;
+    bool          matching = true;
+    cf::for_each_field( object, [ & ]( const auto& field, auto& value ) {
+        using member_type        = typename std::decay_t<decltype( field )>::member_type;
+        const cf_field_t* expect = &struct_type->struct_array[ field.index ];
+        int32_t           offset = (int32_t)( (const char*)&value - (const char*)&object );
+        bool              same   = field.index == visited++ && offset == expect->offset;
+        same                     = same && cf::type_of<member_type>() == expect->type;
+        matching                 = matching && same && std::strcmp( field.name, expect->name ) == 0;
+    } );
+    TEST_ASSERT( visited == 3 && matching );
+
+    // Values are visited by reference.
+    test_vec2_t vec = { 1.5f, -2.0f };
+    cf::for_each_field( vec, []( const auto&, float& value ) { value *= 2.0f; } );
+    TEST_ASSERT( vec.x == 3.0f && vec.y == -4.0f );
+
+    // visit_fields() alone, on a derived struct: its parent is a field like any other.
+    int32_t parents = 0;
+    cf::type_desc<test_leaf_t>::visit_fields( [ & ]( const auto& field ) {
+        parents += std::is_same<typename std::decay_t<decltype( field )>::member_type, test_derived_t>::value;
+    } );
+    TEST_ASSERT( parents == 1 );
+
+    return 0;
+}
@@ -19,6 +19,25 @@ typedef enum test_enum_t
     TEST_ENUM_C
 } test_enum_t;
 
+// Dense with a hole at 1, and an alias of TEST_HOLES_C.
+CF_ENUM()
+typedef enum test_holes_t
+{
+    TEST_HOLES_A     = 0,
+    TEST_HOLES_C     = 2,
+    TEST_HOLES_D     = 3,
+    TEST_HOLES_ALIAS = 2
+} test_holes_t;
+
+// Values too spread out for a direct-index table.
+CF_ENUM()
+typedef enum test_sparse_t
+{
+    TEST_SPARSE_NEG = -100,
+    TEST_SPARSE_ONE = 1,
+    TEST_SPARSE_BIG = 100000
+} test_sparse_t;
+
 CF_STRUCT()
 typedef struct test_struct_t
 {
@@ -27,4 +46,35 @@ typedef struct test_struct_t
     CF_FIELD() test_enum_t e;
 } test_struct_t;
 
+// C-style inheritance: each struct embeds its parent as the first member.
+CF_STRUCT()
+typedef struct test_base_t
+{
+    CF_FIELD() int32_t id;
+} test_base_t;
+
+CF_STRUCT()
+typedef struct test_derived_t
+{
+    CF_FIELD( base ) test_base_t base;
+    CF_FIELD() float speed;
+} test_derived_t;
+
+CF_STRUCT()
+typedef struct test_leaf_t
+{
+    CF_FIELD( base ) test_derived_t base;
+    CF_FIELD() test_enum_t mode;
+} test_leaf_t;
+
+// Serialized, hashed and compared by generated functions. Padding follows `kind`.
+CF_STRUCT( codegen )
+typedef struct test_message_t
+{
+    CF_FIELD() uint8_t kind;
+    CF_FIELD() test_vec2_t position;
+    CF_FIELD() int64_t stamp;
+    CF_FIELD() test_enum_t mode;
+} test_message_t;
+
 #endif // CFLEX_UNIT_TYPES_H